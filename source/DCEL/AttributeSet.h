@@ -0,0 +1,347 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_AttributeSet_h
+#define DCEL_AttributeSet_h
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include "Exception.h"
+
+/**
+	The part of an AttributeChannel that doesn't depend on the type of its
+    values. Used by the AttributeSet to keep all channels with the same size.
+*/
+class AttributeChannelBase
+{
+public:
+
+    virtual ~AttributeChannelBase()
+    {
+    };
+
+    virtual void resize(size_t size) = 0;
+
+    virtual void reserve(size_t size) = 0;
+
+    /**
+    	Moves the value of each element i to the position newIds[i].
+    */
+    virtual void permute(const std::vector<unsigned int>& newIds) = 0;
+
+    virtual AttributeChannelBase* clone() const = 0;
+};
+
+/**
+	A named array of values, one for each vertex, half-edge or face of a Mesh.
+    The value of the element with ID=i is channel[i].
+
+    The values are stored in a contiguous buffer, apart from the elements, so
+    a pass that doesn't use an attribute never touches it.
+
+    There is no channel of bool: the std::vector<bool> packs its values in
+    bits, and can't return a bool& for operator[]. An unsigned char channel
+    does the same job.
+*/
+template<class T>
+class AttributeChannel: public AttributeChannelBase
+{
+public:
+
+    AttributeChannel(const T& defaultValue):
+        defaultValue(defaultValue)
+    {
+    };
+
+    inline T& operator[](unsigned int id)
+    {
+        return this->values[id];
+    };
+
+    inline const T& operator[](unsigned int id) const
+    {
+        return this->values[id];
+    };
+
+    inline unsigned int size() const
+    {
+        return this->values.size();
+    };
+
+    /**
+    	Returns the buffer with all values. It is reallocated when the mesh
+        grows.
+    */
+    inline std::vector<T>& getValues()
+    {
+        return this->values;
+    };
+
+    inline const std::vector<T>& getValues() const
+    {
+        return this->values;
+    };
+
+    /**
+    	The value given to the elements created after this channel.
+    */
+    inline const T& getDefaultValue() const
+    {
+        return this->defaultValue;
+    };
+
+    virtual void resize(size_t size)
+    {
+        this->values.resize( size, this->defaultValue );
+    };
+
+    virtual void reserve(size_t size)
+    {
+        this->values.reserve( size );
+    };
+
+    virtual void permute(const std::vector<unsigned int>& newIds)
+    {
+        std::vector<T> permuted( this->values.size(), this->defaultValue );
+        for( size_t i=0; i<this->values.size(); ++i )
+        {
+            permuted[ newIds[i] ] = this->values[i];
+        }
+        this->values.swap( permuted );
+    };
+
+    virtual AttributeChannelBase* clone() const
+    {
+        return new AttributeChannel<T>( *this );
+    };
+
+protected:
+private:
+    std::vector<T> values;
+    T defaultValue;
+};
+
+/**
+	Declared but not defined, so an AttributeChannel<bool> doesn't compile
+    (see AttributeChannel).
+*/
+template<>
+class AttributeChannel<bool>;
+
+/**
+	A set of attribute channels, all with the same number of values. The Mesh
+    has one set for its vertices, one for its half-edges and one for its
+    faces, and keeps each of them with one value per element.
+
+        AttributeChannel<float>& curvature = mesh.getVertexAttributes().add<float>( "curvature", 0.0f );
+        curvature[vertexId] = 1.0f;
+
+    The reference to a channel is valid until the channel is removed, but
+    the pointers to its values are not valid after the mesh grows.
+*/
+class AttributeSet
+{
+public:
+
+    AttributeSet():
+        count(0)
+    {
+    };
+
+    AttributeSet(const AttributeSet& other):
+        count(0)
+    {
+        *this = other;
+    };
+
+    ~AttributeSet()
+    {
+        this->removeAll();
+    };
+
+    AttributeSet& operator=(const AttributeSet& other)
+    {
+        if( this!=&other )
+        {
+            this->removeAll();
+            for( ChannelMap::const_iterator it=other.channels.begin(); it!=other.channels.end(); ++it )
+            {
+                this->channels[it->first] = it->second->clone();
+            }
+            this->count = other.count;
+        }
+        return *this;
+    };
+
+    /**
+    	Creates a new channel of values of type T, with one value for each
+        element (set to defaultValue).
+
+        Throws a cpp::Exception if there is already a channel with this name.
+    */
+    template<class T>
+    AttributeChannel<T>& add(const std::string& name, const T& defaultValue = T())
+    {
+        if( this->has(name) )
+        {
+            throw cpp::Exception("There is already an attribute named " + name);
+        }
+        AttributeChannel<T>* channel = new AttributeChannel<T>( defaultValue );
+        channel->resize( this->count );
+        this->channels[name] = channel;
+        return *channel;
+    };
+
+    /**
+    	Returns the channel with the given name.
+
+        Throws a cpp::Exception if there is no such channel, or if its values
+        are not of type T.
+    */
+    template<class T>
+    AttributeChannel<T>& get(const std::string& name)
+    {
+        return const_cast<AttributeChannel<T>&>( static_cast<const AttributeSet*>(this)->get<T>(name) );
+    };
+
+    template<class T>
+    const AttributeChannel<T>& get(const std::string& name) const
+    {
+        ChannelMap::const_iterator it = this->channels.find( name );
+        if( it==this->channels.end() )
+        {
+            throw cpp::Exception("There is no attribute named " + name);
+        }
+        const AttributeChannel<T>* channel = dynamic_cast<const AttributeChannel<T>*>( it->second );
+        if( channel==NULL )
+        {
+            throw cpp::Exception("The attribute " + name + " has another type");
+        }
+        return *channel;
+    };
+
+    inline bool has(const std::string& name) const
+    {
+        return this->channels.find( name )!=this->channels.end();
+    };
+
+    /**
+    	Releases the channel with the given name. Nothing happens if there
+        is no such channel.
+    */
+    void remove(const std::string& name)
+    {
+        ChannelMap::iterator it = this->channels.find( name );
+        if( it!=this->channels.end() )
+        {
+            delete it->second;
+            this->channels.erase( it );
+        }
+    };
+
+    /**
+    	Moves the channel with the given name from another set, with the same
+        size, to this one. A channel of this set with that name is replaced.
+
+        Throws a cpp::Exception if the other set has no such channel, or has
+        another size.
+    */
+    void moveFrom(AttributeSet& other, const std::string& name)
+    {
+        ChannelMap::iterator it = other.channels.find( name );
+        if( it==other.channels.end() )
+        {
+            throw cpp::Exception("There is no attribute named " + name);
+        }
+        if( other.count!=this->count )
+        {
+            throw cpp::Exception("The attribute " + name + " has another size");
+        }
+        this->remove( name );
+        this->channels[name] = it->second;
+        other.channels.erase( it );
+    };
+
+    /**
+    	Returns the names of all channels.
+    */
+    std::vector<std::string> getNames() const
+    {
+        std::vector<std::string> names;
+        for( ChannelMap::const_iterator it=this->channels.begin(); it!=this->channels.end(); ++it )
+        {
+            names.push_back( it->first );
+        }
+        return names;
+    };
+
+    /**
+    	Returns the number of values of each channel.
+    */
+    inline unsigned int size() const
+    {
+        return this->count;
+    };
+
+    /**
+    	Used by the Mesh to keep one value per element.
+    */
+    void resize(unsigned int size)
+    {
+        if( size!=this->count )
+        {
+            for( ChannelMap::iterator it=this->channels.begin(); it!=this->channels.end(); ++it )
+            {
+                it->second->resize( size );
+            }
+            this->count = size;
+        }
+    };
+
+    void reserve(unsigned int size)
+    {
+        for( ChannelMap::iterator it=this->channels.begin(); it!=this->channels.end(); ++it )
+        {
+            it->second->reserve( size );
+        }
+    };
+
+    /**
+    	Used by the Mesh when its elements are moved (see Mesh::permute).
+    */
+    void permute(const std::vector<unsigned int>& newIds)
+    {
+        for( ChannelMap::iterator it=this->channels.begin(); it!=this->channels.end(); ++it )
+        {
+            it->second->permute( newIds );
+        }
+    };
+
+protected:
+private:
+
+    typedef std::map<std::string, AttributeChannelBase*> ChannelMap;
+
+    void removeAll()
+    {
+        for( ChannelMap::iterator it=this->channels.begin(); it!=this->channels.end(); ++it )
+        {
+            delete it->second;
+        }
+        this->channels.clear();
+        this->count = 0;
+    };
+
+    ChannelMap channels;
+    unsigned int count;
+};
+
+#endif//DCEL_AttributeSet_h
@@ -0,0 +1,318 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_Circulators_h
+#define DCEL_Circulators_h
+
+#include <cstddef>
+#include <iterator>
+
+#include "MeshStorage.h"
+
+/**
+	The ways to go from a half-edge to the next one of a circulator. Each one
+    is a different type, so the step is chosen at compile time.
+*/
+class AroundVertexStep
+{
+public:
+
+    /**
+    	The next half-edge that leaves the same vertex.
+    */
+    template<class MeshT>
+    static inline unsigned int next(const MeshT& mesh, unsigned int halfEdgeId)
+    {
+        return mesh.getHalfEdgeNext( mesh.getHalfEdgeTwin(halfEdgeId) );
+    };
+};
+
+class AroundFaceStep
+{
+public:
+
+    /**
+    	The next half-edge of the same loop (a face, or a border).
+    */
+    template<class MeshT>
+    static inline unsigned int next(const MeshT& mesh, unsigned int halfEdgeId)
+    {
+        return mesh.getHalfEdgeNext( halfEdgeId );
+    };
+};
+
+/**
+	What a circulator returns for each half-edge. skip() tells if the
+    half-edge must be jumped over (only the faces skip the borders).
+*/
+class HalfEdgeValue
+{
+public:
+
+    template<class MeshT>
+    static inline unsigned int get(const MeshT&, unsigned int halfEdgeId)
+    {
+        return halfEdgeId;
+    };
+
+    template<class MeshT>
+    static inline bool skip(const MeshT&, unsigned int)
+    {
+        return false;
+    };
+};
+
+class OriginValue
+{
+public:
+
+    template<class MeshT>
+    static inline unsigned int get(const MeshT& mesh, unsigned int halfEdgeId)
+    {
+        return mesh.getHalfEdgeOrigin( halfEdgeId );
+    };
+
+    template<class MeshT>
+    static inline bool skip(const MeshT&, unsigned int)
+    {
+        return false;
+    };
+};
+
+class TargetValue
+{
+public:
+
+    template<class MeshT>
+    static inline unsigned int get(const MeshT& mesh, unsigned int halfEdgeId)
+    {
+        return mesh.getHalfEdgeOrigin( mesh.getHalfEdgeTwin(halfEdgeId) );
+    };
+
+    template<class MeshT>
+    static inline bool skip(const MeshT&, unsigned int)
+    {
+        return false;
+    };
+};
+
+class FaceValue
+{
+public:
+
+    template<class MeshT>
+    static inline unsigned int get(const MeshT& mesh, unsigned int halfEdgeId)
+    {
+        return mesh.getHalfEdgeFace( halfEdgeId );
+    };
+
+    template<class MeshT>
+    static inline bool skip(const MeshT& mesh, unsigned int halfEdgeId)
+    {
+        return mesh.getHalfEdgeFace( halfEdgeId )==MESH_NULL_ID;
+    };
+};
+
+/**
+	An iterator over a loop of half-edges, that starts (and ends) at a given
+    half-edge. StepT selects how the loop is walked, and ValueT what is
+    returned for each half-edge. It is used through a CirculatorRange.
+*/
+template<class MeshT, class StepT, class ValueT>
+class CirculatorIterator
+{
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef unsigned int value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const unsigned int* pointer;
+    typedef unsigned int reference;
+
+    /**
+    	An iterator at the end of any loop.
+    */
+    inline CirculatorIterator():
+        mesh(NULL),
+        startEdge(MESH_NULL_ID),
+        currentEdge(MESH_NULL_ID)
+    {
+    };
+
+    inline CirculatorIterator(const MeshT& mesh, unsigned int startEdge):
+        mesh(&mesh),
+        startEdge(startEdge),
+        currentEdge(startEdge)
+    {
+        if( this->currentEdge!=MESH_NULL_ID && ValueT::skip( mesh, this->currentEdge ) )
+        {
+            ++(*this);
+        }
+    };
+
+    inline unsigned int operator*() const
+    {
+        return ValueT::get( *this->mesh, this->currentEdge );
+    };
+
+    /**
+    	The half-edge where the iterator is, whatever it returns.
+    */
+    inline unsigned int getHalfEdge() const
+    {
+        return this->currentEdge;
+    };
+
+    inline CirculatorIterator& operator++()
+    {
+        do
+        {
+            this->currentEdge = StepT::next( *this->mesh, this->currentEdge );
+            if( this->currentEdge==this->startEdge )
+            {
+                this->currentEdge = MESH_NULL_ID;
+                break;
+            }
+        }
+        while( ValueT::skip( *this->mesh, this->currentEdge ) );
+        return *this;
+    };
+
+    inline CirculatorIterator operator++(int)
+    {
+        CirculatorIterator previous( *this );
+        ++(*this);
+        return previous;
+    };
+
+    inline bool operator==(const CirculatorIterator& other) const
+    {
+        return this->currentEdge==other.currentEdge;
+    };
+
+    inline bool operator!=(const CirculatorIterator& other) const
+    {
+        return this->currentEdge!=other.currentEdge;
+    };
+
+private:
+
+    const MeshT* mesh;
+    unsigned int startEdge;
+    unsigned int currentEdge;
+};
+
+/**
+	A loop of half-edges, that can be used in a range-based for and with the
+    standard algorithms. It doesn't allocate memory, and the step of the loop
+    is known at compile time, so a loop over a range is as fast as the code
+    written by hand with getHalfEdgeNext and getHalfEdgeTwin.
+
+    The ranges are created by the functions below:
+
+        for( unsigned int neighbourId : vertexNeighbours( mesh, vertexId ) ) ...
+
+        CirculatorRange<...> range = faceVertices( mesh, faceId );
+        for( CirculatorRange<...>::iterator it=range.begin(); it!=range.end(); ++it ) ...
+
+    They work with any class that has the ID methods of the Mesh, with any
+    storage. The mesh must not change while a range is used.
+*/
+template<class MeshT, class StepT, class ValueT>
+class CirculatorRange
+{
+public:
+
+    typedef CirculatorIterator<MeshT, StepT, ValueT> iterator;
+    typedef CirculatorIterator<MeshT, StepT, ValueT> const_iterator;
+
+    inline CirculatorRange(const MeshT& mesh, unsigned int startEdge):
+        mesh(&mesh),
+        startEdge(startEdge)
+    {
+    };
+
+    inline iterator begin() const
+    {
+        return iterator( *this->mesh, this->startEdge );
+    };
+
+    inline iterator end() const
+    {
+        return iterator();
+    };
+
+    inline bool empty() const
+    {
+        return this->begin()==this->end();
+    };
+
+private:
+
+    const MeshT* mesh;
+    unsigned int startEdge;
+};
+
+/**
+	The half-edges that leave the vertex.
+*/
+template<class MeshT>
+inline CirculatorRange<MeshT, AroundVertexStep, HalfEdgeValue> vertexOutgoingHalfEdges(const MeshT& mesh, unsigned int vertexId)
+{
+    return CirculatorRange<MeshT, AroundVertexStep, HalfEdgeValue>( mesh, mesh.getVertexIncidentEdge(vertexId) );
+}
+
+/**
+	The vertices connected to the vertex by an edge.
+*/
+template<class MeshT>
+inline CirculatorRange<MeshT, AroundVertexStep, TargetValue> vertexNeighbours(const MeshT& mesh, unsigned int vertexId)
+{
+    return CirculatorRange<MeshT, AroundVertexStep, TargetValue>( mesh, mesh.getVertexIncidentEdge(vertexId) );
+}
+
+/**
+	The faces around the vertex. The borders (half-edges without a face) are
+    skipped.
+*/
+template<class MeshT>
+inline CirculatorRange<MeshT, AroundVertexStep, FaceValue> vertexFaces(const MeshT& mesh, unsigned int vertexId)
+{
+    return CirculatorRange<MeshT, AroundVertexStep, FaceValue>( mesh, mesh.getVertexIncidentEdge(vertexId) );
+}
+
+/**
+	The half-edges of the face, starting at its boundary.
+*/
+template<class MeshT>
+inline CirculatorRange<MeshT, AroundFaceStep, HalfEdgeValue> faceHalfEdges(const MeshT& mesh, unsigned int faceId)
+{
+    return CirculatorRange<MeshT, AroundFaceStep, HalfEdgeValue>( mesh, mesh.getFaceBoundary(faceId) );
+}
+
+/**
+	The vertices of the face, in the same order as its half-edges.
+*/
+template<class MeshT>
+inline CirculatorRange<MeshT, AroundFaceStep, OriginValue> faceVertices(const MeshT& mesh, unsigned int faceId)
+{
+    return CirculatorRange<MeshT, AroundFaceStep, OriginValue>( mesh, mesh.getFaceBoundary(faceId) );
+}
+
+/**
+	The half-edges of the loop that contains the given half-edge, starting
+    at it. For a half-edge without a face, it is the border of the mesh.
+*/
+template<class MeshT>
+inline CirculatorRange<MeshT, AroundFaceStep, HalfEdgeValue> boundaryLoop(const MeshT& mesh, unsigned int halfEdgeId)
+{
+    return CirculatorRange<MeshT, AroundFaceStep, HalfEdgeValue>( mesh, halfEdgeId );
+}
+
+#endif//DCEL_Circulators_h
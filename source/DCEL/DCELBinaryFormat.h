@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCELBinaryFormat_h
+#define DCELBinaryFormat_h
+
+#include <cstddef>
+#include <cstring>
+
+#include "IntTypes.h"
+#include "Exception.h"
+
+/**
+	True when the machine stores the least significant byte of a value
+    first. Used by the binary formats to know when the bytes of the values
+    must be swapped.
+*/
+inline bool isLittleEndianHost()
+{
+    const uint32_t one = 1;
+    return *(const unsigned char*)&one==1;
+}
+
+/**
+	The header of a binary DCEL file, written by DCELStream::writeBinary.
+
+    The file is the header followed by the arrays of IDs (32 bits each, with
+    MESH_NULL_ID for a missing element), in this order:
+
+        incident edge of each vertex        numVertices IDs
+        twin of each half-edge              numHalfEdges IDs
+        next of each half-edge              numHalfEdges IDs
+        prev of each half-edge              numHalfEdges IDs
+        origin of each half-edge            numHalfEdges IDs
+        face of each half-edge              numHalfEdges IDs
+        boundary of each face               numFaces IDs
+
+    and then by the optional user data blocks: the bytes of the data of each
+    vertex, of each half-edge and of each face. A block is present when its
+    element size is not 0, and starts at a multiple of 8 bytes.
+
+    The values are stored with the byte order of the machine that wrote the
+    file, and byteOrder tells which one it was.
+*/
+class DCELBinaryHeader
+{
+public:
+
+    enum
+    {
+        VERSION = 1,
+        BYTE_ORDER_MARK = 0x01020304
+    };
+
+    DCELBinaryHeader()
+    {
+        std::memcpy( this->magic, "DCEL", 4 );
+        this->byteOrder = BYTE_ORDER_MARK;
+        this->version = VERSION;
+        this->idSize = sizeof(uint32_t);
+        this->numVertices = 0;
+        this->numHalfEdges = 0;
+        this->numFaces = 0;
+        this->vertexDataSize = 0;
+        this->halfEdgeDataSize = 0;
+        this->faceDataSize = 0;
+        this->reserved[0] = 0;
+        this->reserved[1] = 0;
+    };
+
+    /**
+    	Throws a cpp::Exception if this is not a header that can be read in
+        this machine.
+    */
+    void check() const
+    {
+        if( std::memcmp( this->magic, "DCEL", 4 )!=0 )
+        {
+            throw cpp::Exception("This is not a binary DCEL file");
+        }
+        if( this->byteOrder!=BYTE_ORDER_MARK )
+        {
+            throw cpp::Exception("The binary DCEL file was written with another byte order");
+        }
+        if( this->version!=VERSION )
+        {
+            throw cpp::Exception("Unknown version of the binary DCEL file");
+        }
+        if( this->idSize!=sizeof(uint32_t) )
+        {
+            throw cpp::Exception("The binary DCEL file has IDs of an unknown size");
+        }
+    };
+
+    inline size_t getVertexIncidentEdgesOffset() const
+    {
+        return sizeof(DCELBinaryHeader);
+    };
+
+    /**
+    	The offset of the i-th array of half-edge IDs: 0 for the twins, 1 for
+        next, 2 for prev, 3 for the origins and 4 for the faces.
+    */
+    inline size_t getHalfEdgeIdsOffset(unsigned int array) const
+    {
+        return this->getVertexIncidentEdgesOffset() + (size_t)this->numVertices*this->idSize
+            + (size_t)array*this->numHalfEdges*this->idSize;
+    };
+
+    inline size_t getFaceBoundariesOffset() const
+    {
+        return this->getHalfEdgeIdsOffset( 5 );
+    };
+
+    inline size_t getVertexDataOffset() const
+    {
+        return align( this->getFaceBoundariesOffset() + (size_t)this->numFaces*this->idSize );
+    };
+
+    inline size_t getHalfEdgeDataOffset() const
+    {
+        return align( this->getVertexDataOffset() + (size_t)this->numVertices*this->vertexDataSize );
+    };
+
+    inline size_t getFaceDataOffset() const
+    {
+        return align( this->getHalfEdgeDataOffset() + (size_t)this->numHalfEdges*this->halfEdgeDataSize );
+    };
+
+    /**
+    	The size of the whole file.
+    */
+    inline size_t getFileSize() const
+    {
+        return this->getFaceDataOffset() + (size_t)this->numFaces*this->faceDataSize;
+    };
+
+    static inline size_t align(size_t offset)
+    {
+        return (offset+7) & ~(size_t)7;
+    };
+
+    char magic[4];
+    uint32_t byteOrder;
+    uint32_t version;
+    uint32_t idSize;
+    uint32_t numVertices;
+    uint32_t numHalfEdges;
+    uint32_t numFaces;
+    uint32_t vertexDataSize;
+    uint32_t halfEdgeDataSize;
+    uint32_t faceDataSize;
+    uint32_t reserved[2];
+};
+
+#endif//DCELBinaryFormat_h
@@ -11,15 +11,158 @@
 #define DCELStream_h
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "Mesh.h"
+#include "DCELBinaryFormat.h"
+#include "MappedFile.h"
+#include "TextScanner.h"
+#include "TextWriter.h"
+
+/**
+	Reads one user data value with its operator>>, through a std::istream
+    over the same text as the scanner, and moves the scanner after it.
+*/
+template<class DataT>
+inline void readDCELTextDataWithStream(DataT& data, TextScanner& scanner, TextScannerStream& dataStream)
+{
+    dataStream.setPosition( scanner );
+    dataStream >> data;
+    scanner.setPosition( dataStream.getPosition() );
+}
+
+/**
+	Reads one user data value of a DCEL text file. The generic version uses
+    the operator>> of the type.
+
+    The operator>> is much slower than the parsing of the IDs, so it can be
+    specialized for the data types of a mesh, to read them directly with the
+    TextScanner:
+
+        template<>
+        class DCELTextData<MyVertexData>
+        {
+        public:
+            static void read(MyVertexData& data, TextScanner& scanner, TextScannerStream& dataStream)
+            {
+                scanner.skipSpaces();
+                if( !scanner.readFloat(data.x) ) ...
+            };
+        };
+
+    It is already specialized for float, double, int and unsigned int. The
+    text that the scanner doesn't recognize (like "nan") is still read with
+    operator>>.
+*/
+template<class DataT>
+class DCELTextData
+{
+public:
+
+    static inline void read(DataT& data, TextScanner& scanner, TextScannerStream& dataStream)
+    {
+        readDCELTextDataWithStream( data, scanner, dataStream );
+    };
+};
+
+template<>
+class DCELTextData<float>
+{
+public:
+
+    static inline void read(float& data, TextScanner& scanner, TextScannerStream& dataStream)
+    {
+        scanner.skipWhitespace();
+        if( !scanner.readFloat(data) )
+        {
+            readDCELTextDataWithStream( data, scanner, dataStream );
+        }
+    };
+};
+
+template<>
+class DCELTextData<double>
+{
+public:
+
+    static inline void read(double& data, TextScanner& scanner, TextScannerStream& dataStream)
+    {
+        scanner.skipWhitespace();
+        if( !scanner.readDouble(data) )
+        {
+            readDCELTextDataWithStream( data, scanner, dataStream );
+        }
+    };
+};
+
+template<>
+class DCELTextData<int>
+{
+public:
+
+    static inline void read(int& data, TextScanner& scanner, TextScannerStream& dataStream)
+    {
+        scanner.skipWhitespace();
+        if( !scanner.readInt(data) )
+        {
+            readDCELTextDataWithStream( data, scanner, dataStream );
+        }
+    };
+};
+
+template<>
+class DCELTextData<unsigned int>
+{
+public:
+
+    static inline void read(unsigned int& data, TextScanner& scanner, TextScannerStream& dataStream)
+    {
+        scanner.skipWhitespace();
+        if( !scanner.readUnsigned(data) )
+        {
+            readDCELTextDataWithStream( data, scanner, dataStream );
+        }
+    };
+};
 
 template <class MeshT>
 class DCELStream
 {
 public:
 
+    /**
+    	Reads a mesh written by write or by writeBinary. A binary file is
+        recognized by its first bytes.
+
+        A text stream is read to memory at once and parsed by readText.
+    */
     static void read(MeshT& mesh, std::istream &stream);
 
+    /**
+    	Reads a mesh written by write or by writeBinary from a file, that is
+        mapped in memory instead of read through a stream.
+    */
+    static void readFile(MeshT& mesh, const std::string& filename);
+
+    /**
+    	Reads a mesh in the text format (see write) from the characters in
+        [begin, end), replacing the current elements of the mesh.
+
+        Each record is recognized by its first characters, and the IDs are
+        parsed directly from the buffer. The faces are only collected while
+        they are read, and are built at once when the first 'e' record (or
+        the end) is found: a mesh of triangles is built by buildFromTriangles,
+        so the vertex and face IDs are the same as in the written mesh (the
+        half-edge IDs may not be, and the data of each half-edge is found by
+        its vertices). The user data is read by DCELTextData.
+
+        The comments are skipped. Throws a cpp::Exception if a record has
+        invalid IDs, and then the mesh is left empty.
+    */
+    static void readText(MeshT& mesh, const char* begin, const char* end);
+
     /**
     	Format:
 
@@ -35,21 +178,46 @@ public:
         e <id of the source vertex of the edge> <id of the source of the twin edge> <custom user data>
         ... # repeat e for ec times, one for each half edge
         end
+
+        The text is written to a large buffer, and the stream is flushed only
+        at the end. The IDs are always written in decimal, and the user data
+        with its operator<<, using the format flags of the stream.
     */
     static void write(const MeshT& mesh, std::ostream &stream);
 
-    template<class MeshT, class MeshT2>
-    static void copyDcelData(const MeshT& source, MeshT2& target )
+    /**
+    	Writes the mesh in the binary format described in DCELBinaryFormat.h,
+        with one large write for each group of IDs. The stream must be opened
+        in binary mode.
+
+        When withUserData is true, the VertexData, HalfEdgeData and FaceData
+        of the elements are written as their raw bytes. So it must only be used
+        when these types have no pointers (nor anything that can't be copied
+        with memcpy).
+    */
+    static void writeBinary(const MeshT& mesh, std::ostream &stream, bool withUserData = true);
+
+    /**
+    	Reads a mesh written by writeBinary, replacing the current elements
+        of the mesh. The IDs of all elements are the same as in the written
+        mesh. The data of the elements without a user data block in the file
+        keeps its default value.
+
+        Throws a cpp::Exception if the file is not valid, or if its user data
+        has another size than the data types of the mesh. The mesh is left
+        empty then, instead of with part of the file.
+    */
+    static void readBinary(MeshT& mesh, std::istream &stream);
+
+    template<class SourceMeshT, class MeshT2>
+    static void copyDcelData(const SourceMeshT& source, MeshT2& target )
     {
-        const MeshT::Face* face = NULL;
         const unsigned int numVertices = source.getNumVertices();
         const unsigned int numFaces = source.getNumFaces();
         const unsigned int numEdges = source.getNumHalfEdges();
 
         target.clear();
-        target.getVertices().reserve( numVertices );
-        target.getFaces().reserve( numFaces );
-        target.getHalfEdges().reserve( numEdges );
+        target.reserve( numVertices, numEdges, numFaces );
 
         for( unsigned int vertexId=0; vertexId<numVertices; ++vertexId )
         {
@@ -57,19 +225,13 @@ public:
 
             // convert here the data from the source to target vertex
         }
+        typedef CirculatorRange<SourceMeshT, AroundFaceStep, OriginValue> FaceVertexRange;
+        std::vector<uint32_t> vertexIds;
         for( unsigned int faceId=0; faceId<numFaces; ++faceId )
         {
-            face = source.getFace( faceId );
-
-            unsigned int vid[3];//generalizar
-            unsigned int vertexCount=0;
-            MeshT::EdgeIterator it(face);
-            while( it.hasNext() )
-            {
-                vid[vertexCount] = source.getVertexId( it.getNext()->getOrigin() );
-                ++vertexCount;
-            }
-            target.createTriangularFace( vid[0], vid[1], vid[2] );
+            const FaceVertexRange vertices = faceVertices( source, faceId );
+            vertexIds.assign( vertices.begin(), vertices.end() );
+            target.createPolygonFace( &vertexIds[0], (unsigned int)vertexIds.size() );
 
             // convert here the data from the source to target faces
         }
@@ -86,9 +248,74 @@ public:
 protected:
 private:
 
-    static void read_v1(MeshT& mesh, std::istream &stream);
+    /**
+    	Reads the records after "version 1", until "end".
+    */
+    static void read_v1(MeshT& mesh, TextScanner& scanner, TextScannerStream& dataStream);
+
+    /**
+    	Creates the faces collected by read_v1. faceSizes has the number of
+        vertices of each face, and faceVertexIds all their vertices.
+    */
+    static void buildFaces(MeshT& mesh, const std::vector<uint32_t>& faceSizes, const std::vector<uint32_t>& faceVertexIds,
+        const std::vector<typename MeshT::FaceData>& faceData, bool allTriangles);
+
+    /**
+    	Reads an ID preceded by spaces, and throws a cpp::Exception if there
+        is no ID or if it is not smaller than maxId.
+    */
+    static unsigned int readId(TextScanner& scanner, unsigned int maxId);
 
-    static void consumeComment(const std::string& commentBegin, std::istream &stream);
+    static bool isWord(const char* word, size_t length, const char* keyword);
+
+    enum ElementType
+    {
+        VERTICES,
+        HALF_EDGES,
+        FACES
+    };
+
+    typedef unsigned int (MeshT::*IdGetter)(unsigned int) const;
+    typedef void (MeshT::*IdSetter)(unsigned int, unsigned int);
+
+    /**
+    	The number of elements copied by each read or write call.
+    */
+    enum { BLOCK_SIZE = 1<<16 };
+
+    static void writeIds(const MeshT& mesh, IdGetter getter, unsigned int count, std::ostream &stream);
+
+    /**
+    	Reads count IDs, and gives them to the setter. Throws a cpp::Exception
+        if an ID is not smaller than maxId, unless it is MESH_NULL_ID and
+        allowNull is true.
+    */
+    static void readIds(MeshT& mesh, IdSetter setter, unsigned int count, unsigned int maxId, bool allowNull, std::istream &stream);
+
+    /**
+    	Reads count half-edge IDs into the vector, with the checks of readIds
+        (none can be NULL). Used for the twin, next and previous half-edges,
+        that are checked together before they are given to the mesh.
+    */
+    static void readHalfEdgeIds(std::vector<uint32_t>& ids, unsigned int count, std::istream &stream);
+
+    /**
+    	Throws a cpp::Exception if the stream has less than byteCount bytes
+        from the given start. Streams that can't be positioned are not
+        checked.
+    */
+    static void checkStreamLength(std::istream &stream, std::streampos start, size_t byteCount);
+
+    static void writeUserData(const MeshT& mesh, ElementType type, unsigned int count, std::ostream &stream);
+
+    static void readUserData(MeshT& mesh, ElementType type, unsigned int count, std::istream &stream);
+
+    /**
+    	Writes zeros (or skips them, when reading) from the position to the
+        given offset in the file.
+    */
+    static void writePadding(size_t& position, size_t offset, std::ostream &stream);
+    static void skipPadding(size_t& position, size_t offset, std::istream &stream);
 };
 
 
@@ -100,170 +327,652 @@ private:
 template <class MeshT>
 void DCELStream<MeshT>::read(MeshT& mesh, std::istream &stream)
 {
-    while( stream.good() )
+    if( stream.peek()=='D' )
+    {
+        readBinary(mesh, stream);
+        return;
+    }
+
+    // the whole text is read in large blocks, and parsed from memory
+    std::vector<char> text;
+    size_t size = 0;
+    std::streambuf* buffer = stream.rdbuf();
+    while( true )
     {
-        std::string str;
-        stream >> str;
-        if( str=="version" )
+        text.resize( size + (1<<20) );
+        const std::streamsize count = buffer->sgetn( &text[size], (std::streamsize)(text.size()-size) );
+        size += (size_t)count;
+        if( size<text.size() )
         {
-            unsigned int version;
-            stream >> version;
-            switch(version)
+            break;
+        }
+    }
+    stream.setstate( std::ios::eofbit );
+
+    readText( mesh, &text[0], &text[0]+size );
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::readFile(MeshT& mesh, const std::string& filename)
+{
+    MappedFile file;
+    file.open( filename );
+    if( file.getSize()>=4 && std::memcmp( file.getData(), "DCEL", 4 )==0 )
+    {
+        file.close();
+        std::ifstream stream( filename.c_str(), std::ios::in | std::ios::binary );
+        readBinary( mesh, stream );
+        return;
+    }
+    readText( mesh, file.getData(), file.getData()+file.getSize() );
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::readText(MeshT& mesh, const char* begin, const char* end)
+{
+    mesh.clear();
+
+    try
+    {
+        TextScanner scanner( begin, end );
+        TextScannerStream dataStream( scanner );
+        while( true )
+        {
+            scanner.skipWhitespace();
+            if( scanner.atEnd() )
             {
-            case 1:
-                read_v1(mesh, stream);
                 break;
-            default:
-                std::cerr << "Warning: unknown version " << version << std::endl;
+            }
+            if( scanner.peek()=='#' )
+            {
+                scanner.skipLine();
+                continue;
+            }
+
+            size_t length;
+            const char* word = scanner.readWord( length );
+            if( isWord( word, length, "version" ) )
+            {
+                unsigned int version = 0;
+                scanner.skipSpaces();
+                scanner.readUnsigned( version );
+                switch(version)
+                {
+                case 1:
+                    read_v1(mesh, scanner, dataStream);
+                    break;
+                default:
+                    std::cerr << "Warning: unknown version " << version << std::endl;
+                }
+            }
+            else
+            {
+                std::cerr << "Unknown line: " << std::string( word, length ) << std::endl;
+                scanner.skipLine();
             }
         }
-        else if( str.at(0)=='#' )
-        {
-            consumeComment(str, stream);
-        }
-        else
-        {
-            std::cerr << "Unknown line: " << str << std::endl;
-        }
+    }
+    catch(...)
+    {
+        mesh.clear();
+        throw;
     }
 }
 
 template <class MeshT>
 void DCELStream<MeshT>::write(const MeshT& mesh, std::ostream &stream)
 {
-    const MeshT::Vertex* vertex = NULL;
-    const MeshT::Face* face = NULL;
     const unsigned int numVertices = mesh.getNumVertices();
     const unsigned int numFaces = mesh.getNumFaces();
     const unsigned int numEdges = mesh.getNumHalfEdges();
 
-    stream << "version 1" << std::endl;
+    // the lines are written to a large buffer, that is sent to the stream
+    // only when it is full. The IDs are formatted directly into the buffer
+    TextWriter writer( stream );
+    std::ostream& dataStream = writer.getStream();
+
+    writer.write( "version 1\n" );
 
-    stream << "vc " << numVertices << std::endl;
-    stream << "fc " << numFaces << std::endl;
-    stream << "ec " << numEdges << std::endl;
+    writer.write( "vc " );
+    writer.writeUnsigned( numVertices );
+    writer.write( "\nfc " );
+    writer.writeUnsigned( numFaces );
+    writer.write( "\nec " );
+    writer.writeUnsigned( numEdges );
+    writer.newLine();
 
     for( unsigned int vertexId=0; vertexId<numVertices; ++vertexId )
     {
-        vertex = mesh.getVertex( vertexId );
-        stream << "v " << vertex->getData() << std::endl;
+        writer.write( "v " );
+        dataStream << mesh.getVertexData( vertexId );
+        writer.newLine();
     }
 
+    typedef CirculatorRange<MeshT, AroundFaceStep, OriginValue> FaceVertexRange;
+    std::vector<uint32_t> vertexIds;
     for( unsigned int faceId=0; faceId<numFaces; ++faceId )
     {
-        face = mesh.getFace( faceId );
-        stream << "f ";
+        writer.write( "f " );
 
-        unsigned int vid[3];//generalizar
-        unsigned int vertexCount=0;
-        MeshT::EdgeIterator it(face);
-        while( it.hasNext() )
+        const FaceVertexRange vertices = faceVertices( mesh, faceId );
+        vertexIds.assign( vertices.begin(), vertices.end() );
+        writer.writeUnsigned( vertexIds.size() );
+        for( size_t v=0; v<vertexIds.size(); ++v )
         {
-            vid[vertexCount] = mesh.getVertexId( it.getNext()->getOrigin() );
-            ++vertexCount;
+            writer.write( ' ' );
+            writer.writeUnsigned( vertexIds[v] );
         }
-        stream << vertexCount;
-        for( unsigned int v=0; v<vertexCount; ++v )
-        {
-            stream << " " << vid[v];
-        }
-        stream << " " << face->getData();
-        stream << std::endl;
+        writer.write( ' ' );
+        dataStream << mesh.getFaceData( faceId );
+        writer.newLine();
     }
 
     for( unsigned int edgeId=0; edgeId<numEdges; ++edgeId )
     {
-        const MeshT::HalfEdge* edge = mesh.getHalfEdge( edgeId );
-        stream << "e " << mesh.getVertexId( edge->getOrigin() ) 
-            << " " << mesh.getVertexId( edge->getTwin()->getOrigin() )
-            << " " << edge->getData() << std::endl;
+        writer.write( "e " );
+        writer.writeUnsigned( mesh.getHalfEdgeOrigin( edgeId ) );
+        writer.write( ' ' );
+        writer.writeUnsigned( mesh.getHalfEdgeOrigin( mesh.getHalfEdgeTwin(edgeId) ) );
+        writer.write( ' ' );
+        dataStream << mesh.getHalfEdgeData( edgeId );
+        writer.newLine();
     }
 
-    stream << "end";
+    writer.write( "end" );
+    writer.flush();
 }
 
 template <class MeshT>
-void DCELStream<MeshT>::read_v1(MeshT& mesh, std::istream &stream)
+void DCELStream<MeshT>::writeBinary(const MeshT& mesh, std::ostream &stream, bool withUserData)
 {
-    std::string str;
+    DCELBinaryHeader header;
+    header.numVertices = mesh.getNumVertices();
+    header.numHalfEdges = mesh.getNumHalfEdges();
+    header.numFaces = mesh.getNumFaces();
+    if( withUserData )
+    {
+        header.vertexDataSize = sizeof(typename MeshT::VertexData);
+        header.halfEdgeDataSize = sizeof(typename MeshT::HalfEdgeData);
+        header.faceDataSize = sizeof(typename MeshT::FaceData);
+    }
+    stream.write( (const char*)&header, sizeof(header) );
 
-    bool reading = true;
-    while( reading && stream.good() )
+    writeIds( mesh, &MeshT::getVertexIncidentEdge, header.numVertices, stream );
+    writeIds( mesh, &MeshT::getHalfEdgeTwin, header.numHalfEdges, stream );
+    writeIds( mesh, &MeshT::getHalfEdgeNext, header.numHalfEdges, stream );
+    writeIds( mesh, &MeshT::getHalfEdgePrev, header.numHalfEdges, stream );
+    writeIds( mesh, &MeshT::getHalfEdgeOrigin, header.numHalfEdges, stream );
+    writeIds( mesh, &MeshT::getHalfEdgeFace, header.numHalfEdges, stream );
+    writeIds( mesh, &MeshT::getFaceBoundary, header.numFaces, stream );
+
+    if( withUserData )
+    {
+        size_t position = header.getFaceBoundariesOffset() + (size_t)header.numFaces*header.idSize;
+        writePadding( position, header.getVertexDataOffset(), stream );
+        writeUserData( mesh, VERTICES, header.numVertices, stream );
+        position += (size_t)header.numVertices*header.vertexDataSize;
+        writePadding( position, header.getHalfEdgeDataOffset(), stream );
+        writeUserData( mesh, HALF_EDGES, header.numHalfEdges, stream );
+        position += (size_t)header.numHalfEdges*header.halfEdgeDataSize;
+        writePadding( position, header.getFaceDataOffset(), stream );
+        writeUserData( mesh, FACES, header.numFaces, stream );
+    }
+
+    if( !stream )
+    {
+        throw cpp::Exception("Error writing the binary DCEL file");
+    }
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::readBinary(MeshT& mesh, std::istream &stream)
+{
+    try
+    {
+        const std::streampos start = stream.tellg();
+        DCELBinaryHeader header;
+        stream.read( (char*)&header, sizeof(header) );
+        if( !stream )
+        {
+            throw cpp::Exception("This is not a binary DCEL file");
+        }
+        header.check();
+
+        const unsigned int dataSizes[3] = { header.vertexDataSize, header.halfEdgeDataSize, header.faceDataSize };
+        const size_t meshDataSizes[3] = { sizeof(typename MeshT::VertexData), sizeof(typename MeshT::HalfEdgeData), sizeof(typename MeshT::FaceData) };
+        const unsigned int counts[3] = { header.numVertices, header.numHalfEdges, header.numFaces };
+        const size_t offsets[3] = { header.getVertexDataOffset(), header.getHalfEdgeDataOffset(), header.getFaceDataOffset() };
+
+        // the counts are checked against the length of the stream before
+        // anything is allocated for them
+        size_t fileSize = header.getFaceBoundariesOffset() + (size_t)header.numFaces*header.idSize;
+        for( unsigned int type=VERTICES; type<=FACES; ++type )
+        {
+            if( dataSizes[type]==0 )
+            {
+                continue;
+            }
+            if( dataSizes[type]!=meshDataSizes[type] )
+            {
+                throw cpp::Exception("The user data in the binary DCEL file has another size than the data of the mesh");
+            }
+            fileSize = offsets[type] + (size_t)counts[type]*dataSizes[type];
+        }
+        checkStreamLength( stream, start, fileSize );
+
+        mesh.resize( header.numVertices, header.numHalfEdges, header.numFaces );
+
+        readIds( mesh, &MeshT::setVertexIncidentEdge, header.numVertices, header.numHalfEdges, true, stream );
+
+        // the setters of the twin, next and previous half-edges change both
+        // half-edges of the pair, so the arrays must agree with each other.
+        // Otherwise the loaded mesh would not be the one in the file
+        std::vector<uint32_t> twinIds, nextIds, prevIds;
+        readHalfEdgeIds( twinIds, header.numHalfEdges, stream );
+        readHalfEdgeIds( nextIds, header.numHalfEdges, stream );
+        readHalfEdgeIds( prevIds, header.numHalfEdges, stream );
+        for( unsigned int edgeId=0; edgeId<header.numHalfEdges; ++edgeId )
+        {
+            if( twinIds[edgeId]==edgeId || twinIds[twinIds[edgeId]]!=edgeId
+                || prevIds[nextIds[edgeId]]!=edgeId || nextIds[prevIds[edgeId]]!=edgeId )
+            {
+                throw cpp::Exception("The twin, next and previous half-edges in the binary DCEL file don't match");
+            }
+        }
+        for( unsigned int edgeId=0; edgeId<header.numHalfEdges; ++edgeId )
+        {
+            mesh.setHalfEdgeTwin( edgeId, twinIds[edgeId] );
+            mesh.setHalfEdgeNext( edgeId, nextIds[edgeId] );
+        }
+        std::vector<uint32_t>().swap( twinIds );
+        std::vector<uint32_t>().swap( nextIds );
+        std::vector<uint32_t>().swap( prevIds );
+
+        readIds( mesh, &MeshT::setHalfEdgeOrigin, header.numHalfEdges, header.numVertices, true, stream );
+        readIds( mesh, &MeshT::setHalfEdgeFace, header.numHalfEdges, header.numFaces, true, stream );
+        readIds( mesh, &MeshT::setFaceBoundary, header.numFaces, header.numHalfEdges, true, stream );
+
+        size_t position = header.getFaceBoundariesOffset() + (size_t)header.numFaces*header.idSize;
+        for( unsigned int type=VERTICES; type<=FACES; ++type )
+        {
+            if( dataSizes[type]==0 )
+            {
+                continue;
+            }
+            skipPadding( position, offsets[type], stream );
+            readUserData( mesh, (ElementType)type, counts[type], stream );
+            position += (size_t)counts[type]*dataSizes[type];
+        }
+
+        // the origins were set directly, so the index must be built again
+        if( mesh.isHalfEdgeIndexEnabled() )
+        {
+            mesh.setHalfEdgeIndexEnabled( false );
+            mesh.setHalfEdgeIndexEnabled( true );
+        }
+    }
+    catch(...)
     {
-        stream >> str;
+        mesh.clear();
+        throw;
+    }
+}
 
-        if( str=="v" )
+template <class MeshT>
+void DCELStream<MeshT>::writeIds(const MeshT& mesh, IdGetter getter, unsigned int count, std::ostream &stream)
+{
+    std::vector<uint32_t> buffer( std::min<unsigned int>( count, BLOCK_SIZE ) );
+    for( unsigned int first=0; first<count; first+=BLOCK_SIZE )
+    {
+        const unsigned int blockCount = std::min<unsigned int>( count-first, BLOCK_SIZE );
+        for( unsigned int i=0; i<blockCount; ++i )
+        {
+            buffer[i] = (mesh.*getter)( first+i );
+        }
+        stream.write( (const char*)&buffer[0], blockCount*sizeof(uint32_t) );
+    }
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::readIds(MeshT& mesh, IdSetter setter, unsigned int count, unsigned int maxId, bool allowNull, std::istream &stream)
+{
+    std::vector<uint32_t> buffer( std::min<unsigned int>( count, BLOCK_SIZE ) );
+    for( unsigned int first=0; first<count; first+=BLOCK_SIZE )
+    {
+        const unsigned int blockCount = std::min<unsigned int>( count-first, BLOCK_SIZE );
+        stream.read( (char*)&buffer[0], blockCount*sizeof(uint32_t) );
+        if( !stream )
         {
-            MeshT::Vertex* vertex = mesh.getVertex( mesh.createVertex() );
-            stream >> (vertex->getData());
+            throw cpp::Exception("Unexpected end of the binary DCEL file");
         }
-        else if( str=="f" )
+        for( unsigned int i=0; i<blockCount; ++i )
         {
-            unsigned int vertexCount;
-            stream >> vertexCount;
-            unsigned int vid[3];//TODO generalize
-            for( unsigned int i=0; i<vertexCount; ++i )
-                stream >> (vid[i]);
+            if( buffer[i]>=maxId && !(allowNull && buffer[i]==MESH_NULL_ID) )
+            {
+                throw cpp::Exception("Invalid ID in the binary DCEL file");
+            }
+            (mesh.*setter)( first+i, buffer[i] );
+        }
+    }
+}
 
-            unsigned int fid = mesh.createTriangularFace( vid[0], vid[1], vid[2] );
-            MeshT::Face* face = mesh.getFace( fid );
-            stream >> face->getData();
+template <class MeshT>
+void DCELStream<MeshT>::readHalfEdgeIds(std::vector<uint32_t>& ids, unsigned int count, std::istream &stream)
+{
+    ids.resize( count );
+    for( unsigned int first=0; first<count; first+=BLOCK_SIZE )
+    {
+        const unsigned int blockCount = std::min<unsigned int>( count-first, BLOCK_SIZE );
+        stream.read( (char*)&ids[first], blockCount*sizeof(uint32_t) );
+        if( !stream )
+        {
+            throw cpp::Exception("Unexpected end of the binary DCEL file");
         }
-        else if( str=="e" )
+        for( unsigned int i=first; i<first+blockCount; ++i )
         {
-            unsigned int from, to;
-            stream >> from >> to;
-            MeshT::HalfEdge* edge = mesh.getHalfEdge( mesh.getVertex(from), mesh.getVertex(to) );
-            if( edge )
+            if( ids[i]>=count )
             {
-                stream >> edge->getData();
+                throw cpp::Exception("Invalid ID in the binary DCEL file");
             }
-            else
+        }
+    }
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::checkStreamLength(std::istream &stream, std::streampos start, size_t byteCount)
+{
+    if( start==std::streampos(-1) )
+    {
+        return;
+    }
+    const std::streampos position = stream.tellg();
+    stream.seekg( 0, std::ios::end );
+    const std::streampos end = stream.tellg();
+    stream.clear();
+    stream.seekg( position );
+    if( end!=std::streampos(-1) && (uint64_t)(end-start)<(uint64_t)byteCount )
+    {
+        throw cpp::Exception("Unexpected end of the binary DCEL file");
+    }
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::writeUserData(const MeshT& mesh, ElementType type, unsigned int count, std::ostream &stream)
+{
+    const size_t dataSize = type==VERTICES? sizeof(typename MeshT::VertexData) : type==HALF_EDGES? sizeof(typename MeshT::HalfEdgeData) : sizeof(typename MeshT::FaceData);
+    std::vector<char> buffer( std::min<unsigned int>( count, BLOCK_SIZE )*dataSize );
+    for( unsigned int first=0; first<count; first+=BLOCK_SIZE )
+    {
+        const unsigned int blockCount = std::min<unsigned int>( count-first, BLOCK_SIZE );
+        for( unsigned int i=0; i<blockCount; ++i )
+        {
+            const void* data;
+            switch( type )
             {
-                std::cerr << '?';
+            case VERTICES:   data = &mesh.getVertexData( first+i ); break;
+            case HALF_EDGES: data = &mesh.getHalfEdgeData( first+i ); break;
+            default:         data = &mesh.getFaceData( first+i );
             }
+            std::memcpy( &buffer[i*dataSize], data, dataSize );
         }
+        stream.write( &buffer[0], blockCount*dataSize );
+    }
+}
 
-        else if( str=="vc" )
+template <class MeshT>
+void DCELStream<MeshT>::readUserData(MeshT& mesh, ElementType type, unsigned int count, std::istream &stream)
+{
+    const size_t dataSize = type==VERTICES? sizeof(typename MeshT::VertexData) : type==HALF_EDGES? sizeof(typename MeshT::HalfEdgeData) : sizeof(typename MeshT::FaceData);
+    std::vector<char> buffer( std::min<unsigned int>( count, BLOCK_SIZE )*dataSize );
+    for( unsigned int first=0; first<count; first+=BLOCK_SIZE )
+    {
+        const unsigned int blockCount = std::min<unsigned int>( count-first, BLOCK_SIZE );
+        stream.read( &buffer[0], blockCount*dataSize );
+        if( !stream )
         {
-            unsigned int vc = std::numeric_limits<unsigned int>::max();
-            stream >> vc;
-            mesh.getVertices().reserve( vc*5 );
+            throw cpp::Exception("Unexpected end of the binary DCEL file");
         }
-        else if( str=="fc" )
+        for( unsigned int i=0; i<blockCount; ++i )
         {
-            unsigned int fc = std::numeric_limits<unsigned int>::max();
-            stream >> fc;
-            mesh.getFaces().reserve( fc*5 );
+            void* data;
+            switch( type )
+            {
+            case VERTICES:   data = &mesh.getVertexData( first+i ); break;
+            case HALF_EDGES: data = &mesh.getHalfEdgeData( first+i ); break;
+            default:         data = &mesh.getFaceData( first+i );
+            }
+            std::memcpy( data, &buffer[i*dataSize], dataSize );
         }
-        else if( str=="ec" )
+    }
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::writePadding(size_t& position, size_t offset, std::ostream &stream)
+{
+    static const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    stream.write( zeros, offset-position );
+    position = offset;
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::skipPadding(size_t& position, size_t offset, std::istream &stream)
+{
+    stream.ignore( offset-position );
+    position = offset;
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::read_v1(MeshT& mesh, TextScanner& scanner, TextScannerStream& dataStream)
+{
+    // buildFaces may enable the half-edge index
+    const bool halfEdgeIndexEnabled = mesh.isHalfEdgeIndexEnabled();
+
+    std::vector<uint32_t> faceSizes;
+    std::vector<uint32_t> faceVertexIds;
+    std::vector<typename MeshT::FaceData> faceData;
+    bool allTriangles = true;
+    bool facesBuilt = false;
+
+    bool reading = true;
+    while( reading )
+    {
+        scanner.skipWhitespace();
+        if( scanner.atEnd() )
         {
-            unsigned int ec = std::numeric_limits<unsigned int>::max();
-            stream >> ec;
-            mesh.getHalfEdges().reserve( ec*5 );
+            break;
         }
-        else if( str=="end" )
+
+        size_t length;
+        const char* word = scanner.readWord( length );
+        bool known = true;
+        switch( word[0] )
         {
-            reading = false;
+        case 'v':
+            if( length==1 )
+            {
+                DCELTextData<typename MeshT::VertexData>::read( mesh.getVertexData( mesh.createVertex() ), scanner, dataStream );
+            }
+            else if( isWord( word, length, "vc" ) )
+            {
+                const unsigned int vc = readId( scanner, MESH_NULL_ID );
+                mesh.reserve( vc, 0, 0 );
+            }
+            else
+            {
+                known = false;
+            }
+            break;
+
+        case 'f':
+            if( length==1 )
+            {
+                const unsigned int vertexCount = readId( scanner, MESH_NULL_ID );
+                if( vertexCount<3 )
+                {
+                    throw cpp::Exception("A face must have at least 3 vertices");
+                }
+                const unsigned int numVertices = mesh.getNumVertices();
+                for( unsigned int i=0; i<vertexCount; ++i )
+                {
+                    faceVertexIds.push_back( readId( scanner, numVertices ) );
+                }
+                faceSizes.push_back( vertexCount );
+                allTriangles = allTriangles && vertexCount==3;
+                faceData.resize( faceData.size()+1 );
+                DCELTextData<typename MeshT::FaceData>::read( faceData.back(), scanner, dataStream );
+            }
+            else if( isWord( word, length, "fc" ) )
+            {
+                const unsigned int fc = readId( scanner, MESH_NULL_ID );
+                faceSizes.reserve( fc );
+                faceVertexIds.reserve( (size_t)fc*3 );
+                faceData.reserve( fc );
+            }
+            else
+            {
+                known = false;
+            }
+            break;
+
+        case 'e':
+            if( length==1 )
+            {
+                if( !facesBuilt )
+                {
+                    buildFaces( mesh, faceSizes, faceVertexIds, faceData, allTriangles );
+                    facesBuilt = true;
+                }
+                const unsigned int numVertices = mesh.getNumVertices();
+                const unsigned int from = readId( scanner, numVertices );
+                const unsigned int to = readId( scanner, numVertices );
+                const unsigned int edgeId = mesh.findHalfEdge( from, to );
+                if( edgeId==MESH_NULL_ID )
+                {
+                    std::ostringstream message;
+                    message << "The half-edge " << from << " -> " << to << " is not in the mesh (line " << scanner.getLineNumber() << ")";
+                    throw cpp::Exception( message.str() );
+                }
+                DCELTextData<typename MeshT::HalfEdgeData>::read( mesh.getHalfEdgeData( edgeId ), scanner, dataStream );
+            }
+            else if( isWord( word, length, "ec" ) )
+            {
+                const unsigned int ec = readId( scanner, MESH_NULL_ID );
+                mesh.reserve( 0, ec, 0 );
+            }
+            else if( isWord( word, length, "end" ) )
+            {
+                reading = false;
+            }
+            else
+            {
+                known = false;
+            }
+            break;
+
+        case '#':
+            scanner.skipLine();
+            break;
+
+        default:
+            known = false;
         }
-        else if( str.at(0)=='#' )
+
+        if( !known )
         {
-            consumeComment(str, stream);
+            std::cerr << "Unknown line: " << std::string( word, length ) << std::endl;
+            scanner.skipLine();
+        }
+    }
+
+    if( !facesBuilt )
+    {
+        buildFaces( mesh, faceSizes, faceVertexIds, faceData, allTriangles );
+    }
+    mesh.setHalfEdgeIndexEnabled( halfEdgeIndexEnabled );
+}
+
+template <class MeshT>
+void DCELStream<MeshT>::buildFaces(MeshT& mesh, const std::vector<uint32_t>& faceSizes, const std::vector<uint32_t>& faceVertexIds,
+    const std::vector<typename MeshT::FaceData>& faceData, bool allTriangles)
+{
+    const unsigned int numFaces = (unsigned int)faceSizes.size();
+    if( numFaces==0 )
+    {
+        return;
+    }
+
+    if( allTriangles )
+    {
+        try
+        {
+            mesh.buildFromTriangles( &faceVertexIds[0], numFaces );
+            for( unsigned int faceId=0; faceId<numFaces; ++faceId )
+            {
+                mesh.getFaceData( faceId ) = faceData[faceId];
+            }
+            return;
+        }
+        catch( const cpp::Exception& )
+        {
+            // not a manifold mesh: the triangles are created one by one, as
+            // before, and the ones that can't be added are delayed. Building
+            // no triangles discards the half-edges of the failed build
+            mesh.buildFromTriangles( &faceVertexIds[0], 0 );
+        }
+    }
+
+    // each face looks up the half-edges of its sides. Each corner creates
+    // at most one pair of half-edges, and with the PointerStorage no
+    // reallocation can happen after the first face
+    mesh.setHalfEdgeIndexEnabled( true );
+    mesh.reserve( 0, 2*(unsigned int)faceVertexIds.size(), numFaces );
+    std::vector<unsigned int> delayedFaces;
+    std::vector<size_t> delayedFirsts;
+    size_t first = 0;
+    for( unsigned int i=0; i<numFaces; ++i )
+    {
+        unsigned int fid = mesh.createPolygonFace( &faceVertexIds[first], faceSizes[i] );
+        if( fid!=MESH_NULL_ID )
+        {
+            mesh.getFaceData( fid ) = faceData[i];
         }
         else
         {
-            std::cerr << "Unknown line: " << str;
+            delayedFaces.push_back( i );
+            delayedFirsts.push_back( first );
         }
+        first += faceSizes[i];
     }
     mesh.manageUnhandledTriangles();
+
+    // the delayed faces are created in another order, so each one is found
+    // by the half-edge from its first to its second vertex
+    for( size_t d=0; d<delayedFaces.size(); ++d )
+    {
+        const uint32_t* vertexIds = &faceVertexIds[ delayedFirsts[d] ];
+        const unsigned int halfEdgeId = mesh.findHalfEdge( vertexIds[0], vertexIds[1] );
+        mesh.getFaceData( mesh.getHalfEdgeFace( halfEdgeId ) ) = faceData[ delayedFaces[d] ];
+    }
+}
+
+template <class MeshT>
+unsigned int DCELStream<MeshT>::readId(TextScanner& scanner, unsigned int maxId)
+{
+    unsigned int id;
+    scanner.skipSpaces();
+    if( !scanner.readUnsigned(id) || id>=maxId )
+    {
+        std::ostringstream message;
+        message << "Invalid ID in the DCEL file (line " << scanner.getLineNumber() << ")";
+        throw cpp::Exception( message.str() );
+    }
+    return id;
 }
 
 template <class MeshT>
-void DCELStream<MeshT>::consumeComment(const std::string& commentBegin, std::istream &stream)
+bool DCELStream<MeshT>::isWord(const char* word, size_t length, const char* keyword)
 {
-    char buffer[512];
-    stream.getline( buffer, sizeof(buffer) );
-    std::cerr << commentBegin << " " << buffer << std::endl;
+    return std::strlen(keyword)==length && std::memcmp( word, keyword, length )==0;
 }
 
 #endif//DCELStream_h
@@ -10,9 +10,7 @@
 #ifndef DCEL_EdgeIterator_h
 #define DCEL_EdgeIterator_h
 
-#include "Vertex.h"
-#include "Face.h"
-#include "HalfEdge.h"
+#include "MeshStorage.h"
 //#include <cassert>
 
 /**
@@ -23,6 +21,10 @@
 
     In the case of a face, it runs over each edge that forms the boundary
     of that face.
+
+    Deprecated: it only works with the PointerStorage, and is kept for the
+    code written against it. New code should use the circulators of
+    Circulators.h (vertexOutgoingHalfEdges, faceHalfEdges, ...).
 */
 template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
 class EdgeIteratorT
@@ -122,4 +124,104 @@ private:
     bool vertexIterator;
 };
 
+/**
+	The same as the EdgeIteratorT, but based on the IDs of the elements instead
+    of their pointers. It works with any storage of the Mesh.
+
+        MyMesh::EdgeIdIterator it = MyMesh::EdgeIdIterator::aroundVertex( mesh, vertexId );
+        while( it.hasNext() )
+        {
+            unsigned int halfEdgeId = it.getNext();
+        }
+
+    Deprecated: the mesh code no longer uses it. New code should use the
+    circulators of Circulators.h, that do the same walk and work with the
+    standard algorithms.
+*/
+template<class MeshT>
+class EdgeIdIteratorT
+{
+public:
+
+    /**
+    	Creates an EdgeIdIterator that runs over each edge that starts on the
+        given vertex.
+    */
+    static inline EdgeIdIteratorT aroundVertex(const MeshT& mesh, unsigned int vertexId)
+    {
+        return EdgeIdIteratorT( mesh, mesh.getVertexIncidentEdge(vertexId), true );
+    };
+
+    /**
+    	Creates an EdgeIdIterator that runs over each edge that forms the 
+        boundary of the given face.
+    */
+    static inline EdgeIdIteratorT aroundFace(const MeshT& mesh, unsigned int faceId)
+    {
+        return EdgeIdIteratorT( mesh, mesh.getFaceBoundary(faceId), false );
+    };
+
+    /**
+    	Returns the ID of the next edge in the sequence. 
+        
+        Returns MESH_NULL_ID if all the sequence of edges has ended.
+    */
+    inline unsigned int getNext()
+    {
+        unsigned int next = nextEdge;
+
+        if( nextEdge!=MESH_NULL_ID )
+        {
+            if( vertexIterator ) // edges starting at a vertex iterator
+            {
+                nextEdge = mesh->getHalfEdgeNext( mesh->getHalfEdgeTwin(nextEdge) );
+            }
+            else // edges from face iterator
+            {
+                nextEdge = mesh->getHalfEdgeNext( nextEdge );
+            }
+        }
+
+        if( nextEdge==startEdge )
+        {
+            nextEdge = MESH_NULL_ID;
+        }
+
+        return next;
+    };
+
+    /**
+    	Check if there is any edge in the sequence of edges.
+    */
+    inline bool hasNext() const
+    {
+        return nextEdge!=MESH_NULL_ID;
+    };
+
+    /**
+    	Makes the iterator start again, from the first edge 
+        of the sequence.
+    */
+    inline void reset()
+    {
+        nextEdge = startEdge;
+    };
+
+protected:
+private:
+
+    inline EdgeIdIteratorT(const MeshT& mesh, unsigned int startEdge, bool vertexIterator):
+        mesh(&mesh),
+        startEdge(startEdge),
+        nextEdge(startEdge),
+        vertexIterator(vertexIterator)
+    {
+    };
+
+    const MeshT* mesh;
+    unsigned int startEdge;
+    unsigned int nextEdge;
+    bool vertexIterator;
+};
+
 #endif//DCEL_EdgeIterator_h
@@ -11,6 +11,7 @@
 #define DCEL_Face_h
 
 //#include <cassert>
+#include "IntTypes.h"
 
 template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
 class HalfEdgeT;
@@ -55,4 +56,45 @@ private:
     FaceDataT data;
 };
 
+/**
+	A face of a Mesh that uses the IndexStorage. It stores the ID of its
+    boundary half-edge (MESH_NULL_ID if there is none) instead of a pointer.
+*/
+template<class FaceDataT>
+class IndexFaceT
+{
+public:
+
+    IndexFaceT():
+        boundary(~0u),
+        data()
+    {
+    };
+
+    inline unsigned int getBoundaryId() const
+    {
+        return this->boundary;
+    };
+
+    inline void setBoundaryId(unsigned int edgeId)
+    {
+        this->boundary = edgeId;
+    };
+
+    inline FaceDataT& getData()
+    {
+        return data;
+    };
+
+    inline const FaceDataT& getData() const
+    {
+        return data;
+    };
+
+protected:
+private:
+    uint32_t boundary;
+    FaceDataT data;
+};
+
 #endif//DCEL_Face_h
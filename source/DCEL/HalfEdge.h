@@ -11,6 +11,7 @@
 #define DCEL_HalfEdge_h
 
 //#include <cassert>
+#include "IntTypes.h"
 
 template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
 class VertexT;
@@ -47,7 +48,10 @@ public:
     {
         //assert(this);
         this->twin = newTwin;
-        newTwin->twin = this;
+        if( newTwin!=NULL )
+        {
+            newTwin->twin = this;
+        }
     };
 
     inline HalfEdge* getNext() const
@@ -60,7 +64,10 @@ public:
     {
         //assert(this);
         this->next = newNext;
-        newNext->prev = this;
+        if( newNext!=NULL )
+        {
+            newNext->prev = this;
+        }
     };
 
     inline HalfEdge* getPrev() const
@@ -73,7 +80,10 @@ public:
     {
         //assert(this);
         this->prev = newPrev;
-        newPrev->next = this;
+        if( newPrev!=NULL )
+        {
+            newPrev->next = this;
+        }
     };
 
     inline Vertex* getOrigin() const
@@ -120,4 +130,179 @@ private:
     HalfEdgeDataT data;
 };
 
+/**
+	A half-edge of a Mesh that uses the IndexStorage. All its connections are
+    stored as 32-bit IDs (MESH_NULL_ID when not set) instead of pointers, so
+    on 64-bit systems the connectivity takes 20 bytes instead of 40, and the
+    half-edges can be moved in memory (by a growing std::vector, or written
+    to a file) without fixing any pointer.
+
+    As it doesn't know where the other elements are, it only deals with IDs.
+    The setters change only this half-edge: use the Mesh methods (like 
+    Mesh::setHalfEdgeNext) to also update the other side of the connection.
+*/
+template<class HalfEdgeDataT>
+class IndexHalfEdgeT
+{
+public:
+
+    IndexHalfEdgeT():
+        twin(~0u),
+        next(~0u),
+        prev(~0u),
+        origin(~0u),
+        face(~0u),
+        data()
+    {
+    };
+
+    inline unsigned int getTwinId() const
+    {
+        return this->twin;
+    };
+
+    inline void setTwinId(unsigned int edgeId)
+    {
+        this->twin = edgeId;
+    };
+
+    inline unsigned int getNextId() const
+    {
+        return this->next;
+    };
+
+    inline void setNextId(unsigned int edgeId)
+    {
+        this->next = edgeId;
+    };
+
+    inline unsigned int getPrevId() const
+    {
+        return this->prev;
+    };
+
+    inline void setPrevId(unsigned int edgeId)
+    {
+        this->prev = edgeId;
+    };
+
+    inline unsigned int getOriginId() const
+    {
+        return this->origin;
+    };
+
+    inline void setOriginId(unsigned int vertexId)
+    {
+        this->origin = vertexId;
+    };
+
+    inline unsigned int getFaceId() const
+    {
+        return this->face;
+    };
+
+    inline void setFaceId(unsigned int faceId)
+    {
+        this->face = faceId;
+    };
+
+    inline HalfEdgeDataT& getData()
+    {
+        return data;
+    };
+
+    inline const HalfEdgeDataT& getData() const
+    {
+        return data;
+    };
+
+protected:
+private:
+    uint32_t twin;
+    uint32_t next;
+    uint32_t prev;
+    uint32_t origin;
+    uint32_t face;
+    HalfEdgeDataT data;
+};
+
+/**
+	A half-edge of a Mesh that uses the CompactStorage. It is the same as the
+    IndexHalfEdgeT, without the twin: the Mesh computes it from the ID of the
+    half-edge (the twin of the half-edge 2k is 2k+1, and vice versa). The
+    connectivity takes 16 bytes.
+*/
+template<class HalfEdgeDataT>
+class CompactHalfEdgeT
+{
+public:
+
+    CompactHalfEdgeT():
+        next(~0u),
+        prev(~0u),
+        origin(~0u),
+        face(~0u),
+        data()
+    {
+    };
+
+    inline unsigned int getNextId() const
+    {
+        return this->next;
+    };
+
+    inline void setNextId(unsigned int edgeId)
+    {
+        this->next = edgeId;
+    };
+
+    inline unsigned int getPrevId() const
+    {
+        return this->prev;
+    };
+
+    inline void setPrevId(unsigned int edgeId)
+    {
+        this->prev = edgeId;
+    };
+
+    inline unsigned int getOriginId() const
+    {
+        return this->origin;
+    };
+
+    inline void setOriginId(unsigned int vertexId)
+    {
+        this->origin = vertexId;
+    };
+
+    inline unsigned int getFaceId() const
+    {
+        return this->face;
+    };
+
+    inline void setFaceId(unsigned int faceId)
+    {
+        this->face = faceId;
+    };
+
+    inline HalfEdgeDataT& getData()
+    {
+        return data;
+    };
+
+    inline const HalfEdgeDataT& getData() const
+    {
+        return data;
+    };
+
+protected:
+private:
+    uint32_t next;
+    uint32_t prev;
+    uint32_t origin;
+    uint32_t face;
+    HalfEdgeDataT data;
+};
+
 #endif//DCEL_HalfEdge_h
@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_HalfEdgeIndex_h
+#define DCEL_HalfEdgeIndex_h
+
+#include <vector>
+#include <limits>
+
+#include "IntTypes.h"
+
+/**
+	A hash table that maps a directed edge, given by the IDs of its origin and
+    target vertices, to the ID of the half-edge that goes from one to the other.
+
+    It uses open addressing with linear probing, so a lookup usually touches
+    a single cache line, no matter how many edges the vertices have. It is
+    used by the Mesh when its half-edge index is enabled.
+*/
+class HalfEdgeIndex
+{
+public:
+
+    HalfEdgeIndex():
+        count(0),
+        shift(64)
+    {
+    };
+
+    /**
+    	Removes all the entries, releasing the memory.
+    */
+    inline void clear()
+    {
+        std::vector<uint64_t>().swap( this->keys );
+        std::vector<uint32_t>().swap( this->values );
+        this->count = 0;
+        this->shift = 64;
+    };
+
+    /**
+    	Prepares the table to receive the given number of entries without
+        being rebuilt.
+    */
+    inline void reserve(size_t numEntries)
+    {
+        size_t capacity = 16;
+        while( capacity<2*numEntries )
+        {
+            capacity *= 2;
+        }
+        if( capacity>this->keys.size() )
+        {
+            this->rehash( capacity );
+        }
+    };
+
+    /**
+    	Maps the edge that goes from originId to targetId to the given
+        half-edge ID. If the edge was already in the table, its half-edge
+        ID is replaced.
+    */
+    inline void insert(uint32_t originId, uint32_t targetId, uint32_t halfEdgeId)
+    {
+        if( 2*(this->count+1)>this->keys.size() )
+        {
+            this->rehash( this->keys.empty()? 16 : 2*this->keys.size() );
+        }
+
+        const uint64_t key = makeKey( originId, targetId );
+        size_t slot = this->findSlot( key );
+        if( this->keys[slot]==EMPTY_KEY )
+        {
+            this->keys[slot] = key;
+            ++this->count;
+        }
+        this->values[slot] = halfEdgeId;
+    };
+
+    /**
+    	Returns the half-edge ID mapped to the edge from originId to targetId.
+        If the edge is not on the table, maps it to the given half-edge ID,
+        and returns MESH_NULL_ID. It needs a single lookup.
+    */
+    inline uint32_t findOrInsert(uint32_t originId, uint32_t targetId, uint32_t halfEdgeId)
+    {
+        if( 2*(this->count+1)>this->keys.size() )
+        {
+            this->rehash( this->keys.empty()? 16 : 2*this->keys.size() );
+        }
+
+        const uint64_t key = makeKey( originId, targetId );
+        size_t slot = this->findSlot( key );
+        if( this->keys[slot]!=EMPTY_KEY )
+        {
+            return this->values[slot];
+        }
+        this->keys[slot] = key;
+        this->values[slot] = halfEdgeId;
+        ++this->count;
+        return NULL_VALUE;
+    };
+
+    /**
+    	Returns the ID of the half-edge that goes from originId to targetId,
+        or MESH_NULL_ID if there is no such edge on the table.
+    */
+    inline uint32_t find(uint32_t originId, uint32_t targetId) const
+    {
+        if( this->count==0 )
+        {
+            return NULL_VALUE;
+        }
+        size_t slot = this->findSlot( makeKey( originId, targetId ) );
+        return this->keys[slot]==EMPTY_KEY? NULL_VALUE : this->values[slot];
+    };
+
+    /**
+    	Returns the number of edges on the table.
+    */
+    inline size_t size() const
+    {
+        return this->count;
+    };
+
+private:
+
+    static const uint64_t EMPTY_KEY = ~(uint64_t)0;
+    static const uint32_t NULL_VALUE = ~(uint32_t)0;
+
+    static inline uint64_t makeKey(uint32_t originId, uint32_t targetId)
+    {
+        return ((uint64_t)originId<<32) | targetId;
+    };
+
+    /**
+    	Returns the slot that has the given key, or the empty slot where it
+        should be placed.
+    */
+    inline size_t findSlot(uint64_t key) const
+    {
+        // Fibonacci hashing: the high bits of the product are well mixed
+        const size_t mask = this->keys.size()-1;
+        size_t slot = (size_t)( (key*0x9E3779B97F4A7C15ull) >> this->shift );
+        while( this->keys[slot]!=EMPTY_KEY && this->keys[slot]!=key )
+        {
+            slot = (slot+1) & mask;
+        }
+        return slot;
+    };
+
+    void rehash(size_t capacity)
+    {
+        std::vector<uint64_t> oldKeys( capacity, (uint64_t)EMPTY_KEY );
+        std::vector<uint32_t> oldValues( capacity );
+        oldKeys.swap( this->keys );
+        oldValues.swap( this->values );
+
+        this->shift = 64;
+        for( size_t c=capacity; c>1; c/=2 )
+        {
+            --this->shift;
+        }
+
+        for( size_t i=0; i<oldKeys.size(); ++i )
+        {
+            if( oldKeys[i]!=EMPTY_KEY )
+            {
+                size_t slot = this->findSlot( oldKeys[i] );
+                this->keys[slot] = oldKeys[i];
+                this->values[slot] = oldValues[i];
+            }
+        }
+    };
+
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> values;
+    size_t count;
+    unsigned int shift;
+};
+
+#endif//DCEL_HalfEdgeIndex_h
@@ -0,0 +1,214 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ImportOptions_h
+#define ImportOptions_h
+
+#include <iostream>
+#include "Mesh.h"
+
+/**
+	How much of the mesh is checked (using Mesh::checkFace) by the importers.
+*/
+enum ValidationPolicy
+{
+    /**
+    	The mesh is not checked at all.
+    */
+    VALIDATION_NONE,
+
+    /**
+    	The mesh is built at once, and then checkAllFaces() is called.
+    */
+    VALIDATION_FINAL,
+
+    /**
+    	The mesh is built at once, and then one of each 'sampleInterval'
+        faces is checked.
+    */
+    VALIDATION_SAMPLED,
+
+    /**
+    	The faces are inserted one by one with createTriangularFace, and the
+        region changed by each insertion is checked (with the dirty tracking
+        of the Mesh) right after it. It is much slower than building the mesh
+        at once, but it stops at the first face that breaks the mesh. Use it
+        only for debugging.
+    */
+    VALIDATION_PER_FACE
+};
+
+/**
+	Options used by the PlyImporter and WavefrontObjImporter classes.
+*/
+class ImportOptions
+{
+public:
+    ImportOptions():
+#ifdef NDEBUG
+        validation(VALIDATION_FINAL),
+#else
+        validation(VALIDATION_PER_FACE),
+#endif
+        sampleInterval(64),
+        threadCount(0),
+        importAttributes(false),
+        streaming(false)
+    {
+    };
+
+    ValidationPolicy validation;
+
+    /**
+    	Used by VALIDATION_SAMPLED: the faces 0, sampleInterval,
+        2*sampleInterval, ... are checked.
+    */
+    unsigned int sampleInterval;
+
+    /**
+    	The number of threads used to parse the file, or 0 to use one thread
+        per core. Only the WavefrontObjImporter reads in parallel.
+    */
+    unsigned int threadCount;
+
+    /**
+    	If true, the PlyImporter also reads the scalar properties of the
+        vertices and faces (like normals, colors or confidence) to attribute
+        channels of the mesh, named as the properties (see PlyLoader::load).
+    */
+    bool importAttributes;
+
+    /**
+    	If true, the WavefrontObjImporter creates the vertices and faces of
+        the mesh while the file is read in parts of about 1MB, instead of
+        loading the whole file to buffers first. Unless threadCount is 1,
+        the file is read by one thread and the mesh is built by another, at
+        the same time.
+
+        Each part is added with Mesh::addTriangles, that pairs the sides of
+        the triangles with a hash table of the edges. The peak of memory is
+        the mesh, with room reserved for 6 half-edges per face, plus that
+        table (24 to 48 bytes per edge). The half-edge IDs are not the ones of
+        buildFromTriangles, and the face IDs follow the file, except for the
+        faces that use a vertex defined after them, that are added at the
+        end.
+
+        With VALIDATION_PER_FACE, the faces are inserted one by one with
+        createTriangularFace instead, and a face can also get another ID
+        than its triangle in the file if it had to be delayed.
+    */
+    bool streaming;
+};
+
+/**
+	Used internally by the importers, after the faces were created: checks
+    the mesh as asked by the options. VALIDATION_PER_FACE checks all faces
+    again, as the delayed triangles are not checked when they are inserted.
+*/
+template <class MeshT>
+void checkImportedMesh( const MeshT& mesh, const ImportOptions& options )
+{
+    if( options.validation==VALIDATION_FINAL || options.validation==VALIDATION_PER_FACE )
+    {
+        mesh.checkAllFaces();
+    }
+    else if( options.validation==VALIDATION_SAMPLED )
+    {
+        const unsigned int numFaces = mesh.getNumFaces();
+        const unsigned int interval = options.sampleInterval>0? options.sampleInterval : 1;
+        for( unsigned int f=0; f<numFaces; f+=interval )
+        {
+            mesh.checkFace(f);
+        }
+    }
+}
+
+/**
+	Used internally by the importers: enables the dirty tracking of the mesh
+    while it exists, and restores the previous state when it is destroyed,
+    also when the import throws.
+*/
+template <class MeshT>
+class DirtyTrackingScope
+{
+public:
+    explicit DirtyTrackingScope( MeshT& mesh ):
+        mesh(mesh),
+        dirtyTrackingEnabled(mesh.isDirtyTrackingEnabled())
+    {
+        this->mesh.setDirtyTrackingEnabled( true );
+    };
+
+    ~DirtyTrackingScope()
+    {
+        this->mesh.setDirtyTrackingEnabled( this->dirtyTrackingEnabled );
+    };
+
+private:
+    DirtyTrackingScope( const DirtyTrackingScope& );
+    DirtyTrackingScope& operator=( const DirtyTrackingScope& );
+
+    MeshT& mesh;
+    bool dirtyTrackingEnabled;
+};
+
+/**
+	Used internally by the importers. Creates the faces of the mesh from the
+    list of triangles (3 vertex IDs each), and checks the result as asked by
+    the options.
+
+    The vertices must have been created before. Returns true if each triangle
+    i became the face with ID=i, what only fails when VALIDATION_PER_FACE
+    delays some triangle. Throws if a triangle uses a vertex that does not
+    exist, or the same vertex twice.
+*/
+template <class MeshT>
+bool buildImportedMesh( MeshT& mesh, const uint32_t* indices, size_t triangleCount, const ImportOptions& options )
+{
+    if( options.validation==VALIDATION_PER_FACE )
+    {
+        // with the PointerStorage, no reallocation can happen
+        mesh.reserve( 0, 6*(unsigned int)triangleCount, (unsigned int)triangleCount );
+        bool facesInOrder = true;
+        {
+            DirtyTrackingScope<MeshT> dirtyTracking( mesh );
+            ValidationReport report;
+            const unsigned int numVertices = mesh.getNumVertices();
+            for( size_t t=0; t<triangleCount; ++t )
+            {
+                const uint32_t* triangle = &indices[3*t];
+                if( triangle[0]>=numVertices || triangle[1]>=numVertices || triangle[2]>=numVertices )
+                {
+                    throw cpp::Exception("A triangle references a vertex that does not exist");
+                }
+                if( triangle[0]==triangle[1] || triangle[1]==triangle[2] || triangle[2]==triangle[0] )
+                {
+                    throw cpp::Exception("A triangle cannot use the same vertex twice");
+                }
+                unsigned int fid = mesh.createTriangularFace( triangle[0], triangle[1], triangle[2] );
+                facesInOrder = facesInOrder && fid==t;
+                if( fid!=MESH_NULL_ID )
+                {
+                    mesh.validateDirty( report );
+                    report.throwIfInvalid();
+                }
+            }
+            std::cerr << "  + " << mesh.getNumUnhandledTriangles() << " bad triangles" << std::endl;
+            mesh.manageUnhandledTriangles();
+        }
+        checkImportedMesh( mesh, options );
+        return facesInOrder;
+    }
+
+    mesh.buildFromTriangles( indices, triangleCount );
+    checkImportedMesh( mesh, options );
+    return true;
+}
+
+#endif//ImportOptions_h
@@ -0,0 +1,35 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file 
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_IntTypes_h
+#define DCEL_IntTypes_h
+
+/**
+    The fixed width integer types used by the binary formats and the
+    storages. Visual Studio 2008 and older have no <stdint.h>, so they are
+    defined from the Microsoft sized types there.
+*/
+#if defined(_MSC_VER) && _MSC_VER < 1600
+
+typedef signed __int8 int8_t;
+typedef unsigned __int8 uint8_t;
+typedef signed __int16 int16_t;
+typedef unsigned __int16 uint16_t;
+typedef signed __int32 int32_t;
+typedef unsigned __int32 uint32_t;
+typedef signed __int64 int64_t;
+typedef unsigned __int64 uint64_t;
+
+#else
+
+#include <stdint.h>
+
+#endif
+
+#endif//DCEL_IntTypes_h
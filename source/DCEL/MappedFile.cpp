@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+#include "Exception.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile():
+    data(NULL),
+    size(0),
+    opened(false)
+#ifdef _WIN32
+    ,fileHandle(INVALID_HANDLE_VALUE)
+    ,mappingHandle(NULL)
+#else
+    ,fileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+#ifdef _WIN32
+
+void MappedFile::open(const std::string& filename, AccessPattern access)
+{
+    this->close();
+
+    const DWORD flags = access==RANDOM_ACCESS? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    this->fileHandle = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL );
+    if( this->fileHandle==INVALID_HANDLE_VALUE )
+    {
+        throw cpp::Exception("Can't open the file '"+filename+"'");
+    }
+
+    LARGE_INTEGER fileSize;
+    if( !GetFileSizeEx( this->fileHandle, &fileSize ) )
+    {
+        this->close();
+        throw cpp::Exception("Can't get the size of the file '"+filename+"'");
+    }
+    this->size = (size_t)fileSize.QuadPart;
+    this->opened = true;
+
+    // an empty file can't be mapped, but it is a valid (empty) file
+    if( this->size>0 )
+    {
+        this->mappingHandle = CreateFileMappingA( this->fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+        if( this->mappingHandle!=NULL )
+        {
+            this->data = (const char*)MapViewOfFile( this->mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+        }
+        if( this->data==NULL )
+        {
+            this->close();
+            throw cpp::Exception("Can't map the file '"+filename+"'");
+        }
+    }
+}
+
+void MappedFile::release(size_t offset, size_t size)
+{
+    if( this->data==NULL || offset>=this->size )
+    {
+        return;
+    }
+    SYSTEM_INFO system;
+    GetSystemInfo( &system );
+    const size_t first = offset - offset%system.dwPageSize;
+    const size_t last = size<this->size-offset? offset+size : this->size;
+    const size_t end = last==this->size? last : last - last%system.dwPageSize;
+    if( end>first )
+    {
+        // unlocking pages that are not locked removes them from the
+        // working set
+        VirtualUnlock( (void*)(this->data+first), end-first );
+    }
+}
+
+void MappedFile::close()
+{
+    if( this->data!=NULL )
+    {
+        UnmapViewOfFile( this->data );
+    }
+    if( this->mappingHandle!=NULL )
+    {
+        CloseHandle( this->mappingHandle );
+    }
+    if( this->fileHandle!=INVALID_HANDLE_VALUE )
+    {
+        CloseHandle( this->fileHandle );
+    }
+    this->data = NULL;
+    this->size = 0;
+    this->opened = false;
+    this->mappingHandle = NULL;
+    this->fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+void MappedFile::open(const std::string& filename, AccessPattern access)
+{
+    this->close();
+
+    this->fileDescriptor = ::open( filename.c_str(), O_RDONLY );
+    if( this->fileDescriptor<0 )
+    {
+        throw cpp::Exception("Can't open the file '"+filename+"'");
+    }
+
+    struct stat status;
+    if( fstat( this->fileDescriptor, &status )!=0 )
+    {
+        this->close();
+        throw cpp::Exception("Can't get the size of the file '"+filename+"'");
+    }
+    this->size = (size_t)status.st_size;
+    this->opened = true;
+
+    // an empty file can't be mapped, but it is a valid (empty) file
+    if( this->size>0 )
+    {
+        void* address = mmap( NULL, this->size, PROT_READ, MAP_PRIVATE, this->fileDescriptor, 0 );
+        if( address==MAP_FAILED )
+        {
+            this->close();
+            throw cpp::Exception("Can't map the file '"+filename+"'");
+        }
+        madvise( address, this->size, access==RANDOM_ACCESS? MADV_RANDOM : MADV_SEQUENTIAL );
+        this->data = (const char*)address;
+    }
+}
+
+void MappedFile::release(size_t offset, size_t size)
+{
+    if( this->data==NULL || offset>=this->size )
+    {
+        return;
+    }
+    const size_t pageSize = (size_t)sysconf( _SC_PAGESIZE );
+    const size_t first = offset - offset%pageSize;
+    const size_t last = size<this->size-offset? offset+size : this->size;
+    const size_t end = last==this->size? last : last - last%pageSize;
+    if( end>first )
+    {
+        // the mapping is private and never written, so its pages are just
+        // dropped, and read again from the file if needed
+        madvise( (void*)(this->data+first), end-first, MADV_DONTNEED );
+    }
+}
+
+void MappedFile::close()
+{
+    if( this->data!=NULL )
+    {
+        munmap( (void*)this->data, this->size );
+    }
+    if( this->fileDescriptor>=0 )
+    {
+        ::close( this->fileDescriptor );
+    }
+    this->data = NULL;
+    this->size = 0;
+    this->opened = false;
+    this->fileDescriptor = -1;
+}
+
+#endif
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include <string>
+#include <cstddef>
+
+/**
+	A file mapped in memory for reading. The bytes of the file are available
+    in getData() without being copied, and are loaded by the operating system
+    as they are accessed.
+
+    The file is unmapped by close() or by the destructor, and the pointers to
+    its bytes are not valid after that.
+*/
+class MappedFile
+{
+public:
+
+    /**
+    	How the bytes of the file will be read. It is given to the operating
+        system as a hint: a sequential file is read ahead and its pages are
+        dropped after they are read, while only the pages touched in a random
+        access file are loaded.
+    */
+    enum AccessPattern
+    {
+        SEQUENTIAL_ACCESS,
+        RANDOM_ACCESS
+    };
+
+    MappedFile();
+
+    ~MappedFile();
+
+    /**
+    	Maps the whole file. Throws a cpp::Exception if the file can't be
+        opened or mapped.
+    */
+    void open(const std::string& filename, AccessPattern access = SEQUENTIAL_ACCESS);
+
+    void close();
+
+    /**
+    	Tells the system that the bytes in [offset, offset+size) won't be read
+        again soon, so their pages can leave the memory of the process. The
+        bytes are still valid: a page that is touched again is read back from
+        the file. Only the whole pages in the range are released, but the
+        range starts at the beginning of the page of offset.
+    */
+    void release(size_t offset, size_t size);
+
+    inline bool isOpen() const
+    {
+        return this->opened;
+    };
+
+    /**
+    	The first byte of the file. It is NULL for an empty file.
+    */
+    inline const char* getData() const
+    {
+        return this->data;
+    };
+
+    inline size_t getSize() const
+    {
+        return this->size;
+    };
+
+protected:
+private:
+
+    // a mapping can't be shared
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* data;
+    size_t size;
+    bool opened;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+};
+
+#endif//MappedFile_h
@@ -11,32 +11,47 @@
 #define DCEL_Mesh_h
 
 #include <vector>
-#include <list>
 #include <limits>
+#include <algorithm>
 
-#include "Vertex.h"
-#include "Face.h"
-#include "HalfEdge.h"
+#include "IntTypes.h"
+#include "MeshStorage.h"
 #include "EdgeIterator.h"
+#include "Circulators.h"
+#include "HalfEdgeIndex.h"
+#include "AttributeSet.h"
+#include "MeshValidator.h"
+#include "VertexAdjacency.h"
+#include "MeshPermutation.h"
 
 #include "Exception.h"
 
-#define MESH_NULL_ID (std::numeric_limits<unsigned int>::max())
-
 /**
 	A class that stores the mesh structure. It the list of the vertices, edges and faces.
     Also, it has some methods for simplify the mesh manipulation.
+
+    The last template parameter selects how the connections between the
+    elements are stored (see MeshStorage.h). The EdgeIterator needs the
+    PointerStorage, and the methods that take or return pointers to the
+    elements don't work with the SoAStorage. The other methods, and the ones
+    inherited from the MeshStorage, work with any storage.
+
+    The circulators of Circulators.h (vertexNeighbours, faceVertices, ...)
+    walk around the vertices and faces with the IDs, and work with any
+    storage. They replace the deprecated EdgeIterator and EdgeIdIterator.
 */
-template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
-class Mesh
+template<class VertexDataT, class HalfEdgeDataT, class FaceDataT, class StorageT = PointerStorage>
+class Mesh: public MeshStorage<VertexDataT, HalfEdgeDataT, FaceDataT, StorageT>
 {
-	typedef Mesh<VertexDataT, HalfEdgeDataT, FaceDataT> MeshT;
+	typedef Mesh<VertexDataT, HalfEdgeDataT, FaceDataT, StorageT> MeshT;
+    typedef MeshStorage<VertexDataT, HalfEdgeDataT, FaceDataT, StorageT> Storage;
 public:
 
-    typedef VertexT<VertexDataT, HalfEdgeDataT, FaceDataT> Vertex;
-    typedef HalfEdgeT<VertexDataT, HalfEdgeDataT, FaceDataT> HalfEdge;
-    typedef FaceT<VertexDataT, HalfEdgeDataT, FaceDataT> Face;
+    typedef typename Storage::Vertex Vertex;
+    typedef typename Storage::HalfEdge HalfEdge;
+    typedef typename Storage::Face Face;
     typedef EdgeIteratorT<VertexDataT, HalfEdgeDataT, FaceDataT> EdgeIterator;
+    typedef EdgeIdIteratorT<MeshT> EdgeIdIterator;
 
     typedef VertexDataT VertexData;
     typedef HalfEdgeDataT HalfEdgeData;
@@ -65,6 +80,12 @@ public:
     */
     unsigned int createFace( HalfEdge* bound );
 
+    /**
+    	Create a face, that has its boundary set to the half-edge with the
+        given ID (that may be MESH_NULL_ID).
+    */
+    unsigned int createFace( unsigned int boundId );
+
     /**
         Create an edge between the vertex origin and twinOrigin. Return the
         ID of the half-edge that has origin as its origin vertex.
@@ -77,6 +98,12 @@ public:
     */
     unsigned int createEdge( Vertex* origin, Face* face, Vertex* twinOrigin, Face* twinFace );
 
+    /**
+    	The same as above, using the IDs of the vertices and faces. The faces
+        may be MESH_NULL_ID.
+    */
+    unsigned int createEdge( unsigned int originId, unsigned int faceId, unsigned int twinOriginId, unsigned int twinFaceId );
+
     /**
         Adds a new face to the mesh. The face is bounded by previously
         added vertices, that are identified by the given IDs.
@@ -88,6 +115,92 @@ public:
     */
     unsigned int createTriangularFace(unsigned int vId1, unsigned int vId2, unsigned int vId3);
 
+    /**
+    	Adds a new face bounded by the given vertices (at least 3), in CCW
+        order. Triangles are given to createTriangularFace.
+
+        Like the triangles, a polygon that can't be inserted yet (because one
+        of its vertices has more than one border, or one of its edges already
+        has a face on that side) is delayed to manageUnhandledTriangles, and
+        MESH_NULL_ID is returned.
+
+    	Returns the id of the created face.
+    */
+    unsigned int createPolygonFace(const uint32_t* vertexIds, unsigned int vertexCount);
+
+    /**
+        Builds the whole mesh structure from a list of triangles. Each 3 values
+        of 'indices' are the IDs of the vertices of one triangle, in CCW order,
+        and the triangle i becomes the face with ID=i.
+
+        The vertices must have been added to the mesh before. Any previous face
+        and half-edge is discarded.
+
+        Differently from createTriangularFace, the order of the triangles
+        doesn't matter and no triangle is delayed: the sides of all triangles
+        are sorted to find the twin half-edges, and after that the half-edges
+        on the border are linked. Its cost is linear on the number of triangles
+        (plus the sort).
+
+        Throws a cpp::Exception if an edge is shared by more than two triangles,
+        or if two triangles that share an edge have different orientations.
+    */
+    void buildFromTriangles(const uint32_t* indices, size_t triangleCount);
+
+    /**
+    	Builds the mesh from triangles that arrive in parts, as a file is
+        read: beginTriangles discards the faces and half-edges, each
+        addTriangles call creates the faces of its triangles (in order, after
+        the faces of the previous calls), and endTriangles links the
+        half-edges on the border. The triangleCount given to beginTriangles
+        is the expected number of triangles, used to reserve memory.
+
+        Each side of a triangle is paired with the opposite side of a
+        triangle added before, found in a hash table of the edges created
+        since beginTriangles, so the order of the triangles doesn't matter and no
+        triangle is delayed. Until endTriangles, the mesh is not valid.
+
+        The vertices must have been added before the triangles that use them.
+        With the PointerStorage, reserve room for 6 half-edges per triangle
+        before beginTriangles. Throws a cpp::Exception for the same errors as
+        buildFromTriangles.
+    */
+    void beginTriangles(size_t triangleCount = 0);
+    void addTriangles(const uint32_t* indices, size_t triangleCount);
+    void endTriangles();
+
+    /**
+    	Reserves memory for the given number of elements.
+
+        With the PointerStorage, the elements are referenced by their
+        addresses, so the lists must have room for all the half-edges and
+        faces before the first face is created.
+    */
+    void reserve(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces);
+
+    /**
+    	Discards all elements, and creates the given number of vertices,
+        half-edges and faces, with no connections between them. All their IDs
+        must be set after, with the set* methods.
+
+        Used by the readers that restore the whole connectivity at once (like
+        DCELStream::readBinary). The half-edge index is not updated.
+    */
+    void resize(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces);
+
+    /**
+    	Moves each element (with its data and attributes) to the new ID given
+        by the permutation, and updates all the IDs that point to it. The
+        mesh is the same after, only its IDs change. See MeshReorder, that
+        finds an order where the neighbour elements are close in memory.
+
+        The half-edge index, the adjacency and the delayed faces are updated.
+        The pointers to the elements are not valid after this. Throws a
+        cpp::Exception, without changing the mesh, if the permutation is not
+        valid for this mesh (see MeshPermutation::isValid).
+    */
+    void permute(const MeshPermutation& permutation);
+
     /**
     	Returns a pointer to the given vertex ID.
     */
@@ -178,10 +291,19 @@ public:
         has vertexB as 'target' (edge->twin->origin).
 
         Returns NULL if this edge doesn't exist.
+
+        If the half-edge index is enabled, this is a hash table lookup.
+        Otherwise, the edges around vertexA are visited.
     */
     HalfEdge* getHalfEdge( Vertex* vertexA, Vertex* vertexB ) const;
     HalfEdge* getHalfEdge( unsigned int vertexIdA, unsigned int vertexIdB) const;
 
+    /**
+    	The same as getHalfEdge(vertexIdA, vertexIdB), but returns the ID of
+        the half-edge, or MESH_NULL_ID if it doesn't exist.
+    */
+    unsigned int findHalfEdge( unsigned int originId, unsigned int targetId ) const;
+
     /**
     	Returns the ID of a given halfEdge.
     */
@@ -195,11 +317,130 @@ public:
     unsigned int getNumHalfEdges() const;
 
     /**
-    	Iterate through all faces, calling the checkFace() method
-        to check if that face is consistent.
+    	Enables or disables the half-edge index, a hash table that maps each
+        pair of (origin, target) vertices to its half-edge. When enabled,
+        getHalfEdge(vertexA, vertexB) doesn't depend on the number of edges
+        around vertexA anymore, at the cost of about 24 bytes per half-edge.
+
+        Enabling it builds the index from the current half-edges. After that,
+        it is kept up to date by createEdge and buildFromTriangles. If the
+        origin of a half-edge is changed directly (with HalfEdge::setOrigin or
+        setHalfEdgeOrigin), the index must be disabled and enabled again.
+
+        It starts disabled.
+    */
+    void setHalfEdgeIndexEnabled(bool enabled);
+
+    bool isHalfEdgeIndexEnabled() const;
+
+    /**
+    	The same as the methods of the MeshStorage, but when the dirty
+        tracking is enabled, the changed elements (and the ones that were
+        connected to them) are recorded to be checked by validateDirty.
+    */
+    inline void setVertexIncidentEdge(unsigned int vertexId, unsigned int halfEdgeId);
+    inline void setFaceBoundary(unsigned int faceId, unsigned int halfEdgeId);
+    inline void setHalfEdgeTwin(unsigned int halfEdgeId, unsigned int twinId);
+    inline void setHalfEdgeNext(unsigned int halfEdgeId, unsigned int nextId);
+    inline void setHalfEdgePrev(unsigned int halfEdgeId, unsigned int prevId);
+    inline void setHalfEdgeOrigin(unsigned int halfEdgeId, unsigned int vertexId);
+    inline void setHalfEdgeFace(unsigned int halfEdgeId, unsigned int faceId);
+
+    /**
+    	Enables or disables the dirty tracking. When enabled, every change
+        made by the methods of the mesh (createEdge, createFace, the
+        create*Face methods and the set* methods above) records the elements
+        it touches, and validateDirty checks only the region around them.
+
+        The mesh is assumed to be valid when the tracking is enabled. The
+        changes made through the Vertex, HalfEdge and Face objects (like
+        HalfEdge::setNext) are not recorded. The methods that rebuild the
+        whole mesh (buildFromTriangles, resize) make the next validateDirty
+        check everything.
+
+        It starts disabled.
+    */
+    void setDirtyTrackingEnabled(bool enabled);
+
+    bool isDirtyTrackingEnabled() const;
+
+    /**
+    	Checks the elements changed since the last call (or since the tracking
+        was enabled), their neighbours and the rings of their vertices, and
+        forgets them. Its cost depends on the size of the changes, not on the
+        size of the mesh, so it can be called after each edit.
+
+        Only the violations at the elements of that region are reported. A
+        change that breaks the ring of a vertex, for example, is reported at
+        the changed half-edges, but not at the other half-edges of the ring
+        that can't be reached anymore, so the report can be shorter than the
+        one of validate().
+
+        If the tracking is disabled, the whole mesh is checked, as by
+        validate().
+    */
+    void validateDirty(ValidationReport& report);
+
+    /**
+    	Returns the neighbours and the outgoing half-edges of all vertices in
+        contiguous arrays (see VertexAdjacency). It is built by the first call
+        and kept until the connections of the mesh change, so the passes that
+        only read the mesh can call it as many times as they want.
+
+        The changes made by the methods of the mesh (createVertex, createEdge,
+        the create*Face methods, buildFromTriangles, setHalfEdgeOrigin,
+        setHalfEdgeTwin, ...) discard it. The changes made through the Vertex
+        and HalfEdge objects are not seen: call invalidateAdjacency() after
+        them. The first call after a change must not be made by two threads
+        at the same time.
+    */
+    const VertexAdjacency& getAdjacency() const;
+
+    /**
+    	Discards the adjacency returned by getAdjacency(), that will be built
+        again by its next call.
+    */
+    void invalidateAdjacency();
+
+    /**
+    	Returns the attributes of the vertices: named arrays with one value
+        for each vertex, stored apart from the vertices. Use them for the data
+        that is needed only by some passes, instead of putting it on the
+        VertexDataT. See AttributeSet.
+
+        The channels grow with the mesh. If vertices were added directly to
+        the list returned by getVertices(), the channels are resized by the
+        non-const version of this method.
+    */
+    AttributeSet& getVertexAttributes();
+    const AttributeSet& getVertexAttributes() const;
+
+    /**
+    	The same as getVertexAttributes(), with one value for each half-edge.
+    */
+    AttributeSet& getHalfEdgeAttributes();
+    const AttributeSet& getHalfEdgeAttributes() const;
+
+    /**
+    	The same as getVertexAttributes(), with one value for each face.
+    */
+    AttributeSet& getFaceAttributes();
+    const AttributeSet& getFaceAttributes() const;
+
+    /**
+    	Checks the whole mesh with a MeshValidator, and throws a
+        cpp::Exception with the first violation found (the one of the
+        element with the smallest ID).
     */
     void checkAllFaces() const;
 
+    /**
+    	Checks all the invariants of the mesh using up to threadCount threads
+        (0 for one per core), and fills the report with all the elements that
+        break them. See MeshValidator.
+    */
+    void validate(ValidationReport& report, unsigned int threadCount = 0) const;
+
     /**
         A helper method used to test some assumed conditions about the DCEL. 
         
@@ -224,10 +465,14 @@ public:
         how the pointers connects the vertices, edges and faces.
         In these cases, these triangles are not inserted into the mesh,
         but are delayed to be inserted when there is no ambiguity in its
-        insertion. This method tries to insert these triangles.
+        insertion. This method tries to insert these triangles (and the
+        delayed polygons).
     */
     void manageUnhandledTriangles();
 
+    /**
+    	Returns the number of delayed faces, triangles or not.
+    */
     int getNumUnhandledTriangles() const;
 
     /**
@@ -236,24 +481,149 @@ public:
     */
     HalfEdge* findIncidentHalfEdge(Vertex* vertex);
 
+    /**
+    	The same as above, using IDs. Returns MESH_NULL_ID if there is no
+        such half-edge.
+    */
+    unsigned int findIncidentHalfEdge(unsigned int vertexId) const;
+
     /**
     	Clear the entire mesh, releasing the vertices, faces and half-edges.
     */
     void clear();
 
-    const std::list<int>& getUnhandledTriangles() const
+    /**
+    	Returns the faces that were not inserted yet. Each face is stored as
+        its number of vertices, followed by the vertex IDs.
+    */
+    const std::vector<unsigned int>& getUnhandledFaces() const
     {
-        return this->unhandledTriangles;
+        return this->unhandledFaces;
     }
 
 protected:
 private:
-    std::vector<Vertex> vertices;
-    std::vector<Face> faces;
-    std::vector<HalfEdge> edges;
 
-    std::list<int> unhandledTriangles;
-    unsigned int unhandledTrianglesCount;
+    /**
+        A side of a triangle given to buildFromTriangles. The key is made
+        from the two vertex IDs of the side, with the smaller one first.
+    */
+    struct TriangleSide
+    {
+        uint64_t key;
+        uint32_t corner;
+
+        inline bool operator<(const TriangleSide& other) const
+        {
+            return key<other.key || (key==other.key && corner<other.corner);
+        }
+    };
+
+    /**
+        Sets the next and prev pointers of every half-edge that has no face
+        and no next half-edge yet, closing the borders of the mesh.
+
+        The half-edge that follows a border half-edge is the border half-edge
+        found when rotating around its target vertex, starting at its twin.
+        When a vertex is touched by more than one border (two fans of triangles
+        sharing only that vertex), the borders are chained one after the other,
+        so all edges of the vertex are still reachable by an EdgeIterator.
+    */
+    void linkBorderHalfEdges();
+
+    /**
+    	Fills the half-edge index with all the half-edges of the mesh.
+    */
+    void buildHalfEdgeIndex();
+
+    typedef unsigned int (MeshT::*IdGetter)(unsigned int) const;
+    typedef void (MeshT::*IdSetter)(unsigned int, unsigned int);
+
+    typedef unsigned int (MeshPermutation::*NewIdGetter)(unsigned int) const;
+
+    /**
+    	Used by permute: reads one ID of each element into the position of
+        its new ID, changed to the new ID of the element it points to.
+    */
+    void gatherIds(const std::vector<unsigned int>& newIds, IdGetter getter,
+        const MeshPermutation& permutation, NewIdGetter getNewId, std::vector<unsigned int>& ids) const;
+
+    /**
+    	Gives ids[i] to the setter of each element i.
+    */
+    void setIds(IdSetter setter, const std::vector<unsigned int>& ids);
+
+    /**
+    	Inserts a polygon with 4 or more vertices, linking its new half-edges
+        with the borders around its vertices. Returns MESH_NULL_ID (without
+        changing the mesh) if the polygon can't be inserted yet.
+    */
+    unsigned int insertPolygonFace(const uint32_t* vertexIds, unsigned int vertexCount);
+
+    /**
+    	Returns true if there is a half-edge without a face arriving at the
+        vertex.
+    */
+    bool isBorderVertex(unsigned int vertexId) const;
+
+    /**
+    	Adds a face to the list of faces that will be inserted by
+        manageUnhandledTriangles.
+    */
+    void delayFace(const uint32_t* vertexIds, unsigned int vertexCount);
+
+    std::vector<unsigned int> unhandledFaces;
+    unsigned int unhandledFacesCount;
+
+    /**
+    	The faces being retried by manageUnhandledTriangles. It is kept
+        between calls, like unhandledFaces, so their memory is reused.
+    */
+    std::vector<unsigned int> retriedFaces;
+
+    /**
+    	Used by insertPolygonFace, and kept to reuse their memory: the
+        half-edge from each vertex to the next one, if it is new, the border
+        half-edge arriving at each vertex, and the next pointers to be set.
+    */
+    std::vector<unsigned int> polygonEdges;
+    std::vector<char> polygonNewEdges;
+    std::vector<unsigned int> polygonGaps;
+    std::vector< std::pair<unsigned int, unsigned int> > polygonLinks;
+
+    HalfEdgeIndex halfEdgeIndex;
+    bool halfEdgeIndexEnabled;
+
+    /**
+    	Used by addTriangles: the first half-edge of each edge created since
+        beginTriangles, by the smaller and the larger ID of its vertices.
+    */
+    HalfEdgeIndex triangleSides;
+
+    inline void markDirtyVertex(unsigned int vertexId);
+    inline void markDirtyHalfEdge(unsigned int halfEdgeId);
+    inline void markDirtyFace(unsigned int faceId);
+
+    /**
+    	The elements changed since the last validateDirty, with repetitions.
+        When allDirty is true, the lists are not used anymore, as the whole
+        mesh will be checked.
+    */
+    std::vector<unsigned int> dirtyVertices;
+    std::vector<unsigned int> dirtyHalfEdges;
+    std::vector<unsigned int> dirtyFaces;
+    bool dirtyTrackingEnabled;
+    bool allDirty;
+
+    /**
+    	The cache of getAdjacency(), valid only while adjacencyValid is true.
+    */
+    mutable VertexAdjacency adjacency;
+    mutable bool adjacencyValid;
+
+    AttributeSet vertexAttributes;
+    AttributeSet halfEdgeAttributes;
+    AttributeSet faceAttributes;
 };
 
 
@@ -262,154 +632,174 @@ private:
 //////////////////////////////////////////////////////////////////////////
 
 
-template<class Vdt, class Hdt, class Fdt>
-Mesh<Vdt,Hdt,Fdt>::Mesh():
-    unhandledTrianglesCount(0)
+template<class Vdt, class Hdt, class Fdt, class St>
+Mesh<Vdt,Hdt,Fdt,St>::Mesh():
+    unhandledFacesCount(0),
+    halfEdgeIndexEnabled(false),
+    dirtyTrackingEnabled(false),
+    allDirty(false),
+    adjacencyValid(false)
 {
 };
 
-template<class Vdt, class Hdt, class Fdt>
-Mesh<Vdt,Hdt,Fdt>::~Mesh()
+template<class Vdt, class Hdt, class Fdt, class St>
+Mesh<Vdt,Hdt,Fdt,St>::~Mesh()
 {
     this->clear();
 };
 
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::createVertex( )
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::createVertex( )
 {
-    this->vertices.push_back( Vertex() );
-    return this->vertices.size()-1;
+    unsigned int vertexId = this->addVertex();
+    this->vertexAttributes.resize( vertexId+1 );
+    this->adjacencyValid = false;
+    return vertexId;
 };
 
-template<class Vdt, class Hdt, class Fdt>
-VertexT<Vdt,Hdt,Fdt>* Mesh<Vdt,Hdt,Fdt>::createGetVertex( )
+template<class Vdt, class Hdt, class Fdt, class St>
+typename Mesh<Vdt,Hdt,Fdt,St>::Vertex* Mesh<Vdt,Hdt,Fdt,St>::createGetVertex( )
 {
-    this->vertices.push_back( Vertex() );
-    return &this->vertices.back();
+    return this->getVertex( this->createVertex() );
 };
 
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::createFace( HalfEdge* bound )
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::createFace( HalfEdge* bound )
 {
-    unsigned int faceId = this->faces.size();
-    this->faces.push_back( Face() );
-    Face* face = &(faces[faceId]);
-    face->setBoundary( bound );
+    return this->createFace( bound==NULL? MESH_NULL_ID : this->getHalfEdgeId(bound) );
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::createFace( unsigned int boundId )
+{
+    unsigned int faceId = this->addFace();
+    this->faceAttributes.resize( faceId+1 );
+    this->setFaceBoundary( faceId, boundId );
     return faceId;
 };
 
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::createEdge( Vertex* origin, Face* face, Vertex* twinOrigin, Face* twinFace )
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::createEdge( Vertex* origin, Face* face, Vertex* twinOrigin, Face* twinFace )
+{
+    return this->createEdge(
+        origin==NULL? MESH_NULL_ID : this->getVertexId(origin),
+        face==NULL? MESH_NULL_ID : this->getFaceId(face),
+        twinOrigin==NULL? MESH_NULL_ID : this->getVertexId(twinOrigin),
+        twinFace==NULL? MESH_NULL_ID : this->getFaceId(twinFace) );
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::createEdge( unsigned int originId, unsigned int faceId, unsigned int twinOriginId, unsigned int twinFaceId )
 {
-    unsigned int edgeId = this->edges.size();
-    this->edges.push_back( HalfEdge() );
-    HalfEdge* e1 = &this->edges[edgeId];
-    e1->setOrigin( origin );
-    e1->setFace( face );
+    unsigned int edgeId = this->addHalfEdgePair();
+    this->halfEdgeAttributes.resize( edgeId+2 );
+    this->setHalfEdgeOrigin( edgeId, originId );
+    this->setHalfEdgeFace( edgeId, faceId );
 
-    this->edges.push_back( HalfEdge() );
-    HalfEdge* e2 = &this->edges[edgeId+1];
-    e2->setOrigin( twinOrigin );
-    e2->setFace( twinFace );
+    this->setHalfEdgeOrigin( edgeId+1, twinOriginId );
+    this->setHalfEdgeFace( edgeId+1, twinFaceId );
 
-    e1->setTwin(e2);
+    this->setHalfEdgeTwin( edgeId, edgeId+1 );
+
+    if( this->halfEdgeIndexEnabled )
+    {
+        this->halfEdgeIndex.insert( originId, twinOriginId, edgeId );
+        this->halfEdgeIndex.insert( twinOriginId, originId, edgeId+1 );
+    }
 
     return edgeId;
 };
 
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::createTriangularFace(unsigned int vId1, unsigned int vId2, unsigned int vId3)
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::createTriangularFace(unsigned int vId1, unsigned int vId2, unsigned int vId3)
 {
-    Vertex* v1 = this->getVertex(vId1);
-    Vertex* v2 = this->getVertex(vId2);
-    Vertex* v3 = this->getVertex(vId3);
-    HalfEdge* e1 = this->getHalfEdge(v1, v2);
-    HalfEdge* e2 = this->getHalfEdge(v2, v3);
-    HalfEdge* e3 = this->getHalfEdge(v3, v1);
+    unsigned int v1 = vId1;
+    unsigned int v2 = vId2;
+    unsigned int v3 = vId3;
+    unsigned int e1 = this->findHalfEdge(v1, v2);
+    unsigned int e2 = this->findHalfEdge(v2, v3);
+    unsigned int e3 = this->findHalfEdge(v3, v1);
 
     int unusedVertices = 0;
-    if (v1->getIncidentEdge()==NULL) unusedVertices++;
-    if (v2->getIncidentEdge()==NULL) unusedVertices++;
-    if (v3->getIncidentEdge()==NULL) unusedVertices++;
+    if (this->getVertexIncidentEdge(v1)==MESH_NULL_ID) unusedVertices++;
+    if (this->getVertexIncidentEdge(v2)==MESH_NULL_ID) unusedVertices++;
+    if (this->getVertexIncidentEdge(v3)==MESH_NULL_ID) unusedVertices++;
 
     int readyEdges = 0;
-    if (e1!=NULL) readyEdges++;
-    if (e2!=NULL) readyEdges++;
-    if (e3!=NULL) readyEdges++;
+    if (e1!=MESH_NULL_ID) readyEdges++;
+    if (e2!=MESH_NULL_ID) readyEdges++;
+    if (e3!=MESH_NULL_ID) readyEdges++;
 
-    unsigned int nullFaceId = MESH_NULL_ID;
-    unsigned int faceId = nullFaceId;
-    Face* face = NULL;
+    unsigned int faceId = MESH_NULL_ID;
 
     //the most simple case, all vertices has degree 0
     //create 3 edges, and link then
     if ( unusedVertices==3 && readyEdges==0 )
     {
-        faceId = createFace( NULL );
-        face = getFace( faceId );
+        faceId = createFace( MESH_NULL_ID );
 
-        e1 = getHalfEdge( createEdge( v1, face, v2, NULL ) );
-        v1->setIncidentEdge( e1 );
-        face->setBoundary( e1 );
+        e1 = createEdge( v1, faceId, v2, MESH_NULL_ID );
+        this->setVertexIncidentEdge( v1, e1 );
+        this->setFaceBoundary( faceId, e1 );
 
-        e2 = getHalfEdge( createEdge( v2, face, v3, NULL ) );
-        v2->setIncidentEdge( e2 );
+        e2 = createEdge( v2, faceId, v3, MESH_NULL_ID );
+        this->setVertexIncidentEdge( v2, e2 );
 
-        e3 = getHalfEdge(createEdge( v3, face, v1, NULL ) );
-        v3->setIncidentEdge( e3 );
+        e3 = createEdge( v3, faceId, v1, MESH_NULL_ID );
+        this->setVertexIncidentEdge( v3, e3 );
 
-        e1->setNext( e2 );
-        e2->setNext( e3 );
-        e3->setNext( e1 );
+        this->setHalfEdgeNext( e1, e2 );
+        this->setHalfEdgeNext( e2, e3 );
+        this->setHalfEdgeNext( e3, e1 );
 
-        e1->getTwin()->setNext( e3->getTwin() );
-        e3->getTwin()->setNext( e2->getTwin() );
-        e2->getTwin()->setNext( e1->getTwin() );
+        this->setHalfEdgeNext( this->getHalfEdgeTwin(e1), this->getHalfEdgeTwin(e3) );
+        this->setHalfEdgeNext( this->getHalfEdgeTwin(e3), this->getHalfEdgeTwin(e2) );
+        this->setHalfEdgeNext( this->getHalfEdgeTwin(e2), this->getHalfEdgeTwin(e1) );
     }
 
     //there are one vertex that has been used by another triangle.
     //Create the 3 edges, and link to the old triangle.
     else if( unusedVertices==2 && readyEdges==0 )
     {
-        if( v2->getIncidentEdge()!=NULL )
+        if( this->getVertexIncidentEdge(v2)!=MESH_NULL_ID )
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v2;
             v2 = v3;
             v3 = vt;
         }
-        else if( v3->getIncidentEdge()!=NULL )
+        else if( this->getVertexIncidentEdge(v3)!=MESH_NULL_ID )
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v3;
             v3 = v2;
             v2 = vt;
         }
-        HalfEdge* ei1 = findIncidentHalfEdge( v1 );
-        if( ei1!=NULL )
+        unsigned int ei1 = findIncidentHalfEdge( v1 );
+        if( ei1!=MESH_NULL_ID )
         {
-            HalfEdge* ei1n = ei1->getNext();
+            unsigned int ei1n = this->getHalfEdgeNext(ei1);
+            unsigned int ei1f = this->getHalfEdgeFace(ei1);
 
-            faceId = createFace( NULL );
-            face = getFace( faceId );
+            faceId = createFace( MESH_NULL_ID );
 
-            e1 = getHalfEdge( createEdge( v1, face, v2, ei1->getFace() ) );
-            face->setBoundary( e1 );
+            e1 = createEdge( v1, faceId, v2, ei1f );
+            this->setFaceBoundary( faceId, e1 );
 
-            e2 = getHalfEdge( createEdge( v2, face, v3, ei1->getFace() ) );
-            v2->setIncidentEdge( e2 );
+            e2 = createEdge( v2, faceId, v3, ei1f );
+            this->setVertexIncidentEdge( v2, e2 );
 
-            e3 = getHalfEdge(createEdge( v3, face, v1, ei1->getFace() ) );
-            v3->setIncidentEdge( e3 );
+            e3 = createEdge( v3, faceId, v1, ei1f );
+            this->setVertexIncidentEdge( v3, e3 );
 
-            e1->setNext( e2 );
-            e2->setNext( e3 );
-            e3->setNext( e1 );
+            this->setHalfEdgeNext( e1, e2 );
+            this->setHalfEdgeNext( e2, e3 );
+            this->setHalfEdgeNext( e3, e1 );
 
-            ei1->setNext( e3->getTwin() );
-            e3->getTwin()->setNext( e2->getTwin() );
-            e2->getTwin()->setNext( e1->getTwin() );
-            e1->getTwin()->setNext( ei1n );
+            this->setHalfEdgeNext( ei1, this->getHalfEdgeTwin(e3) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e3), this->getHalfEdgeTwin(e2) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e2), this->getHalfEdgeTwin(e1) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e1), ei1n );
         }
     }
 
@@ -417,48 +807,47 @@ unsigned int Mesh<Vdt,Hdt,Fdt>::createTriangularFace(unsigned int vId1, unsigned
     //one vertex doesn't have been used yet.
     else if( unusedVertices==1 && readyEdges==0 )
     {
-        if( v3->getIncidentEdge()==NULL )
+        if( this->getVertexIncidentEdge(v3)==MESH_NULL_ID )
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v2;
             v2 = v3;
             v3 = vt;
         }
-        else if( v1->getIncidentEdge()==NULL )
+        else if( this->getVertexIncidentEdge(v1)==MESH_NULL_ID )
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v3;
             v3 = v2;
             v2 = vt;
         }
 
-        HalfEdge* ei1 = findIncidentHalfEdge( v1 );
-        HalfEdge* ei3 = findIncidentHalfEdge( v3 );
-        if( ei1!=NULL && ei3!=NULL )
+        unsigned int ei1 = findIncidentHalfEdge( v1 );
+        unsigned int ei3 = findIncidentHalfEdge( v3 );
+        if( ei1!=MESH_NULL_ID && ei3!=MESH_NULL_ID )
         {
-            HalfEdge* ei1n = ei1->getNext();
-            HalfEdge* ei3n = ei3->getNext();
+            unsigned int ei1n = this->getHalfEdgeNext(ei1);
+            unsigned int ei3n = this->getHalfEdgeNext(ei3);
 
-            faceId = createFace( NULL );
-            face = getFace( faceId );
+            faceId = createFace( MESH_NULL_ID );
 
-            e1 = getHalfEdge( createEdge( v1, face, v2, ei1n->getFace() ) );
-            e2 = getHalfEdge( createEdge( v2, face, v3, ei3->getFace() ) );
-            e3 = getHalfEdge(createEdge( v3, face, v1, ei1->getFace() ) );
+            e1 = createEdge( v1, faceId, v2, this->getHalfEdgeFace(ei1n) );
+            e2 = createEdge( v2, faceId, v3, this->getHalfEdgeFace(ei3) );
+            e3 = createEdge( v3, faceId, v1, this->getHalfEdgeFace(ei1) );
 
-            face->setBoundary( e1 );
-            v2->setIncidentEdge( e2 );
+            this->setFaceBoundary( faceId, e1 );
+            this->setVertexIncidentEdge( v2, e2 );
 
-            e1->setNext( e2 );
-            e2->setNext( e3 );
-            e3->setNext( e1 );
+            this->setHalfEdgeNext( e1, e2 );
+            this->setHalfEdgeNext( e2, e3 );
+            this->setHalfEdgeNext( e3, e1 );
 
-            ei1->setNext( e3->getTwin() );
-            e3->getTwin()->setNext( ei3n );
+            this->setHalfEdgeNext( ei1, this->getHalfEdgeTwin(e3) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e3), ei3n );
 
-            ei3->setNext( e2->getTwin() );
-            e2->getTwin()->setNext( e1->getTwin() );
-            e1->getTwin()->setNext( ei1n );
+            this->setHalfEdgeNext( ei3, this->getHalfEdgeTwin(e2) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e2), this->getHalfEdgeTwin(e1) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e1), ei1n );
         }
     }
 
@@ -467,146 +856,143 @@ unsigned int Mesh<Vdt,Hdt,Fdt>::createTriangularFace(unsigned int vId1, unsigned
     else if (unusedVertices==1 && readyEdges==1)
     {
         //rotate pointers, so the v1 and v2 are connected, and v3 is unused
-        if (e2!=NULL)
+        if (e2!=MESH_NULL_ID)
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v2;
             v2 = v3;
             v3 = vt;
-            HalfEdge *et = e1;
+            unsigned int et = e1;
             e1 = e2;
             e2 = e3;
             e3 = et;
         }
-        else if (e3!=NULL)
+        else if (e3!=MESH_NULL_ID)
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v3;
             v3 = v2;
             v2 = vt;
-            HalfEdge* et = e1;
+            unsigned int et = e1;
             e1 = e3;
             e3 = e2;
             e2 = et;
         }
 
-        if (e1->getFace()==NULL)
+        if (this->getHalfEdgeFace(e1)==MESH_NULL_ID)
         {
-            HalfEdge* e1n = e1->getNext();
-            HalfEdge* e1p = e1->getPrev();
+            unsigned int e1n = this->getHalfEdgeNext(e1);
+            unsigned int e1p = this->getHalfEdgePrev(e1);
 
             faceId = createFace( e1 );
-            face = getFace( faceId );
 
-            e2 = getHalfEdge(createEdge( v2, face, v3, e1n->getFace() ) );
-            e3 = getHalfEdge(createEdge( v3, face, v1, e1p->getFace() ) );
+            e2 = createEdge( v2, faceId, v3, this->getHalfEdgeFace(e1n) );
+            e3 = createEdge( v3, faceId, v1, this->getHalfEdgeFace(e1p) );
 
-            e1->setFace( face );
-            v3->setIncidentEdge( e3 );
+            this->setHalfEdgeFace( e1, faceId );
+            this->setVertexIncidentEdge( v3, e3 );
 
-            e1->setNext( e2 );
-            e2->setNext( e3 );
-            e3->setNext( e1 );
+            this->setHalfEdgeNext( e1, e2 );
+            this->setHalfEdgeNext( e2, e3 );
+            this->setHalfEdgeNext( e3, e1 );
 
-            e1p->setNext( e3->getTwin() );
-            e3->getTwin()->setNext( e2->getTwin() );
-            e2->getTwin()->setNext( e1n );
+            this->setHalfEdgeNext( e1p, this->getHalfEdgeTwin(e3) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e3), this->getHalfEdgeTwin(e2) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e2), e1n );
         }
     }
 
-    //all the tree vertices are used by different triangles, no 
+    //all the tree vertices are used by different triangles, no
     //ready edge available.
     else if ( unusedVertices==0 && readyEdges==0 )
     {
-        HalfEdge* ei1 = findIncidentHalfEdge( v1 );
-        HalfEdge* ei2 = findIncidentHalfEdge( v2 );
-        HalfEdge* ei3 = findIncidentHalfEdge( v3 );
+        unsigned int ei1 = findIncidentHalfEdge( v1 );
+        unsigned int ei2 = findIncidentHalfEdge( v2 );
+        unsigned int ei3 = findIncidentHalfEdge( v3 );
 
-        if( ei1!=NULL && ei2!=NULL && ei3!=NULL )
+        if( ei1!=MESH_NULL_ID && ei2!=MESH_NULL_ID && ei3!=MESH_NULL_ID )
         {
 
-            HalfEdge* ei1n = ei1->getNext();
-            HalfEdge* ei2n = ei2->getNext();
-            HalfEdge* ei3n = ei3->getNext();
+            unsigned int ei1n = this->getHalfEdgeNext(ei1);
+            unsigned int ei2n = this->getHalfEdgeNext(ei2);
+            unsigned int ei3n = this->getHalfEdgeNext(ei3);
 
-            faceId = createFace( NULL );
-            face = getFace( faceId );
+            faceId = createFace( MESH_NULL_ID );
 
-            e1 = getHalfEdge( createEdge( v1, face, v2, ei2->getFace() ) );
-            e2 = getHalfEdge( createEdge( v2, face, v3, ei3->getFace() ) );
-            e3 = getHalfEdge( createEdge( v3, face, v1, ei1->getFace() ) );
+            e1 = createEdge( v1, faceId, v2, this->getHalfEdgeFace(ei2) );
+            e2 = createEdge( v2, faceId, v3, this->getHalfEdgeFace(ei3) );
+            e3 = createEdge( v3, faceId, v1, this->getHalfEdgeFace(ei1) );
 
-            face->setBoundary( e1 );
+            this->setFaceBoundary( faceId, e1 );
 
-            e1->setNext( e2 );
-            e2->setNext( e3 );
-            e3->setNext( e1 );
+            this->setHalfEdgeNext( e1, e2 );
+            this->setHalfEdgeNext( e2, e3 );
+            this->setHalfEdgeNext( e3, e1 );
 
-            ei1->setNext( e3->getTwin() );
-            e3->getTwin()->setNext( ei3n );
+            this->setHalfEdgeNext( ei1, this->getHalfEdgeTwin(e3) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e3), ei3n );
 
-            ei3->setNext( e2->getTwin() );
-            e2->getTwin()->setNext( ei2n );
+            this->setHalfEdgeNext( ei3, this->getHalfEdgeTwin(e2) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e2), ei2n );
 
-            ei2->setNext( e1->getTwin() );
-            e1->getTwin()->setNext( ei1n );
+            this->setHalfEdgeNext( ei2, this->getHalfEdgeTwin(e1) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e1), ei1n );
         }
     }
 
-    //all vertices are used, and two of then are used by the 
+    //all vertices are used, and two of then are used by the
     //same triangle. In this case, one edge will be shared with
     //other triangle.
     else if (unusedVertices==0 && readyEdges==1)
     {
-        if( e2!=NULL )
+        if( e2!=MESH_NULL_ID )
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v2;
             v2 = v3;
             v3 = vt;
-            HalfEdge *et = e1;
+            unsigned int et = e1;
             e1 = e2;
             e2 = e3;
             e3 = et;
         }
-        else if( e3!=NULL )
+        else if( e3!=MESH_NULL_ID )
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v3;
             v3 = v2;
             v2 = vt;
-            HalfEdge* et = e1;
+            unsigned int et = e1;
             e1 = e3;
             e3 = e2;
             e2 = et;
         }
 
-        HalfEdge* ei3 = findIncidentHalfEdge( v3 );
-        if( ei3 && e1->getFace()==NULL )
+        unsigned int ei3 = findIncidentHalfEdge( v3 );
+        if( ei3!=MESH_NULL_ID && this->getHalfEdgeFace(e1)==MESH_NULL_ID )
         {
-            HalfEdge* e1p = e1->getPrev();
-            HalfEdge* e1n = e1->getNext();
-            HalfEdge* ei3n = ei3->getNext();
+            unsigned int e1p = this->getHalfEdgePrev(e1);
+            unsigned int e1n = this->getHalfEdgeNext(e1);
+            unsigned int ei3n = this->getHalfEdgeNext(ei3);
 
             faceId = createFace( e1 );
-            face = getFace( faceId );
 
-            e2 = getHalfEdge( createEdge( v2, face, v3, ei3->getFace() ) );
-            e3 = getHalfEdge( createEdge( v3, face, v1, e1p->getFace() ) );
+            e2 = createEdge( v2, faceId, v3, this->getHalfEdgeFace(ei3) );
+            e3 = createEdge( v3, faceId, v1, this->getHalfEdgeFace(e1p) );
 
-            e1->setFace( face );
-            e2->setFace( face );
-            e3->setFace( face );
+            this->setHalfEdgeFace( e1, faceId );
+            this->setHalfEdgeFace( e2, faceId );
+            this->setHalfEdgeFace( e3, faceId );
 
-            e1->setNext( e2 );
-            e2->setNext( e3 );
-            e3->setNext( e1 );
+            this->setHalfEdgeNext( e1, e2 );
+            this->setHalfEdgeNext( e2, e3 );
+            this->setHalfEdgeNext( e3, e1 );
 
-            e1p->setNext( e3->getTwin() );
-            e3->getTwin()->setNext( ei3n );
+            this->setHalfEdgeNext( e1p, this->getHalfEdgeTwin(e3) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e3), ei3n );
 
-            ei3->setNext( e2->getTwin() );
-            e2->getTwin()->setNext( e1n );
+            this->setHalfEdgeNext( ei3, this->getHalfEdgeTwin(e2) );
+            this->setHalfEdgeNext( this->getHalfEdgeTwin(e2), e1n );
         }
     }
 
@@ -614,50 +1000,49 @@ unsigned int Mesh<Vdt,Hdt,Fdt>::createTriangularFace(unsigned int vId1, unsigned
     //will create one edge to 'fill' the hole and expand the mesh
     else if( unusedVertices==0 && readyEdges==2 )
     {
-        if (e1==NULL)
+        if (e1==MESH_NULL_ID)
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v3;
             v3 = v2;
             v2 = vt;
-            HalfEdge* et = e1;
+            unsigned int et = e1;
             e1 = e3;
             e3 = e2;
             e2 = et;
         }
-        else if (e3==NULL)
+        else if (e3==MESH_NULL_ID)
         {
-            Vertex* vt = v1;
+            unsigned int vt = v1;
             v1 = v2;
             v2 = v3;
             v3 = vt;
-            HalfEdge *et = e1;
+            unsigned int et = e1;
             e1 = e2;
             e2 = e3;
             e3 = et;
         }
 
-        if (e1->getFace()==NULL && e3->getFace()==NULL)
+        if (this->getHalfEdgeFace(e1)==MESH_NULL_ID && this->getHalfEdgeFace(e3)==MESH_NULL_ID)
         {
-            HalfEdge* e1n = e1->getNext();
-            HalfEdge* e3p = e3->getPrev();
+            unsigned int e1n = this->getHalfEdgeNext(e1);
+            unsigned int e3p = this->getHalfEdgePrev(e3);
 
-            if (e3->getNext()==e1 && e1->getPrev()==e3)
+            if (this->getHalfEdgeNext(e3)==e1 && this->getHalfEdgePrev(e1)==e3)
             {
                 faceId = createFace( e1 );
-                face = getFace( faceId );
 
-                e2 = getHalfEdge( createEdge( v2, face, v3, e1n->getFace() ) );
+                e2 = createEdge( v2, faceId, v3, this->getHalfEdgeFace(e1n) );
 
-                e1->setFace( face );
-                e3->setFace( face );
+                this->setHalfEdgeFace( e1, faceId );
+                this->setHalfEdgeFace( e3, faceId );
 
-                e1->setNext( e2 );
-                e2->setNext( e3 );
-                e3->setNext( e1 );
+                this->setHalfEdgeNext( e1, e2 );
+                this->setHalfEdgeNext( e2, e3 );
+                this->setHalfEdgeNext( e3, e1 );
 
-                e3p->setNext( e2->getTwin() );
-                e2->getTwin()->setNext( e1n );
+                this->setHalfEdgeNext( e3p, this->getHalfEdgeTwin(e2) );
+                this->setHalfEdgeNext( this->getHalfEdgeTwin(e2), e1n );
             }
             else
             {
@@ -670,15 +1055,14 @@ unsigned int Mesh<Vdt,Hdt,Fdt>::createTriangularFace(unsigned int vId1, unsigned
     //point to a new face. A easy case =)
     else if ( unusedVertices==0 && readyEdges==3 )
     {
-        if(e1->getFace()==NULL && e2->getFace()==NULL && e3->getFace()==NULL)
+        if(this->getHalfEdgeFace(e1)==MESH_NULL_ID && this->getHalfEdgeFace(e2)==MESH_NULL_ID && this->getHalfEdgeFace(e3)==MESH_NULL_ID)
         {
-            if (e1->getNext()==e2 && e2->getNext()==e3 && e3->getNext()==e1)
+            if (this->getHalfEdgeNext(e1)==e2 && this->getHalfEdgeNext(e2)==e3 && this->getHalfEdgeNext(e3)==e1)
             {
                 faceId = createFace( e1 );
-                face = getFace( faceId );
-                e1->setFace( face );
-                e2->setFace( face );
-                e3->setFace( face );
+                this->setHalfEdgeFace( e1, faceId );
+                this->setHalfEdgeFace( e2, faceId );
+                this->setHalfEdgeFace( e3, faceId );
             }
             else
             {
@@ -687,233 +1071,1142 @@ unsigned int Mesh<Vdt,Hdt,Fdt>::createTriangularFace(unsigned int vId1, unsigned
         }
     }
 
-    // if there is no face pointer, then a triangle should be inserted in
+    // if there is no face, then a triangle should be inserted in
     // a difficult case to handle. For now, the most simple solution is
     // handle this triangle latter, after other triangles have been added
     // and there is no ambiguity
-    if( face==NULL )
+    if( faceId==MESH_NULL_ID )
     {
-        this->unhandledTriangles.push_back( vId1 );
-        this->unhandledTriangles.push_back( vId2 );
-        this->unhandledTriangles.push_back( vId3 );
-        unhandledTrianglesCount++;
+        const uint32_t triangle[3] = { vId1, vId2, vId3 };
+        this->delayFace( triangle, 3 );
     }
 
     return faceId;
 };
 
-template<class Vdt, class Hdt, class Fdt>
-VertexT<Vdt,Hdt,Fdt>* Mesh<Vdt,Hdt,Fdt>::getVertex( unsigned int id ) const
-{
-    const MeshT::Vertex* v = &(this->vertices[id]);
-    return const_cast<MeshT::Vertex*>(v);
-};
-
-template<class Vdt, class Hdt, class Fdt>
-std::vector<VertexT<Vdt,Hdt,Fdt>>& Mesh<Vdt,Hdt,Fdt>::getVertices()
-{
-    return this->vertices;
-};
-
-template<class Vdt, class Hdt, class Fdt>
-const std::vector<VertexT<Vdt,Hdt,Fdt>>& Mesh<Vdt,Hdt,Fdt>::getVertices() const
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::createPolygonFace(const uint32_t* vertexIds, unsigned int vertexCount)
 {
-    return this->vertices;
-};
-
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::getNumVertices() const
-{
-    return this->vertices.size();
-};
-
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::getVertexId(const Vertex* vertex) const
-{
-    const Vertex* firstVertex = &(this->vertices[0]);
-    unsigned int id = vertex - firstVertex;
-    if( id>=0 && id < this->vertices.size() )
+    if( vertexCount<3 )
     {
-        if( &(this->vertices[id]) == vertex )
-            return id;
+        throw cpp::Exception("A face must have at least 3 vertices");
     }
-    return MESH_NULL_ID;
-}
-
-template<class Vdt, class Hdt, class Fdt>
-std::vector<FaceT<Vdt,Hdt,Fdt>>& Mesh<Vdt,Hdt,Fdt>::getFaces( )
-{
-    return this->faces;
-};
-
-template<class Vdt, class Hdt, class Fdt>
-const std::vector<FaceT<Vdt,Hdt,Fdt>>& Mesh<Vdt,Hdt,Fdt>::getFaces( ) const
-{
-    return this->faces;
-};
-
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::getNumFaces( ) const
-{
-    return this->faces.size();
-}
-
-template<class Vdt, class Hdt, class Fdt>
-FaceT<Vdt,Hdt,Fdt>* Mesh<Vdt,Hdt,Fdt>::getFace(unsigned int faceId) const
-{
-    const Face* f = &(this->faces[faceId]);
-    return const_cast<Face*>(f);
-};
-
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::getFaceId(const Face* face) const
-{
-    const Face* firstFace = &(this->faces[0]);
-    unsigned int id = face - firstFace;
-    if( id>=0 && id < this->faces.size() )
+    if( vertexCount==3 )
     {
-        if( &(this->faces[id]) == face )
-            return id;
+        return this->createTriangularFace( vertexIds[0], vertexIds[1], vertexIds[2] );
     }
-    return MESH_NULL_ID;
-};
-
-template<class Vdt, class Hdt, class Fdt>
-inline std::vector<HalfEdgeT<Vdt,Hdt,Fdt>>& Mesh<Vdt,Hdt,Fdt>::getHalfEdges( )
-{
-    return this->edges;
-};
-
-template<class Vdt, class Hdt, class Fdt>
-inline const std::vector<HalfEdgeT<Vdt,Hdt,Fdt>>& Mesh<Vdt,Hdt,Fdt>::getHalfEdges( ) const
-{
-    return this->edges;
-};
-
-template<class Vdt, class Hdt, class Fdt>
-HalfEdgeT<Vdt,Hdt,Fdt>* Mesh<Vdt,Hdt,Fdt>::getHalfEdge(unsigned int id)
-{
-    HalfEdge* e = &(this->edges[id]);
-    return e;
-}
-
-template<class Vdt, class Hdt, class Fdt>
-const HalfEdgeT<Vdt,Hdt,Fdt>* Mesh<Vdt,Hdt,Fdt>::getHalfEdge(unsigned int id) const
-{
-    const HalfEdge* e = &(this->edges[id]);
-    return e;
-}
 
-template<class Vdt, class Hdt, class Fdt>
-HalfEdgeT<Vdt,Hdt,Fdt>* Mesh<Vdt,Hdt,Fdt>::getHalfEdge(Vertex* vertexA, Vertex* vertexB) const
-{
-    EdgeIterator it( vertexA );
-    while( it.hasNext() )
+    unsigned int faceId = this->insertPolygonFace( vertexIds, vertexCount );
+    if( faceId==MESH_NULL_ID )
     {
-        HalfEdge* e = it.getNext();
-        if( e->getTwin()->getOrigin()==vertexB )
-        {
-            return e;
-        }
+        this->delayFace( vertexIds, vertexCount );
     }
-    return NULL;
-};
-
-template<class Vdt, class Hdt, class Fdt>
-HalfEdgeT<Vdt,Hdt,Fdt>* Mesh<Vdt,Hdt,Fdt>::getHalfEdge( unsigned int vertexIdA, unsigned int vertexIdB) const
-{
-    return getHalfEdge( getVertex(vertexIdA), getVertex(vertexIdB) );
+    return faceId;
 };
 
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::getHalfEdgeId( HalfEdge* halfEdge) const
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::insertPolygonFace(const uint32_t* vertexIds, unsigned int vertexCount)
 {
-    const HalfEdge* firstEdge = &(this->edges[0]);
-    unsigned int id = halfEdge - firstEdge;
-    if( id>=0 && id < this->edges.size() )
+    const unsigned int n = vertexCount;
+    std::vector<unsigned int>& edges = this->polygonEdges;
+    std::vector<char>& newEdges = this->polygonNewEdges;
+    std::vector<unsigned int>& gaps = this->polygonGaps;
+    std::vector< std::pair<unsigned int, unsigned int> >& links = this->polygonLinks;
+    edges.resize( n );
+    newEdges.assign( n, 0 );
+    gaps.assign( n, MESH_NULL_ID );
+    links.clear();
+
+    // the edge i goes from the vertex i to the vertex i+1. The vertices must
+    // be unused or on a border, and the existing edges must have no face yet
+    for( unsigned int i=0; i<n; ++i )
     {
-        if( &(this->edges[id]) == halfEdge )
-            return id;
+        const unsigned int vertexId = vertexIds[i];
+        if( this->getVertexIncidentEdge(vertexId)!=MESH_NULL_ID && !this->isBorderVertex(vertexId) )
+        {
+            return MESH_NULL_ID;
+        }
+        edges[i] = this->findHalfEdge( vertexId, vertexIds[(i+1)%n] );
+        if( edges[i]==MESH_NULL_ID )
+        {
+            newEdges[i] = 1;
+        }
+        else if( this->getHalfEdgeFace(edges[i])!=MESH_NULL_ID )
+        {
+            return MESH_NULL_ID;
+        }
     }
-    return MESH_NULL_ID;
-}
-
-template<class Vdt, class Hdt, class Fdt>
-unsigned int Mesh<Vdt,Hdt,Fdt>::getNumHalfEdges() const
-{
-    return this->edges.size();
-}
 
-template<class Vdt, class Hdt, class Fdt>
-void Mesh<Vdt,Hdt,Fdt>::checkAllFaces() const
-{
-    const unsigned int numFaces = this->getNumFaces();
-    for( unsigned int f=0; f<numFaces; ++f )
+    // at each vertex i+1, between the edges i and i+1
+    for( unsigned int i=0; i<n; ++i )
     {
-        this->checkFace(f);
-    }
-}
+        const unsigned int ii = (i+1)%n;
+        const unsigned int innerPrev = edges[i];
+        const unsigned int innerNext = edges[ii];
 
-template<class Vdt, class Hdt, class Fdt>
-void Mesh<Vdt,Hdt,Fdt>::checkFace(unsigned int faceId) const
-{
-    Face* face = this->getFace(faceId);
+        if( !newEdges[i] && !newEdges[ii] && this->getHalfEdgeNext(innerPrev)!=innerNext )
+        {
+            // both edges exist, but other border half-edges are between them.
+            // These half-edges are moved to another border of the vertex
+            unsigned int borderPrev = this->getHalfEdgeTwin(innerNext);
+            unsigned int count = 0;
+            do
+            {
+                borderPrev = this->getHalfEdgeTwin( this->getHalfEdgeNext(borderPrev) );
+                if( ++count>this->getNumHalfEdges() )
+                {
+                    return MESH_NULL_ID;
+                }
+            }
+            while( this->getHalfEdgeFace(borderPrev)!=MESH_NULL_ID || borderPrev==innerPrev );
 
-    if( face->getBoundary()==NULL )
-    {
-        throw cpp::Exception("Every face must have a boundary (1)");
+            const unsigned int borderNext = this->getHalfEdgeNext(borderPrev);
+            if( borderNext==innerNext )
+            {
+                return MESH_NULL_ID;
+            }
+            links.push_back( std::make_pair( borderPrev, this->getHalfEdgeNext(innerPrev) ) );
+            links.push_back( std::make_pair( this->getHalfEdgePrev(innerNext), borderNext ) );
+            links.push_back( std::make_pair( innerPrev, innerNext ) );
+        }
+        else if( newEdges[i] && newEdges[ii] && this->getVertexIncidentEdge(vertexIds[ii])!=MESH_NULL_ID )
+        {
+            // both edges are new, and will be put in the only border of the vertex
+            gaps[ii] = this->findIncidentHalfEdge( vertexIds[ii] );
+            if( gaps[ii]==MESH_NULL_ID )
+            {
+                return MESH_NULL_ID;
+            }
+        }
     }
 
-    HalfEdge* edge = NULL;
-    EdgeIterator it(face);
-    while( it.hasNext() )
+    // from here the polygon is inserted
+    const unsigned int faceId = this->createFace( MESH_NULL_ID );
+    for( unsigned int i=0; i<n; ++i )
     {
-        edge = it.getNext();
-
-        if( edge->getFace()!=face )
+        if( newEdges[i] )
         {
-            throw cpp::Exception("The sequence of half-edges pointed by face->boundary must point to the same face (2)");
+            edges[i] = this->createEdge( vertexIds[i], faceId, vertexIds[(i+1)%n], MESH_NULL_ID );
         }
-
-        if( edge->getOrigin()==NULL )
+        else
         {
-            throw cpp::Exception("Every edge must have an origin vertex (3)");
+            this->setHalfEdgeFace( edges[i], faceId );
         }
+    }
+    this->setFaceBoundary( faceId, edges[0] );
 
-        if( edge->getOrigin()->getIncidentEdge()==NULL )
+    for( unsigned int i=0; i<n; ++i )
+    {
+        const unsigned int ii = (i+1)%n;
+        const unsigned int vertexId = vertexIds[ii];
+        const unsigned int innerPrev = edges[i];
+        const unsigned int innerNext = edges[ii];
+        if( !newEdges[i] && !newEdges[ii] )
         {
-            throw cpp::Exception("Every vertex must have a incident pointer (4)");
+            continue;
         }
 
-        if( edge->getTwin()==NULL )
+        const unsigned int outerPrev = this->getHalfEdgeTwin(innerNext);
+        const unsigned int outerNext = this->getHalfEdgeTwin(innerPrev);
+        if( newEdges[i] && !newEdges[ii] )
         {
-            throw cpp::Exception("Every edge must have an twin edge (5)");
+            links.push_back( std::make_pair( this->getHalfEdgePrev(innerNext), outerNext ) );
         }
-
-        if( edge->getNext()==NULL )
+        else if( !newEdges[i] && newEdges[ii] )
         {
-            throw cpp::Exception("Every edge must have a next half-edge pointer (6)");
+            links.push_back( std::make_pair( outerPrev, this->getHalfEdgeNext(innerPrev) ) );
         }
-        else if( edge->getNext()->getOrigin()!=edge->getTwin()->getOrigin() )
+        else if( gaps[ii]==MESH_NULL_ID ) // an unused vertex
         {
-            throw cpp::Exception("The pointer edge->next->origin must be equal to edge->twin->origin (7)");
+            links.push_back( std::make_pair( outerPrev, outerNext ) );
+            this->setVertexIncidentEdge( vertexId, innerNext );
         }
-
-        if( edge->getPrev()==NULL )
+        else
+        {
+            links.push_back( std::make_pair( gaps[ii], outerNext ) );
+            links.push_back( std::make_pair( outerPrev, this->getHalfEdgeNext(gaps[ii]) ) );
+        }
+        links.push_back( std::make_pair( innerPrev, innerNext ) );
+    }
+
+    // the pointers are only changed now, as the ones above were found
+    // following the borders before the polygon was inserted
+    for( size_t i=0; i<links.size(); ++i )
+    {
+        this->setHalfEdgeNext( links[i].first, links[i].second );
+    }
+    return faceId;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+bool Mesh<Vdt,Hdt,Fdt,St>::isBorderVertex(unsigned int vertexId) const
+{
+    typedef CirculatorRange<MeshT, AroundVertexStep, HalfEdgeValue> OutgoingRange;
+    const OutgoingRange outgoing = vertexOutgoingHalfEdges( *this, vertexId );
+    for( typename OutgoingRange::iterator it=outgoing.begin(); it!=outgoing.end(); ++it )
+    {
+        if( this->getHalfEdgeFace( this->getHalfEdgeTwin(*it) )==MESH_NULL_ID )
+        {
+            return true;
+        }
+    }
+    return false;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::delayFace(const uint32_t* vertexIds, unsigned int vertexCount)
+{
+    this->unhandledFaces.push_back( vertexCount );
+    this->unhandledFaces.insert( this->unhandledFaces.end(), vertexIds, vertexIds+vertexCount );
+    this->unhandledFacesCount++;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::buildFromTriangles(const uint32_t* indices, size_t triangleCount)
+{
+    const unsigned int numVertices = this->getNumVertices();
+    const size_t numCorners = triangleCount*3;
+
+    this->allDirty = this->dirtyTrackingEnabled;
+    this->adjacencyValid = false;
+    this->resizeStorage( numVertices, 0, 0 );
+    this->vertexAttributes.resize( numVertices );
+    this->halfEdgeAttributes.resize( 0 );
+    this->faceAttributes.resize( 0 );
+    this->unhandledFaces.clear();
+    this->unhandledFacesCount = 0;
+    for( unsigned int vertexId=0; vertexId<numVertices; ++vertexId )
+    {
+        this->setVertexIncidentEdge( vertexId, MESH_NULL_ID );
+    }
+
+    // each corner c is the start of the side that goes from indices[c] to
+    // the next corner of the same triangle. Sorting the sides by their
+    // unordered pair of vertices puts the two sides of an edge together.
+    std::vector<uint32_t> sideEdge( numCorners );
+    unsigned int numEdges = 0;
+    {
+        std::vector<TriangleSide> sides( numCorners );
+        for( size_t c=0; c<numCorners; ++c )
+        {
+            const uint32_t a = indices[c];
+            const uint32_t b = indices[ (c%3==2)? c-2 : c+1 ];
+            if( a>=numVertices || b>=numVertices )
+            {
+                throw cpp::Exception("A triangle references a vertex that does not exist");
+            }
+            if( a==b )
+            {
+                throw cpp::Exception("A triangle cannot use the same vertex twice");
+            }
+            sides[c].key = (a<b)? ((uint64_t)a<<32)|b : ((uint64_t)b<<32)|a;
+            sides[c].corner = (uint32_t)c;
+        }
+        std::sort( sides.begin(), sides.end() );
+
+        // the first side of each edge gets the half-edge 2k and the second
+        // one (if any) its twin, 2k+1, as createEdge does
+        size_t i = 0;
+        while( i<numCorners )
+        {
+            size_t j = i+1;
+            while( j<numCorners && sides[j].key==sides[i].key )
+            {
+                ++j;
+            }
+            if( j-i>2 )
+            {
+                throw cpp::Exception("An edge cannot be shared by more than two triangles");
+            }
+
+            sideEdge[ sides[i].corner ] = 2*numEdges;
+            if( j-i==2 )
+            {
+                if( indices[sides[i].corner]==indices[sides[i+1].corner] )
+                {
+                    throw cpp::Exception("Two triangles that share an edge must have the same orientation");
+                }
+                sideEdge[ sides[i+1].corner ] = 2*numEdges+1;
+            }
+            ++numEdges;
+            i = j;
+        }
+    }
+
+    // no element is added after this point, so the pointers are stable
+    this->resizeStorage( numVertices, 2*numEdges, (unsigned int)triangleCount );
+    this->halfEdgeAttributes.resize( 2*numEdges );
+    this->faceAttributes.resize( (unsigned int)triangleCount );
+
+    for( size_t t=0; t<triangleCount; ++t )
+    {
+        const unsigned int faceId = (unsigned int)t;
+        unsigned int e[3];
+        for( unsigned int k=0; k<3; ++k )
+        {
+            const unsigned int vertexId = indices[3*t+k];
+            e[k] = sideEdge[3*t+k];
+            this->setHalfEdgeOrigin( e[k], vertexId );
+            this->setHalfEdgeFace( e[k], faceId );
+            if( this->getVertexIncidentEdge(vertexId)==MESH_NULL_ID )
+            {
+                this->setVertexIncidentEdge( vertexId, e[k] );
+            }
+        }
+        this->setHalfEdgeNext( e[0], e[1] );
+        this->setHalfEdgeNext( e[1], e[2] );
+        this->setHalfEdgeNext( e[2], e[0] );
+        this->setFaceBoundary( faceId, e[0] );
+    }
+
+    for( unsigned int edgeId=0; edgeId<numEdges; ++edgeId )
+    {
+        const unsigned int e1 = 2*edgeId;
+        const unsigned int e2 = 2*edgeId+1;
+        this->setHalfEdgeTwin( e1, e2 );
+        if( this->getHalfEdgeFace(e2)==MESH_NULL_ID ) // a border half-edge starts where its twin ends
+        {
+            this->setHalfEdgeOrigin( e2, this->getHalfEdgeOrigin( this->getHalfEdgeNext(e1) ) );
+        }
+    }
+
+    this->linkBorderHalfEdges();
+
+    if( this->halfEdgeIndexEnabled )
+    {
+        this->buildHalfEdgeIndex();
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::beginTriangles(size_t triangleCount)
+{
+    const unsigned int numVertices = this->getNumVertices();
+
+    this->allDirty = this->dirtyTrackingEnabled;
+    this->adjacencyValid = false;
+    this->resizeStorage( numVertices, 0, 0 );
+    this->vertexAttributes.resize( numVertices );
+    this->halfEdgeAttributes.resize( 0 );
+    this->faceAttributes.resize( 0 );
+    this->unhandledFaces.clear();
+    this->unhandledFacesCount = 0;
+    this->halfEdgeIndex.clear();
+    this->triangleSides.clear();
+    // a closed mesh has 3 edges for each 2 triangles
+    this->triangleSides.reserve( triangleCount*3/2 );
+    for( unsigned int vertexId=0; vertexId<numVertices; ++vertexId )
+    {
+        this->setVertexIncidentEdge( vertexId, MESH_NULL_ID );
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::addTriangles(const uint32_t* indices, size_t triangleCount)
+{
+    const unsigned int numVertices = this->getNumVertices();
+    for( size_t t=0; t<triangleCount; ++t )
+    {
+        const uint32_t* triangle = &indices[3*t];
+        for( unsigned int k=0; k<3; ++k )
+        {
+            if( triangle[k]>=numVertices )
+            {
+                throw cpp::Exception("A triangle references a vertex that does not exist");
+            }
+            if( triangle[k]==triangle[ (k+1)%3 ] )
+            {
+                throw cpp::Exception("A triangle cannot use the same vertex twice");
+            }
+        }
+
+        // the side from a to b is the free twin of the side from b to a,
+        // if it was added before. Otherwise a new edge is created, with its
+        // twin on the border until the other side arrives
+        const unsigned int faceId = this->addFace();
+        unsigned int e[3];
+        for( unsigned int k=0; k<3; ++k )
+        {
+            const uint32_t a = triangle[k];
+            const uint32_t b = triangle[ (k+1)%3 ];
+            const unsigned int first = this->triangleSides.findOrInsert( std::min(a, b), std::max(a, b), this->getNumHalfEdges() );
+            if( first==MESH_NULL_ID )
+            {
+                e[k] = this->addHalfEdgePair();
+                this->setHalfEdgeTwin( e[k], e[k]+1 );
+                this->setHalfEdgeOrigin( e[k]+1, b );
+            }
+            else
+            {
+                e[k] = this->getHalfEdgeTwin( first );
+                if( this->getHalfEdgeFace( e[k] )!=MESH_NULL_ID )
+                {
+                    throw cpp::Exception("An edge cannot be shared by more than two triangles");
+                }
+                if( this->getHalfEdgeOrigin( first )==a )
+                {
+                    throw cpp::Exception("Two triangles that share an edge must have the same orientation");
+                }
+            }
+            this->setHalfEdgeOrigin( e[k], a );
+            this->setHalfEdgeFace( e[k], faceId );
+            if( this->getVertexIncidentEdge(a)==MESH_NULL_ID )
+            {
+                this->setVertexIncidentEdge( a, e[k] );
+            }
+        }
+        this->setHalfEdgeNext( e[0], e[1] );
+        this->setHalfEdgeNext( e[1], e[2] );
+        this->setHalfEdgeNext( e[2], e[0] );
+        this->setFaceBoundary( faceId, e[0] );
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::endTriangles()
+{
+    this->triangleSides.clear();
+    this->halfEdgeAttributes.resize( this->getNumHalfEdges() );
+    this->faceAttributes.resize( this->getNumFaces() );
+
+    this->linkBorderHalfEdges();
+
+    if( this->halfEdgeIndexEnabled )
+    {
+        this->buildHalfEdgeIndex();
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::linkBorderHalfEdges()
+{
+    const unsigned int numEdges = this->getNumHalfEdges();
+
+    // pairs of (border half-edge, border half-edge that leaves its target)
+    std::vector< std::pair<unsigned int, unsigned int> > borders;
+    std::vector<unsigned int> bordersPerVertex( this->getNumVertices(), 0 );
+
+    for( unsigned int edgeId=0; edgeId<numEdges; ++edgeId )
+    {
+        if( this->getHalfEdgeFace(edgeId)!=MESH_NULL_ID || this->getHalfEdgeNext(edgeId)!=MESH_NULL_ID )
+        {
+            continue;
+        }
+
+        unsigned int out = this->getHalfEdgeTwin(edgeId);
+        unsigned int count = 0;
+        do
+        {
+            if( this->getHalfEdgeFace(out)==MESH_NULL_ID || count>numEdges )
+            {
+                throw cpp::Exception("A border half-edge cannot be linked, as the edges around its target vertex are inconsistent");
+            }
+            out = this->getHalfEdgeTwin( this->getHalfEdgePrev(out) );
+            ++count;
+        }
+        while( this->getHalfEdgeFace(out)!=MESH_NULL_ID );
+
+        borders.push_back( std::make_pair( edgeId, out ) );
+        bordersPerVertex[ this->getHalfEdgeOrigin(out) ]++;
+    }
+
+    // vertices touched by more than one border are handled after, as their
+    // borders are chained
+    std::vector< std::pair<unsigned int, unsigned int> > sharedBorders;
+    for( size_t i=0; i<borders.size(); ++i )
+    {
+        const unsigned int vertexId = this->getHalfEdgeOrigin( borders[i].second );
+        if( bordersPerVertex[vertexId]==1 )
+        {
+            this->setHalfEdgeNext( borders[i].first, borders[i].second );
+        }
+        else
+        {
+            sharedBorders.push_back( std::make_pair( vertexId, (unsigned int)i ) );
+        }
+    }
+
+    std::sort( sharedBorders.begin(), sharedBorders.end() );
+    size_t first = 0;
+    while( first<sharedBorders.size() )
+    {
+        size_t last = first+1;
+        while( last<sharedBorders.size() && sharedBorders[last].first==sharedBorders[first].first )
+        {
+            ++last;
+        }
+        for( size_t i=first; i<last; ++i )
+        {
+            const size_t following = (i+1<last)? i+1 : first;
+            this->setHalfEdgeNext( borders[ sharedBorders[i].second ].first, borders[ sharedBorders[following].second ].second );
+        }
+        first = last;
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::reserve(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+{
+    this->reserveStorage( numVertices, numHalfEdges, numFaces );
+    this->vertexAttributes.reserve( numVertices );
+    this->halfEdgeAttributes.reserve( numHalfEdges );
+    this->faceAttributes.reserve( numFaces );
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::resize(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+{
+    this->clear();
+    this->allDirty = this->dirtyTrackingEnabled;
+    this->resizeStorage( numVertices, numHalfEdges, numFaces );
+    this->vertexAttributes.resize( numVertices );
+    this->halfEdgeAttributes.resize( numHalfEdges );
+    this->faceAttributes.resize( numFaces );
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::permute(const MeshPermutation& permutation)
+{
+    const unsigned int numVertices = this->getNumVertices();
+    const unsigned int numHalfEdges = this->getNumHalfEdges();
+    const unsigned int numFaces = this->getNumFaces();
+    if( !permutation.isValid( numVertices, numHalfEdges, numFaces ) )
+    {
+        throw cpp::Exception("The permutation doesn't match the elements of the mesh");
+    }
+    const std::vector<unsigned int>& newVertexIds = permutation.getVertices();
+    const std::vector<unsigned int>& newHalfEdgeIds = permutation.getHalfEdges();
+    const std::vector<unsigned int>& newFaceIds = permutation.getFaces();
+
+    // everything moves, so the set* methods don't need to record each change
+    this->allDirty = this->dirtyTrackingEnabled;
+    this->adjacencyValid = false;
+
+    std::vector<unsigned int> ids;
+    this->gatherIds( newVertexIds, &MeshT::getVertexIncidentEdge, permutation, &MeshPermutation::getNewHalfEdgeId, ids );
+    this->setIds( &MeshT::setVertexIncidentEdge, ids );
+    this->gatherIds( newFaceIds, &MeshT::getFaceBoundary, permutation, &MeshPermutation::getNewHalfEdgeId, ids );
+    this->setIds( &MeshT::setFaceBoundary, ids );
+    this->gatherIds( newHalfEdgeIds, &MeshT::getHalfEdgeTwin, permutation, &MeshPermutation::getNewHalfEdgeId, ids );
+    this->setIds( &MeshT::setHalfEdgeTwin, ids );
+    this->gatherIds( newHalfEdgeIds, &MeshT::getHalfEdgeOrigin, permutation, &MeshPermutation::getNewVertexId, ids );
+    this->setIds( &MeshT::setHalfEdgeOrigin, ids );
+    this->gatherIds( newHalfEdgeIds, &MeshT::getHalfEdgeFace, permutation, &MeshPermutation::getNewFaceId, ids );
+    this->setIds( &MeshT::setHalfEdgeFace, ids );
+
+    // setting the next of a half-edge also sets the prev of the other one,
+    // so both are read before any of them is set
+    std::vector<unsigned int> prevIds;
+    this->gatherIds( newHalfEdgeIds, &MeshT::getHalfEdgeNext, permutation, &MeshPermutation::getNewHalfEdgeId, ids );
+    this->gatherIds( newHalfEdgeIds, &MeshT::getHalfEdgePrev, permutation, &MeshPermutation::getNewHalfEdgeId, prevIds );
+    this->setIds( &MeshT::setHalfEdgeNext, ids );
+    this->setIds( &MeshT::setHalfEdgePrev, prevIds );
+
+    {
+        std::vector<Vdt> data( numVertices );
+        for( unsigned int i=0; i<numVertices; ++i )
+        {
+            data[ newVertexIds[i] ] = this->getVertexData(i);
+        }
+        for( unsigned int i=0; i<numVertices; ++i )
+        {
+            this->getVertexData(i) = data[i];
+        }
+    }
+    {
+        std::vector<Hdt> data( numHalfEdges );
+        for( unsigned int i=0; i<numHalfEdges; ++i )
+        {
+            data[ newHalfEdgeIds[i] ] = this->getHalfEdgeData(i);
+        }
+        for( unsigned int i=0; i<numHalfEdges; ++i )
+        {
+            this->getHalfEdgeData(i) = data[i];
+        }
+    }
+    {
+        std::vector<Fdt> data( numFaces );
+        for( unsigned int i=0; i<numFaces; ++i )
+        {
+            data[ newFaceIds[i] ] = this->getFaceData(i);
+        }
+        for( unsigned int i=0; i<numFaces; ++i )
+        {
+            this->getFaceData(i) = data[i];
+        }
+    }
+
+    this->vertexAttributes.resize( numVertices );
+    this->halfEdgeAttributes.resize( numHalfEdges );
+    this->faceAttributes.resize( numFaces );
+    this->vertexAttributes.permute( newVertexIds );
+    this->halfEdgeAttributes.permute( newHalfEdgeIds );
+    this->faceAttributes.permute( newFaceIds );
+
+    // each delayed face is its number of vertices, followed by their IDs
+    for( size_t i=0; i<this->unhandledFaces.size(); i+=this->unhandledFaces[i]+1 )
+    {
+        for( unsigned int v=1; v<=this->unhandledFaces[i]; ++v )
+        {
+            this->unhandledFaces[i+v] = newVertexIds[ this->unhandledFaces[i+v] ];
+        }
+    }
+
+    if( this->halfEdgeIndexEnabled )
+    {
+        this->buildHalfEdgeIndex();
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::gatherIds(const std::vector<unsigned int>& newIds, IdGetter getter,
+    const MeshPermutation& permutation, NewIdGetter getNewId, std::vector<unsigned int>& ids) const
+{
+    const unsigned int count = (unsigned int)newIds.size();
+    ids.resize( count );
+    for( unsigned int i=0; i<count; ++i )
+    {
+        ids[ newIds[i] ] = (permutation.*getNewId)( (this->*getter)(i) );
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setIds(IdSetter setter, const std::vector<unsigned int>& ids)
+{
+    for( unsigned int i=0; i<(unsigned int)ids.size(); ++i )
+    {
+        (this->*setter)( i, ids[i] );
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+typename Mesh<Vdt,Hdt,Fdt,St>::Vertex* Mesh<Vdt,Hdt,Fdt,St>::getVertex( unsigned int id ) const
+{
+    const Vertex* v = &(this->vertices[id]);
+    return const_cast<Vertex*>(v);
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+std::vector<typename Mesh<Vdt,Hdt,Fdt,St>::Vertex>& Mesh<Vdt,Hdt,Fdt,St>::getVertices()
+{
+    return this->vertices;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+const std::vector<typename Mesh<Vdt,Hdt,Fdt,St>::Vertex>& Mesh<Vdt,Hdt,Fdt,St>::getVertices() const
+{
+    return this->vertices;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::getNumVertices() const
+{
+    return this->vertexCount();
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::getVertexId(const Vertex* vertex) const
+{
+    const Vertex* firstVertex = &(this->vertices[0]);
+    unsigned int id = vertex - firstVertex;
+    if( id>=0 && id < this->vertices.size() )
+    {
+        if( &(this->vertices[id]) == vertex )
+            return id;
+    }
+    return MESH_NULL_ID;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+std::vector<typename Mesh<Vdt,Hdt,Fdt,St>::Face>& Mesh<Vdt,Hdt,Fdt,St>::getFaces( )
+{
+    return this->faces;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+const std::vector<typename Mesh<Vdt,Hdt,Fdt,St>::Face>& Mesh<Vdt,Hdt,Fdt,St>::getFaces( ) const
+{
+    return this->faces;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::getNumFaces( ) const
+{
+    return this->faceCount();
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+typename Mesh<Vdt,Hdt,Fdt,St>::Face* Mesh<Vdt,Hdt,Fdt,St>::getFace(unsigned int faceId) const
+{
+    const Face* f = &(this->faces[faceId]);
+    return const_cast<Face*>(f);
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::getFaceId(const Face* face) const
+{
+    const Face* firstFace = &(this->faces[0]);
+    unsigned int id = face - firstFace;
+    if( id>=0 && id < this->faces.size() )
+    {
+        if( &(this->faces[id]) == face )
+            return id;
+    }
+    return MESH_NULL_ID;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+inline std::vector<typename Mesh<Vdt,Hdt,Fdt,St>::HalfEdge>& Mesh<Vdt,Hdt,Fdt,St>::getHalfEdges( )
+{
+    return this->edges;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+inline const std::vector<typename Mesh<Vdt,Hdt,Fdt,St>::HalfEdge>& Mesh<Vdt,Hdt,Fdt,St>::getHalfEdges( ) const
+{
+    return this->edges;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+typename Mesh<Vdt,Hdt,Fdt,St>::HalfEdge* Mesh<Vdt,Hdt,Fdt,St>::getHalfEdge(unsigned int id)
+{
+    HalfEdge* e = &(this->edges[id]);
+    return e;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+const typename Mesh<Vdt,Hdt,Fdt,St>::HalfEdge* Mesh<Vdt,Hdt,Fdt,St>::getHalfEdge(unsigned int id) const
+{
+    const HalfEdge* e = &(this->edges[id]);
+    return e;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+typename Mesh<Vdt,Hdt,Fdt,St>::HalfEdge* Mesh<Vdt,Hdt,Fdt,St>::getHalfEdge(Vertex* vertexA, Vertex* vertexB) const
+{
+    unsigned int edgeId = this->findHalfEdge( this->getVertexId(vertexA), this->getVertexId(vertexB) );
+    if( edgeId==MESH_NULL_ID )
+    {
+        return NULL;
+    }
+    const HalfEdge* e = &(this->edges[edgeId]);
+    return const_cast<HalfEdge*>(e);
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+typename Mesh<Vdt,Hdt,Fdt,St>::HalfEdge* Mesh<Vdt,Hdt,Fdt,St>::getHalfEdge( unsigned int vertexIdA, unsigned int vertexIdB) const
+{
+    return getHalfEdge( getVertex(vertexIdA), getVertex(vertexIdB) );
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::findHalfEdge( unsigned int originId, unsigned int targetId ) const
+{
+    if( this->halfEdgeIndexEnabled )
+    {
+        return this->halfEdgeIndex.find( originId, targetId );
+    }
+
+    typedef CirculatorRange<MeshT, AroundVertexStep, TargetValue> NeighbourRange;
+    const NeighbourRange neighbours = vertexNeighbours( *this, originId );
+    for( typename NeighbourRange::iterator it=neighbours.begin(); it!=neighbours.end(); ++it )
+    {
+        if( *it==targetId )
+        {
+            return it.getHalfEdge();
+        }
+    }
+    return MESH_NULL_ID;
+};
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::getHalfEdgeId( HalfEdge* halfEdge) const
+{
+    const HalfEdge* firstEdge = &(this->edges[0]);
+    unsigned int id = halfEdge - firstEdge;
+    if( id>=0 && id < this->edges.size() )
+    {
+        if( &(this->edges[id]) == halfEdge )
+            return id;
+    }
+    return MESH_NULL_ID;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::getNumHalfEdges() const
+{
+    return this->halfEdgeCount();
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setHalfEdgeIndexEnabled(bool enabled)
+{
+    if( enabled && !this->halfEdgeIndexEnabled )
+    {
+        this->buildHalfEdgeIndex();
+    }
+    else if( !enabled )
+    {
+        this->halfEdgeIndex.clear();
+    }
+    this->halfEdgeIndexEnabled = enabled;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+bool Mesh<Vdt,Hdt,Fdt,St>::isHalfEdgeIndexEnabled() const
+{
+    return this->halfEdgeIndexEnabled;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setVertexIncidentEdge(unsigned int vertexId, unsigned int halfEdgeId)
+{
+    this->markDirtyVertex( vertexId );
+    Storage::setVertexIncidentEdge( vertexId, halfEdgeId );
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setFaceBoundary(unsigned int faceId, unsigned int halfEdgeId)
+{
+    this->markDirtyFace( faceId );
+    Storage::setFaceBoundary( faceId, halfEdgeId );
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setHalfEdgeTwin(unsigned int halfEdgeId, unsigned int twinId)
+{
+    // the twin of twinId is changed too, so its old twin loses its twin
+    if( this->dirtyTrackingEnabled )
+    {
+        this->markDirtyHalfEdge( halfEdgeId );
+        this->markDirtyHalfEdge( this->getHalfEdgeTwin(halfEdgeId) );
+        this->markDirtyHalfEdge( twinId );
+        if( twinId!=MESH_NULL_ID )
+        {
+            this->markDirtyHalfEdge( this->getHalfEdgeTwin(twinId) );
+        }
+    }
+    this->adjacencyValid = false;
+    Storage::setHalfEdgeTwin( halfEdgeId, twinId );
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setHalfEdgeNext(unsigned int halfEdgeId, unsigned int nextId)
+{
+    // the prev of nextId is changed too, so its old prev loses its next
+    if( this->dirtyTrackingEnabled )
+    {
+        this->markDirtyHalfEdge( halfEdgeId );
+        this->markDirtyHalfEdge( this->getHalfEdgeNext(halfEdgeId) );
+        this->markDirtyHalfEdge( nextId );
+        if( nextId!=MESH_NULL_ID )
+        {
+            this->markDirtyHalfEdge( this->getHalfEdgePrev(nextId) );
+        }
+    }
+    Storage::setHalfEdgeNext( halfEdgeId, nextId );
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setHalfEdgePrev(unsigned int halfEdgeId, unsigned int prevId)
+{
+    // the next of prevId is changed too, so its old next loses its prev
+    if( this->dirtyTrackingEnabled )
+    {
+        this->markDirtyHalfEdge( halfEdgeId );
+        this->markDirtyHalfEdge( this->getHalfEdgePrev(halfEdgeId) );
+        this->markDirtyHalfEdge( prevId );
+        if( prevId!=MESH_NULL_ID )
+        {
+            this->markDirtyHalfEdge( this->getHalfEdgeNext(prevId) );
+        }
+    }
+    Storage::setHalfEdgePrev( halfEdgeId, prevId );
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setHalfEdgeOrigin(unsigned int halfEdgeId, unsigned int vertexId)
+{
+    if( this->dirtyTrackingEnabled )
+    {
+        this->markDirtyHalfEdge( halfEdgeId );
+        this->markDirtyVertex( this->getHalfEdgeOrigin(halfEdgeId) );
+        this->markDirtyVertex( vertexId );
+    }
+    this->adjacencyValid = false;
+    Storage::setHalfEdgeOrigin( halfEdgeId, vertexId );
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setHalfEdgeFace(unsigned int halfEdgeId, unsigned int faceId)
+{
+    if( this->dirtyTrackingEnabled )
+    {
+        this->markDirtyHalfEdge( halfEdgeId );
+        this->markDirtyFace( this->getHalfEdgeFace(halfEdgeId) );
+        this->markDirtyFace( faceId );
+    }
+    Storage::setHalfEdgeFace( halfEdgeId, faceId );
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::setDirtyTrackingEnabled(bool enabled)
+{
+    this->dirtyTrackingEnabled = enabled;
+    this->allDirty = false;
+    this->dirtyVertices.clear();
+    this->dirtyHalfEdges.clear();
+    this->dirtyFaces.clear();
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+bool Mesh<Vdt,Hdt,Fdt,St>::isDirtyTrackingEnabled() const
+{
+    return this->dirtyTrackingEnabled;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::validateDirty(ValidationReport& report)
+{
+    if( !this->dirtyTrackingEnabled || this->allDirty )
+    {
+        this->validate( report );
+    }
+    else
+    {
+        const unsigned int numHalfEdges = this->getNumHalfEdges();
+
+        // the neighbours of a changed half-edge check their pointers to it
+        std::vector<unsigned int> halfEdges;
+        halfEdges.reserve( 4*this->dirtyHalfEdges.size() );
+        for( size_t i=0; i<this->dirtyHalfEdges.size(); ++i )
+        {
+            const unsigned int edgeId = this->dirtyHalfEdges[i];
+            if( edgeId>=numHalfEdges )
+            {
+                continue;
+            }
+            halfEdges.push_back( edgeId );
+            const unsigned int neighbours[3] = { this->getHalfEdgeTwin(edgeId), this->getHalfEdgeNext(edgeId), this->getHalfEdgePrev(edgeId) };
+            for( unsigned int k=0; k<3; ++k )
+            {
+                if( neighbours[k]<numHalfEdges )
+                {
+                    halfEdges.push_back( neighbours[k] );
+                }
+            }
+        }
+        std::sort( halfEdges.begin(), halfEdges.end() );
+        halfEdges.erase( std::unique( halfEdges.begin(), halfEdges.end() ), halfEdges.end() );
+
+        // the faces of the half-edges check their loops. The vertices of
+        // the half-edges are added by validateRegion
+        std::vector<unsigned int>& faces = this->dirtyFaces;
+        for( size_t i=0; i<halfEdges.size(); ++i )
+        {
+            const unsigned int faceId = this->getHalfEdgeFace( halfEdges[i] );
+            if( faceId!=MESH_NULL_ID )
+            {
+                faces.push_back( faceId );
+            }
+        }
+        std::sort( faces.begin(), faces.end() );
+        faces.erase( std::unique( faces.begin(), faces.end() ), faces.end() );
+
+        std::vector<unsigned int>& vertices = this->dirtyVertices;
+        std::sort( vertices.begin(), vertices.end() );
+        vertices.erase( std::unique( vertices.begin(), vertices.end() ), vertices.end() );
+
+        MeshValidator<MeshT>::validateRegion( *this, vertices, halfEdges, faces, report );
+    }
+
+    this->allDirty = false;
+    this->dirtyVertices.clear();
+    this->dirtyHalfEdges.clear();
+    this->dirtyFaces.clear();
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+const VertexAdjacency& Mesh<Vdt,Hdt,Fdt,St>::getAdjacency() const
+{
+    // the size catches the vertices added directly to the list
+    if( !this->adjacencyValid || this->adjacency.getNumVertices()!=this->getNumVertices() )
+    {
+        this->adjacency.build( *this );
+        this->adjacencyValid = true;
+    }
+    return this->adjacency;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::invalidateAdjacency()
+{
+    this->adjacencyValid = false;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::markDirtyVertex(unsigned int vertexId)
+{
+    if( this->dirtyTrackingEnabled && !this->allDirty && vertexId!=MESH_NULL_ID )
+    {
+        this->dirtyVertices.push_back( vertexId );
+    }
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::markDirtyHalfEdge(unsigned int halfEdgeId)
+{
+    if( this->dirtyTrackingEnabled && !this->allDirty && halfEdgeId!=MESH_NULL_ID )
+    {
+        this->dirtyHalfEdges.push_back( halfEdgeId );
+    }
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::markDirtyFace(unsigned int faceId)
+{
+    if( this->dirtyTrackingEnabled && !this->allDirty && faceId!=MESH_NULL_ID )
+    {
+        this->dirtyFaces.push_back( faceId );
+    }
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::buildHalfEdgeIndex()
+{
+    const unsigned int numEdges = this->getNumHalfEdges();
+    this->halfEdgeIndex.clear();
+    this->halfEdgeIndex.reserve( numEdges );
+    for( unsigned int edgeId=0; edgeId<numEdges; ++edgeId )
+    {
+        const unsigned int origin = this->getHalfEdgeOrigin(edgeId);
+        const unsigned int twin = this->getHalfEdgeTwin(edgeId);
+        if( origin!=MESH_NULL_ID && twin!=MESH_NULL_ID && this->getHalfEdgeOrigin(twin)!=MESH_NULL_ID )
+        {
+            this->halfEdgeIndex.insert( origin, this->getHalfEdgeOrigin(twin), edgeId );
+        }
+    }
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+AttributeSet& Mesh<Vdt,Hdt,Fdt,St>::getVertexAttributes()
+{
+    this->vertexAttributes.resize( this->getNumVertices() );
+    return this->vertexAttributes;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+const AttributeSet& Mesh<Vdt,Hdt,Fdt,St>::getVertexAttributes() const
+{
+    return this->vertexAttributes;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+AttributeSet& Mesh<Vdt,Hdt,Fdt,St>::getHalfEdgeAttributes()
+{
+    this->halfEdgeAttributes.resize( this->getNumHalfEdges() );
+    return this->halfEdgeAttributes;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+const AttributeSet& Mesh<Vdt,Hdt,Fdt,St>::getHalfEdgeAttributes() const
+{
+    return this->halfEdgeAttributes;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+AttributeSet& Mesh<Vdt,Hdt,Fdt,St>::getFaceAttributes()
+{
+    this->faceAttributes.resize( this->getNumFaces() );
+    return this->faceAttributes;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+const AttributeSet& Mesh<Vdt,Hdt,Fdt,St>::getFaceAttributes() const
+{
+    return this->faceAttributes;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::checkAllFaces() const
+{
+    ValidationReport report;
+    this->validate( report );
+    report.throwIfInvalid();
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::validate(ValidationReport& report, unsigned int threadCount) const
+{
+    MeshValidator<MeshT>::validate( *this, report, threadCount );
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::checkFace(unsigned int faceId) const
+{
+    const unsigned int boundary = this->getFaceBoundary(faceId);
+
+    if( boundary==MESH_NULL_ID )
+    {
+        throw cpp::Exception("Every face must have a boundary (1)");
+    }
+
+    typedef CirculatorRange<MeshT, AroundFaceStep, HalfEdgeValue> HalfEdgeRange;
+    typedef CirculatorRange<MeshT, AroundVertexStep, HalfEdgeValue> OutgoingRange;
+    unsigned int edge = MESH_NULL_ID;
+    const HalfEdgeRange halfEdges = faceHalfEdges( *this, faceId );
+    for( typename HalfEdgeRange::iterator it=halfEdges.begin(); it!=halfEdges.end(); ++it )
+    {
+        edge = *it;
+
+        if( this->getHalfEdgeFace(edge)!=faceId )
+        {
+            throw cpp::Exception("The sequence of half-edges pointed by face->boundary must point to the same face (2)");
+        }
+
+        const unsigned int origin = this->getHalfEdgeOrigin(edge);
+        if( origin==MESH_NULL_ID )
+        {
+            throw cpp::Exception("Every edge must have an origin vertex (3)");
+        }
+
+        if( this->getVertexIncidentEdge(origin)==MESH_NULL_ID )
+        {
+            throw cpp::Exception("Every vertex must have a incident pointer (4)");
+        }
+
+        const unsigned int twin = this->getHalfEdgeTwin(edge);
+        if( twin==MESH_NULL_ID )
+        {
+            throw cpp::Exception("Every edge must have an twin edge (5)");
+        }
+
+        const unsigned int next = this->getHalfEdgeNext(edge);
+        if( next==MESH_NULL_ID )
+        {
+            throw cpp::Exception("Every edge must have a next half-edge pointer (6)");
+        }
+        else if( this->getHalfEdgeOrigin(next)!=this->getHalfEdgeOrigin(twin) )
+        {
+            throw cpp::Exception("The pointer edge->next->origin must be equal to edge->twin->origin (7)");
+        }
+
+        const unsigned int prev = this->getHalfEdgePrev(edge);
+        if( prev==MESH_NULL_ID )
         {
             throw cpp::Exception("Every edge must have a prev pointer (8)");
         }
-        else if( edge->getPrev()->getTwin()->getOrigin()!=edge->getOrigin() )
+        else if( this->getHalfEdgeOrigin( this->getHalfEdgeTwin(prev) )!=origin )
         {
             throw cpp::Exception("The pointer edge->prev->twin->origin must be equal to edge->origin (9)");
         }
 
         bool edgeFound = false;
         unsigned int count = 0;
-        EdgeIterator vit( edge->getOrigin() );
-        while(vit.hasNext())
+        const OutgoingRange outgoing = vertexOutgoingHalfEdges( *this, origin );
+        for( typename OutgoingRange::iterator vit=outgoing.begin(); vit!=outgoing.end(); ++vit )
         {
-            if (vit.getNext() == edge)
+            if (*vit == edge)
             {
                 edgeFound = true;
                 break;
@@ -934,105 +2227,114 @@ void Mesh<Vdt,Hdt,Fdt>::checkFace(unsigned int faceId) const
             throw cpp::Exception("The edge cannot be reachable iterating thought its origin (11)");
         }
 
-        if (edge->getTwin()->getFace()==NULL)
+        if (this->getHalfEdgeFace(twin)==MESH_NULL_ID)
         {
-            const HalfEdge* initialBorder = edge->getTwin();
-            const HalfEdge* cEdge = initialBorder->getNext();
+            const unsigned int initialBorder = twin;
+            unsigned int cEdge = this->getHalfEdgeNext(initialBorder);
             while( cEdge!=initialBorder  )
             {
-                if (cEdge->getFace()!=NULL)
+                if (this->getHalfEdgeFace(cEdge)!=MESH_NULL_ID)
                 {
                     throw cpp::Exception("The sequence of half edges on the border does not points to a null face (12)");
                 }
-                cEdge = cEdge->getNext();
+                cEdge = this->getHalfEdgeNext(cEdge);
             }
         }
     }
 
-    if( edge->getNext()!=face->getBoundary() )
+    if( this->getHalfEdgeNext(edge)!=boundary )
     {
         throw cpp::Exception("The pointer edge->next of the last edge in a face border must be equals to the face->boundary (12)");
     }
 };
 
-template<class Vdt, class Hdt, class Fdt>
-void Mesh<Vdt,Hdt,Fdt>::manageUnhandledTriangles()
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::manageUnhandledTriangles()
 {
-    if( unhandledTrianglesCount*3 != unhandledTriangles.size() )
+    // each pass retries all delayed faces, in the order they were
+    // delayed. The faces that are still ambiguous are delayed again by
+    // createPolygonFace, into the (now empty) unhandledFaces buffer
+    while( !this->unhandledFaces.empty() )
     {
-        throw cpp::Exception("The number of unhandled triangles should be equal to the number of unhandled vertices*3!");
-    }
-
-    unsigned int curTriangle = 0;
-    while( !this->unhandledTriangles.empty() )
-    {
-        if( curTriangle==unhandledTrianglesCount )
+        const unsigned int delayedCount = this->unhandledFacesCount;
+        this->retriedFaces.swap( this->unhandledFaces );
+        this->unhandledFaces.clear();
+        this->unhandledFacesCount = 0;
+
+        const unsigned int* face = &this->retriedFaces[0];
+        const unsigned int* end = face + this->retriedFaces.size();
+        while( face!=end )
         {
-            unsigned int remainingTriangles = this->unhandledTriangles.size() / 3;
-            if( remainingTriangles<unhandledTrianglesCount )
-            {
-                unhandledTrianglesCount = remainingTriangles;
-                curTriangle = 0;
-            }
-            else
-            {
-                throw cpp::Exception("There are triangles that cannot be added to the mesh!");
-            }
+            const unsigned int vertexCount = face[0];
+            this->createPolygonFace( face+1, vertexCount );
+            face += vertexCount+1;
         }
+        this->retriedFaces.clear();
 
-        int v1 = unhandledTriangles.front();
-        unhandledTriangles.pop_front();
-        int v2 = unhandledTriangles.front();
-        unhandledTriangles.pop_front();
-        int v3 = unhandledTriangles.front();
-        unhandledTriangles.pop_front();
-        unsigned int fid = this->createTriangularFace(v1,v2,v3);
-        if( fid==-1 ) //ajust the number of triangles in case of the triangle was not added to the mesh
+        if( this->unhandledFacesCount>=delayedCount )
         {
-            unhandledTrianglesCount--;
+            throw cpp::Exception("There are triangles that cannot be added to the mesh!");
         }
-
-        curTriangle++;
     }
 }
 
-template<class Vdt, class Hdt, class Fdt>
-int Mesh<Vdt,Hdt,Fdt>::getNumUnhandledTriangles() const
+template<class Vdt, class Hdt, class Fdt, class St>
+int Mesh<Vdt,Hdt,Fdt,St>::getNumUnhandledTriangles() const
 {
-    return this->unhandledTrianglesCount;
+    return this->unhandledFacesCount;
+}
+
+template<class Vdt, class Hdt, class Fdt, class St>
+typename Mesh<Vdt,Hdt,Fdt,St>::HalfEdge* Mesh<Vdt,Hdt,Fdt,St>::findIncidentHalfEdge(Vertex* vertex)
+{
+    unsigned int edgeId = this->findIncidentHalfEdge( this->getVertexId(vertex) );
+    if( edgeId==MESH_NULL_ID )
+    {
+        return NULL;
+    }
+    return this->getHalfEdge(edgeId);
 }
 
-template<class Vdt, class Hdt, class Fdt>
-HalfEdgeT<Vdt,Hdt,Fdt>* Mesh<Vdt,Hdt,Fdt>::findIncidentHalfEdge(Vertex* vertex)
+template<class Vdt, class Hdt, class Fdt, class St>
+unsigned int Mesh<Vdt,Hdt,Fdt,St>::findIncidentHalfEdge(unsigned int vertexId) const
 {
-    HalfEdge* edgeTmp = NULL;
-    HalfEdge* result = NULL;
+    unsigned int edgeTmp = MESH_NULL_ID;
+    unsigned int result = MESH_NULL_ID;
     int nullFacesCount=0;
-    EdgeIterator it(vertex);
-    while( it.hasNext() )
+    typedef CirculatorRange<MeshT, AroundVertexStep, HalfEdgeValue> OutgoingRange;
+    const OutgoingRange outgoing = vertexOutgoingHalfEdges( *this, vertexId );
+    for( typename OutgoingRange::iterator it=outgoing.begin(); it!=outgoing.end(); ++it )
     {
-        edgeTmp = it.getNext();
-        if( edgeTmp->getTwin()->getFace()==NULL )
+        edgeTmp = *it;
+        if( this->getHalfEdgeFace( this->getHalfEdgeTwin(edgeTmp) )==MESH_NULL_ID )
         {
-            result = edgeTmp->getTwin();
+            result = this->getHalfEdgeTwin(edgeTmp);
             nullFacesCount++;
         }
     }
     if( nullFacesCount!=1 )
     {
-        result = NULL;
+        result = MESH_NULL_ID;
     }
     return result;
 }
 
-template<class Vdt, class Hdt, class Fdt>
-void Mesh<Vdt,Hdt,Fdt>::clear()
+template<class Vdt, class Hdt, class Fdt, class St>
+void Mesh<Vdt,Hdt,Fdt,St>::clear()
 {
-    this->vertices.clear();
-    this->edges.clear();
-    this->faces.clear();
-    this->unhandledTriangles.clear();
-    this->unhandledTrianglesCount = 0;
+    this->clearStorage();
+    this->vertexAttributes.resize( 0 );
+    this->halfEdgeAttributes.resize( 0 );
+    this->faceAttributes.resize( 0 );
+    this->unhandledFaces.clear();
+    this->unhandledFacesCount = 0;
+    this->halfEdgeIndex.clear();
+    this->allDirty = false;
+    this->dirtyVertices.clear();
+    this->dirtyHalfEdges.clear();
+    this->dirtyFaces.clear();
+    this->adjacency.clear();
+    this->adjacencyValid = false;
 }
 
 #endif//DCEL_Mesh_h
@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_MeshPermutation_h
+#define DCEL_MeshPermutation_h
+
+#include <vector>
+
+#include "MeshStorage.h"
+
+/**
+	The new ID of each vertex, half-edge and face of a mesh, used by
+    Mesh::permute to move its elements. The element with ID=i goes to the
+    position getVertices()[i] (or getHalfEdges()[i], or getFaces()[i]).
+
+    After a mesh is permuted, the same permutation updates the arrays and
+    the IDs kept out of the mesh:
+
+        MeshPermutation permutation;
+        MeshReorder<MyMesh>::reorder( mesh, permutation );
+        permutation.apply( permutation.getVertices(), myVertexColors );
+        selectedFace = permutation.getNewFaceId( selectedFace );
+
+    A half-edge and its twin are stored together (2k and 2k+1), so the new
+    IDs of the half-edges 2k and 2k+1 must also be a pair.
+*/
+class MeshPermutation
+{
+public:
+
+    std::vector<unsigned int>& getVertices()
+    {
+        return this->vertices;
+    };
+
+    const std::vector<unsigned int>& getVertices() const
+    {
+        return this->vertices;
+    };
+
+    std::vector<unsigned int>& getHalfEdges()
+    {
+        return this->halfEdges;
+    };
+
+    const std::vector<unsigned int>& getHalfEdges() const
+    {
+        return this->halfEdges;
+    };
+
+    std::vector<unsigned int>& getFaces()
+    {
+        return this->faces;
+    };
+
+    const std::vector<unsigned int>& getFaces() const
+    {
+        return this->faces;
+    };
+
+    /**
+    	The new ID of an element. MESH_NULL_ID is kept as it is.
+    */
+    inline unsigned int getNewVertexId(unsigned int vertexId) const
+    {
+        return vertexId!=MESH_NULL_ID? this->vertices[vertexId] : MESH_NULL_ID;
+    };
+
+    inline unsigned int getNewHalfEdgeId(unsigned int halfEdgeId) const
+    {
+        return halfEdgeId!=MESH_NULL_ID? this->halfEdges[halfEdgeId] : MESH_NULL_ID;
+    };
+
+    inline unsigned int getNewFaceId(unsigned int faceId) const
+    {
+        return faceId!=MESH_NULL_ID? this->faces[faceId] : MESH_NULL_ID;
+    };
+
+    /**
+    	Sets the permutation that doesn't move any element.
+    */
+    void setIdentity(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+    {
+        setIdentity( this->vertices, numVertices );
+        setIdentity( this->halfEdges, numHalfEdges );
+        setIdentity( this->faces, numFaces );
+    };
+
+    /**
+    	Returns true if the permutation has one new ID for each element of a
+        mesh with these numbers of elements, no two elements go to the same
+        position, and the half-edge pairs are kept.
+    */
+    bool isValid(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces) const
+    {
+        if( !isPermutation( this->vertices, numVertices )
+            || !isPermutation( this->halfEdges, numHalfEdges )
+            || !isPermutation( this->faces, numFaces ) )
+        {
+            return false;
+        }
+        for( unsigned int halfEdgeId=0; halfEdgeId+1<numHalfEdges; halfEdgeId+=2 )
+        {
+            if( this->halfEdges[halfEdgeId+1]!=(this->halfEdges[halfEdgeId] ^ 1u) )
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    /**
+    	Moves each value of an array indexed by the old IDs to the position
+        of the new ID, using one of the lists above:
+
+            permutation.apply( permutation.getFaces(), faceLabels );
+    */
+    template<class T>
+    static void apply(const std::vector<unsigned int>& newIds, std::vector<T>& values)
+    {
+        std::vector<T> permuted( values.size() );
+        for( size_t i=0; i<values.size(); ++i )
+        {
+            permuted[ newIds[i] ] = values[i];
+        }
+        values.swap( permuted );
+    };
+
+protected:
+private:
+
+    static void setIdentity(std::vector<unsigned int>& newIds, unsigned int count)
+    {
+        newIds.resize( count );
+        for( unsigned int i=0; i<count; ++i )
+        {
+            newIds[i] = i;
+        }
+    };
+
+    static bool isPermutation(const std::vector<unsigned int>& newIds, unsigned int count)
+    {
+        if( newIds.size()!=count )
+        {
+            return false;
+        }
+        std::vector<bool> used( count, false );
+        for( unsigned int i=0; i<count; ++i )
+        {
+            if( newIds[i]>=count || used[ newIds[i] ] )
+            {
+                return false;
+            }
+            used[ newIds[i] ] = true;
+        }
+        return true;
+    };
+
+    std::vector<unsigned int> vertices;
+    std::vector<unsigned int> halfEdges;
+    std::vector<unsigned int> faces;
+};
+
+#endif//DCEL_MeshPermutation_h
@@ -0,0 +1,333 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_MeshReorder_h
+#define DCEL_MeshReorder_h
+
+#include <vector>
+#include <algorithm>
+
+#include "IntTypes.h"
+#include "Exception.h"
+#include "MeshPermutation.h"
+#include "Circulators.h"
+
+/**
+	The curves that can be used to sort the vertices by their position.
+*/
+enum SpaceFillingCurve
+{
+    /**
+    	The Z-order: the bits of the coordinates are interleaved. It is the
+        fastest to compute.
+    */
+    CURVE_MORTON,
+
+    /**
+    	The Hilbert curve, that never jumps between distant cells, so the
+        vertices that are neighbours in the order are closer than with the
+        Z-order.
+    */
+    CURVE_HILBERT
+};
+
+/**
+	Finds an order of the elements of a mesh where the elements that are
+    close in space are also close in memory, and moves them to it. The IDs of
+    the meshes read from files follow the order of the file, that can be
+    random in space (like the scanned ones), so the walks around the vertices
+    and faces jump all over the memory.
+
+        MeshPermutation permutation;
+        MeshReorder<MyMesh>::reorder( mesh, permutation );
+
+    The vertices are sorted along a space filling curve, the faces by their
+    first vertex in the new order, and the edges in the order they are found
+    walking around the faces in the new order. The half-edges of a face are
+    apart only by their twins, as the twins are stored in pairs (2k, 2k+1).
+
+    The position of a vertex is VertexData::position, the same used by the
+    importers (a Vector3 or any class with x, y and z). The permutation can
+    be used to update the arrays and the IDs kept out of the mesh.
+*/
+template<class MeshT>
+class MeshReorder
+{
+public:
+
+    /**
+    	Computes the order, and moves the elements of the mesh to it (see
+        Mesh::permute).
+    */
+    static void reorder(MeshT& mesh, MeshPermutation& permutation, SpaceFillingCurve curve = CURVE_HILBERT);
+
+    /**
+    	Only computes the order, without changing the mesh.
+    */
+    static void computePermutation(const MeshT& mesh, MeshPermutation& permutation, SpaceFillingCurve curve = CURVE_HILBERT);
+
+    /**
+    	The position of a point along the curve, for coordinates with up to
+        21 bits each.
+    */
+    static uint64_t getMortonCode(uint32_t x, uint32_t y, uint32_t z);
+    static uint64_t getHilbertCode(uint32_t x, uint32_t y, uint32_t z);
+
+protected:
+private:
+
+    /**
+    	The number of bits of each coordinate in the codes: 3*21 bits fit in
+        a 64-bit code.
+    */
+    enum { CODE_BITS = 21 };
+
+    /**
+    	Puts two zero bits after each of the first 21 bits of the value.
+    */
+    static inline uint64_t spreadBits(uint32_t value);
+
+    static inline void getPosition(const MeshT& mesh, unsigned int vertexId, float* position);
+
+    static void computeVertexOrder(const MeshT& mesh, SpaceFillingCurve curve, std::vector<unsigned int>& newIds);
+    static void computeFaceOrder(const MeshT& mesh, const std::vector<unsigned int>& newVertexIds, std::vector<unsigned int>& newIds);
+    static void computeHalfEdgeOrder(const MeshT& mesh, const std::vector<unsigned int>& newFaceIds, std::vector<unsigned int>& newIds);
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                            IMPLEMENTATION                            //
+//////////////////////////////////////////////////////////////////////////
+
+
+template<class MeshT>
+void MeshReorder<MeshT>::reorder(MeshT& mesh, MeshPermutation& permutation, SpaceFillingCurve curve)
+{
+    computePermutation( mesh, permutation, curve );
+    mesh.permute( permutation );
+}
+
+template<class MeshT>
+void MeshReorder<MeshT>::computePermutation(const MeshT& mesh, MeshPermutation& permutation, SpaceFillingCurve curve)
+{
+    computeVertexOrder( mesh, curve, permutation.getVertices() );
+    computeFaceOrder( mesh, permutation.getVertices(), permutation.getFaces() );
+    computeHalfEdgeOrder( mesh, permutation.getFaces(), permutation.getHalfEdges() );
+}
+
+template<class MeshT>
+uint64_t MeshReorder<MeshT>::spreadBits(uint32_t value)
+{
+    uint64_t x = value & 0x1fffff;
+    x = (x | x<<32) & 0x1f00000000ffffULL;
+    x = (x | x<<16) & 0x1f0000ff0000ffULL;
+    x = (x | x<<8)  & 0x100f00f00f00f00fULL;
+    x = (x | x<<4)  & 0x10c30c30c30c30c3ULL;
+    x = (x | x<<2)  & 0x1249249249249249ULL;
+    return x;
+}
+
+template<class MeshT>
+void MeshReorder<MeshT>::getPosition(const MeshT& mesh, unsigned int vertexId, float* position)
+{
+    position[0] = (float)mesh.getVertexData(vertexId).position.x;
+    position[1] = (float)mesh.getVertexData(vertexId).position.y;
+    position[2] = (float)mesh.getVertexData(vertexId).position.z;
+}
+
+template<class MeshT>
+uint64_t MeshReorder<MeshT>::getMortonCode(uint32_t x, uint32_t y, uint32_t z)
+{
+    return spreadBits(x)<<2 | spreadBits(y)<<1 | spreadBits(z);
+}
+
+template<class MeshT>
+uint64_t MeshReorder<MeshT>::getHilbertCode(uint32_t x, uint32_t y, uint32_t z)
+{
+    // the coordinates are transformed so that interleaving their bits gives
+    // the position along the curve (J. Skilling, "Programming the Hilbert
+    // curve", 2004)
+    uint32_t axes[3] = { x, y, z };
+    const uint32_t highestBit = 1u<<(CODE_BITS-1);
+
+    for( uint32_t bit=highestBit; bit>1; bit>>=1 )
+    {
+        const uint32_t lowerBits = bit-1;
+        for( int i=0; i<3; ++i )
+        {
+            if( axes[i] & bit )
+            {
+                axes[0] ^= lowerBits;
+            }
+            else
+            {
+                const uint32_t swapped = (axes[0] ^ axes[i]) & lowerBits;
+                axes[0] ^= swapped;
+                axes[i] ^= swapped;
+            }
+        }
+    }
+
+    // Gray code
+    axes[1] ^= axes[0];
+    axes[2] ^= axes[1];
+    uint32_t flip = 0;
+    for( uint32_t bit=highestBit; bit>1; bit>>=1 )
+    {
+        if( axes[2] & bit )
+        {
+            flip ^= bit-1;
+        }
+    }
+    axes[0] ^= flip;
+    axes[1] ^= flip;
+    axes[2] ^= flip;
+
+    return getMortonCode( axes[0], axes[1], axes[2] );
+}
+
+template<class MeshT>
+void MeshReorder<MeshT>::computeVertexOrder(const MeshT& mesh, SpaceFillingCurve curve, std::vector<unsigned int>& newIds)
+{
+    const unsigned int numVertices = mesh.getNumVertices();
+    newIds.resize( numVertices );
+    if( numVertices==0 )
+    {
+        return;
+    }
+
+    // the bounding box, scaled to the grid of the codes
+    float minimum[3], maximum[3], position[3];
+    getPosition( mesh, 0, minimum );
+    getPosition( mesh, 0, maximum );
+    for( unsigned int v=1; v<numVertices; ++v )
+    {
+        getPosition( mesh, v, position );
+        for( int axis=0; axis<3; ++axis )
+        {
+            minimum[axis] = std::min( minimum[axis], position[axis] );
+            maximum[axis] = std::max( maximum[axis], position[axis] );
+        }
+    }
+    // the same scale in all axes, so the cells are cubes
+    const float size = std::max( maximum[0]-minimum[0], std::max( maximum[1]-minimum[1], maximum[2]-minimum[2] ) );
+    const float maxCell = (float)((1u<<CODE_BITS)-1);
+    const float scale = size>0? maxCell/size : 0;
+
+    // sorts the pairs (code, old ID), so the vertices in the same cell keep
+    // their old order
+    std::vector< std::pair<uint64_t, unsigned int> > codes( numVertices );
+    for( unsigned int v=0; v<numVertices; ++v )
+    {
+        getPosition( mesh, v, position );
+        uint32_t cell[3];
+        for( int axis=0; axis<3; ++axis )
+        {
+            const float scaled = (position[axis]-minimum[axis])*scale;
+            cell[axis] = scaled>0? (uint32_t)std::min( scaled, maxCell ) : 0;
+        }
+        const uint64_t code = curve==CURVE_MORTON? getMortonCode( cell[0], cell[1], cell[2] ) : getHilbertCode( cell[0], cell[1], cell[2] );
+        codes[v] = std::make_pair( code, v );
+    }
+    std::sort( codes.begin(), codes.end() );
+
+    for( unsigned int i=0; i<numVertices; ++i )
+    {
+        newIds[ codes[i].second ] = i;
+    }
+}
+
+template<class MeshT>
+void MeshReorder<MeshT>::computeFaceOrder(const MeshT& mesh, const std::vector<unsigned int>& newVertexIds, std::vector<unsigned int>& newIds)
+{
+    typedef CirculatorRange<MeshT, AroundFaceStep, OriginValue> FaceVertexRange;
+
+    // the key of a face is its first vertex in the new order. The faces
+    // without a boundary go to the end
+    const unsigned int numFaces = mesh.getNumFaces();
+    const unsigned int numVertices = (unsigned int)newVertexIds.size();
+    std::vector<unsigned int> keys( numFaces );
+    std::vector<unsigned int> offsets( numVertices+2, 0 );
+    for( unsigned int f=0; f<numFaces; ++f )
+    {
+        unsigned int key = numVertices;
+        const FaceVertexRange vertices = faceVertices( mesh, f );
+        for( typename FaceVertexRange::iterator it=vertices.begin(); it!=vertices.end(); ++it )
+        {
+            if( *it!=MESH_NULL_ID )
+            {
+                key = std::min( key, newVertexIds[*it] );
+            }
+        }
+        keys[f] = key;
+        offsets[key+1]++;
+    }
+
+    // a counting sort, that keeps the old order of the faces with the same key
+    for( unsigned int key=0; key<=numVertices; ++key )
+    {
+        offsets[key+1] += offsets[key];
+    }
+    newIds.resize( numFaces );
+    for( unsigned int f=0; f<numFaces; ++f )
+    {
+        newIds[f] = offsets[ keys[f] ]++;
+    }
+}
+
+template<class MeshT>
+void MeshReorder<MeshT>::computeHalfEdgeOrder(const MeshT& mesh, const std::vector<unsigned int>& newFaceIds, std::vector<unsigned int>& newIds)
+{
+    typedef CirculatorRange<MeshT, AroundFaceStep, HalfEdgeValue> FaceHalfEdgeRange;
+
+    const unsigned int numHalfEdges = mesh.getNumHalfEdges();
+    const unsigned int numFaces = (unsigned int)newFaceIds.size();
+    if( numHalfEdges%2!=0 )
+    {
+        throw cpp::Exception("The half-edges must be stored in pairs of twins to be reordered");
+    }
+    newIds.assign( numHalfEdges, MESH_NULL_ID );
+
+    std::vector<unsigned int> faceOrder( numFaces );
+    for( unsigned int f=0; f<numFaces; ++f )
+    {
+        faceOrder[ newFaceIds[f] ] = f;
+    }
+
+    // each edge gets the next pair of IDs when it is first found, and the
+    // half-edge of the face being walked comes first in the pair
+    unsigned int nextPair = 0;
+    for( unsigned int i=0; i<numFaces; ++i )
+    {
+        const FaceHalfEdgeRange halfEdges = faceHalfEdges( mesh, faceOrder[i] );
+        for( typename FaceHalfEdgeRange::iterator it=halfEdges.begin(); it!=halfEdges.end(); ++it )
+        {
+            const unsigned int halfEdgeId = *it;
+            if( newIds[halfEdgeId]==MESH_NULL_ID )
+            {
+                newIds[halfEdgeId] = nextPair;
+                newIds[halfEdgeId ^ 1u] = nextPair+1;
+                nextPair += 2;
+            }
+        }
+    }
+
+    // the edges that are not in any face keep their old order
+    for( unsigned int halfEdgeId=0; halfEdgeId<numHalfEdges; halfEdgeId+=2 )
+    {
+        if( newIds[halfEdgeId]==MESH_NULL_ID )
+        {
+            newIds[halfEdgeId] = nextPair;
+            newIds[halfEdgeId+1] = nextPair+1;
+            nextPair += 2;
+        }
+    }
+}
+
+#endif//DCEL_MeshReorder_h
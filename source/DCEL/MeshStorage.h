@@ -0,0 +1,744 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_MeshStorage_h
+#define DCEL_MeshStorage_h
+
+#include <vector>
+#include <limits>
+
+#include "IntTypes.h"
+#include "Vertex.h"
+#include "Face.h"
+#include "HalfEdge.h"
+#include "Exception.h"
+
+#define MESH_NULL_ID (std::numeric_limits<unsigned int>::max())
+
+/**
+	These classes select how a Mesh stores the connections between its
+    vertices, half-edges and faces. One of them is given as the last template
+    parameter of the Mesh:
+
+        typedef Mesh<VertexData, HalfEdgeData, FaceData> MyMesh; // PointerStorage
+        typedef Mesh<VertexData, HalfEdgeData, FaceData, IndexStorage> MyIndexedMesh;
+
+    - PointerStorage: each element has pointers to the elements it is connected
+      to (VertexT, HalfEdgeT and FaceT). It is the default, and the only one
+      that works with the EdgeIterator and the HalfEdge::getNext()-like methods.
+      As the elements are referenced by their addresses, the lists of elements
+      must not be reallocated after the first face is created.
+
+    - IndexStorage: each element stores the 32-bit IDs of the elements it is
+      connected to (IndexVertexT, IndexHalfEdgeT and IndexFaceT). The elements
+      are smaller on 64-bit systems, and the lists can grow (or be copied, or
+      be written to a file) freely.
+
+    - CompactStorage: the same as the IndexStorage, but the half-edges don't
+      store their twins (CompactHalfEdgeT). The two half-edges of an edge
+      always have the IDs 2k and 2k+1, so the twin of a half-edge h is h^1.
+      The Mesh creates the half-edges in pairs, so this always holds for the
+      meshes built with its methods.
+
+    - SoAStorage: there are no element objects. Each connection (the next,
+      prev, origin and face of the half-edges, the incident edge of the
+      vertices and the boundary of the faces) and each kind of user data is
+      kept in its own array, and the twins are implicit as in the
+      CompactStorage. A pass that only follows the next half-edges reads
+      only the array of next IDs. The elements can only be reached by their
+      IDs (there is no getVertex(), getHalfEdges(), etc).
+*/
+struct PointerStorage {};
+struct IndexStorage {};
+struct CompactStorage {};
+struct SoAStorage {};
+
+/**
+	The base class of a Mesh, that holds its elements. It is specialized for
+    each of the storage classes above, and all of them have the same methods.
+
+    The public methods navigate through the mesh using IDs, and they work
+    with all storages. A connection that is not set is MESH_NULL_ID.
+
+    - getVertexIncidentEdge(vertexId), setVertexIncidentEdge(vertexId, halfEdgeId)
+    - getFaceBoundary(faceId), setFaceBoundary(faceId, halfEdgeId)
+    - getHalfEdgeTwin(halfEdgeId), setHalfEdgeTwin(halfEdgeId, twinId): the
+      setter makes both half-edges twins of each other.
+    - getHalfEdgeNext(halfEdgeId), setHalfEdgeNext(halfEdgeId, nextId): the
+      setter also makes halfEdgeId the previous half-edge of nextId.
+    - getHalfEdgePrev(halfEdgeId), setHalfEdgePrev(halfEdgeId, prevId): the
+      setter also makes halfEdgeId the next half-edge of prevId.
+      Given MESH_NULL_ID, these three setters only clear the connection of
+      halfEdgeId.
+    - getHalfEdgeOrigin(halfEdgeId), setHalfEdgeOrigin(halfEdgeId, vertexId)
+    - getHalfEdgeFace(halfEdgeId), setHalfEdgeFace(halfEdgeId, faceId)
+    - getVertexData(vertexId), getHalfEdgeData(halfEdgeId), getFaceData(faceId):
+      return a reference to the user data of the element.
+
+    The protected methods are used by the Mesh to create the elements.
+*/
+template<class VertexDataT, class HalfEdgeDataT, class FaceDataT, class StorageT>
+class MeshStorage;
+
+
+//////////////////////////////////////////////////////////////////////////
+//                            PointerStorage                            //
+//////////////////////////////////////////////////////////////////////////
+
+
+template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
+class MeshStorage<VertexDataT, HalfEdgeDataT, FaceDataT, PointerStorage>
+{
+public:
+
+    typedef VertexT<VertexDataT, HalfEdgeDataT, FaceDataT> Vertex;
+    typedef HalfEdgeT<VertexDataT, HalfEdgeDataT, FaceDataT> HalfEdge;
+    typedef FaceT<VertexDataT, HalfEdgeDataT, FaceDataT> Face;
+
+    inline unsigned int getVertexIncidentEdge(unsigned int vertexId) const
+    {
+        return this->toId( this->vertices[vertexId].getIncidentEdge() );
+    };
+
+    inline void setVertexIncidentEdge(unsigned int vertexId, unsigned int halfEdgeId)
+    {
+        this->vertices[vertexId].setIncidentEdge( this->toHalfEdge(halfEdgeId) );
+    };
+
+    inline unsigned int getFaceBoundary(unsigned int faceId) const
+    {
+        return this->toId( this->faces[faceId].getBoundary() );
+    };
+
+    inline void setFaceBoundary(unsigned int faceId, unsigned int halfEdgeId)
+    {
+        this->faces[faceId].setBoundary( this->toHalfEdge(halfEdgeId) );
+    };
+
+    inline unsigned int getHalfEdgeTwin(unsigned int halfEdgeId) const
+    {
+        return this->toId( this->edges[halfEdgeId].getTwin() );
+    };
+
+    inline void setHalfEdgeTwin(unsigned int halfEdgeId, unsigned int twinId)
+    {
+        this->edges[halfEdgeId].setTwin( this->toHalfEdge(twinId) );
+    };
+
+    inline unsigned int getHalfEdgeNext(unsigned int halfEdgeId) const
+    {
+        return this->toId( this->edges[halfEdgeId].getNext() );
+    };
+
+    inline void setHalfEdgeNext(unsigned int halfEdgeId, unsigned int nextId)
+    {
+        this->edges[halfEdgeId].setNext( this->toHalfEdge(nextId) );
+    };
+
+    inline unsigned int getHalfEdgePrev(unsigned int halfEdgeId) const
+    {
+        return this->toId( this->edges[halfEdgeId].getPrev() );
+    };
+
+    inline void setHalfEdgePrev(unsigned int halfEdgeId, unsigned int prevId)
+    {
+        this->edges[halfEdgeId].setPrev( this->toHalfEdge(prevId) );
+    };
+
+    inline unsigned int getHalfEdgeOrigin(unsigned int halfEdgeId) const
+    {
+        return this->toId( this->edges[halfEdgeId].getOrigin() );
+    };
+
+    inline void setHalfEdgeOrigin(unsigned int halfEdgeId, unsigned int vertexId)
+    {
+        this->edges[halfEdgeId].setOrigin( vertexId==MESH_NULL_ID? NULL : &this->vertices[vertexId] );
+    };
+
+    inline unsigned int getHalfEdgeFace(unsigned int halfEdgeId) const
+    {
+        return this->toId( this->edges[halfEdgeId].getFace() );
+    };
+
+    inline void setHalfEdgeFace(unsigned int halfEdgeId, unsigned int faceId)
+    {
+        this->edges[halfEdgeId].setFace( faceId==MESH_NULL_ID? NULL : &this->faces[faceId] );
+    };
+
+    inline VertexDataT& getVertexData(unsigned int vertexId)
+    {
+        return this->vertices[vertexId].getData();
+    };
+
+    inline const VertexDataT& getVertexData(unsigned int vertexId) const
+    {
+        return this->vertices[vertexId].getData();
+    };
+
+    inline HalfEdgeDataT& getHalfEdgeData(unsigned int halfEdgeId)
+    {
+        return this->edges[halfEdgeId].getData();
+    };
+
+    inline const HalfEdgeDataT& getHalfEdgeData(unsigned int halfEdgeId) const
+    {
+        return this->edges[halfEdgeId].getData();
+    };
+
+    inline FaceDataT& getFaceData(unsigned int faceId)
+    {
+        return this->faces[faceId].getData();
+    };
+
+    inline const FaceDataT& getFaceData(unsigned int faceId) const
+    {
+        return this->faces[faceId].getData();
+    };
+
+protected:
+
+    inline unsigned int vertexCount() const
+    {
+        return this->vertices.size();
+    };
+
+    inline unsigned int halfEdgeCount() const
+    {
+        return this->edges.size();
+    };
+
+    inline unsigned int faceCount() const
+    {
+        return this->faces.size();
+    };
+
+    inline unsigned int addVertex()
+    {
+        this->vertices.push_back( Vertex() );
+        return this->vertices.size()-1;
+    };
+
+    /**
+    	Adds two half-edges, and returns the ID of the first one. The second
+        one has the next ID.
+    */
+    inline unsigned int addHalfEdgePair()
+    {
+        this->edges.push_back( HalfEdge() );
+        this->edges.push_back( HalfEdge() );
+        return this->edges.size()-2;
+    };
+
+    inline unsigned int addFace()
+    {
+        this->faces.push_back( Face() );
+        return this->faces.size()-1;
+    };
+
+    inline void resizeStorage(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+    {
+        this->vertices.resize( numVertices );
+        this->edges.resize( numHalfEdges );
+        this->faces.resize( numFaces );
+    };
+
+    inline void reserveStorage(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+    {
+        this->vertices.reserve( numVertices );
+        this->edges.reserve( numHalfEdges );
+        this->faces.reserve( numFaces );
+    };
+
+    inline void clearStorage()
+    {
+        this->vertices.clear();
+        this->edges.clear();
+        this->faces.clear();
+    };
+
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    std::vector<HalfEdge> edges;
+
+private:
+
+    inline unsigned int toId(const Vertex* vertex) const
+    {
+        return vertex==NULL? MESH_NULL_ID : (unsigned int)(vertex - &this->vertices[0]);
+    };
+
+    inline unsigned int toId(const HalfEdge* halfEdge) const
+    {
+        return halfEdge==NULL? MESH_NULL_ID : (unsigned int)(halfEdge - &this->edges[0]);
+    };
+
+    inline unsigned int toId(const Face* face) const
+    {
+        return face==NULL? MESH_NULL_ID : (unsigned int)(face - &this->faces[0]);
+    };
+
+    inline HalfEdge* toHalfEdge(unsigned int halfEdgeId)
+    {
+        return halfEdgeId==MESH_NULL_ID? NULL : &this->edges[halfEdgeId];
+    };
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                      IndexStorage, CompactStorage                    //
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+	The part that is common to the storages that keep IDs in the elements.
+    They differ only on the half-edge class, and on how the twins are found.
+*/
+template<class VertexDataT, class HalfEdgeDataT, class FaceDataT, class HalfEdgeClassT>
+class IdMeshStorageBase
+{
+public:
+
+    typedef IndexVertexT<VertexDataT> Vertex;
+    typedef HalfEdgeClassT HalfEdge;
+    typedef IndexFaceT<FaceDataT> Face;
+
+    inline unsigned int getVertexIncidentEdge(unsigned int vertexId) const
+    {
+        return this->vertices[vertexId].getIncidentEdgeId();
+    };
+
+    inline void setVertexIncidentEdge(unsigned int vertexId, unsigned int halfEdgeId)
+    {
+        this->vertices[vertexId].setIncidentEdgeId( halfEdgeId );
+    };
+
+    inline unsigned int getFaceBoundary(unsigned int faceId) const
+    {
+        return this->faces[faceId].getBoundaryId();
+    };
+
+    inline void setFaceBoundary(unsigned int faceId, unsigned int halfEdgeId)
+    {
+        this->faces[faceId].setBoundaryId( halfEdgeId );
+    };
+
+    inline unsigned int getHalfEdgeNext(unsigned int halfEdgeId) const
+    {
+        return this->edges[halfEdgeId].getNextId();
+    };
+
+    inline void setHalfEdgeNext(unsigned int halfEdgeId, unsigned int nextId)
+    {
+        this->edges[halfEdgeId].setNextId( nextId );
+        if( nextId!=MESH_NULL_ID )
+        {
+            this->edges[nextId].setPrevId( halfEdgeId );
+        }
+    };
+
+    inline unsigned int getHalfEdgePrev(unsigned int halfEdgeId) const
+    {
+        return this->edges[halfEdgeId].getPrevId();
+    };
+
+    inline void setHalfEdgePrev(unsigned int halfEdgeId, unsigned int prevId)
+    {
+        this->edges[halfEdgeId].setPrevId( prevId );
+        if( prevId!=MESH_NULL_ID )
+        {
+            this->edges[prevId].setNextId( halfEdgeId );
+        }
+    };
+
+    inline unsigned int getHalfEdgeOrigin(unsigned int halfEdgeId) const
+    {
+        return this->edges[halfEdgeId].getOriginId();
+    };
+
+    inline void setHalfEdgeOrigin(unsigned int halfEdgeId, unsigned int vertexId)
+    {
+        this->edges[halfEdgeId].setOriginId( vertexId );
+    };
+
+    inline unsigned int getHalfEdgeFace(unsigned int halfEdgeId) const
+    {
+        return this->edges[halfEdgeId].getFaceId();
+    };
+
+    inline void setHalfEdgeFace(unsigned int halfEdgeId, unsigned int faceId)
+    {
+        this->edges[halfEdgeId].setFaceId( faceId );
+    };
+
+    inline VertexDataT& getVertexData(unsigned int vertexId)
+    {
+        return this->vertices[vertexId].getData();
+    };
+
+    inline const VertexDataT& getVertexData(unsigned int vertexId) const
+    {
+        return this->vertices[vertexId].getData();
+    };
+
+    inline HalfEdgeDataT& getHalfEdgeData(unsigned int halfEdgeId)
+    {
+        return this->edges[halfEdgeId].getData();
+    };
+
+    inline const HalfEdgeDataT& getHalfEdgeData(unsigned int halfEdgeId) const
+    {
+        return this->edges[halfEdgeId].getData();
+    };
+
+    inline FaceDataT& getFaceData(unsigned int faceId)
+    {
+        return this->faces[faceId].getData();
+    };
+
+    inline const FaceDataT& getFaceData(unsigned int faceId) const
+    {
+        return this->faces[faceId].getData();
+    };
+
+protected:
+
+    inline unsigned int vertexCount() const
+    {
+        return this->vertices.size();
+    };
+
+    inline unsigned int halfEdgeCount() const
+    {
+        return this->edges.size();
+    };
+
+    inline unsigned int faceCount() const
+    {
+        return this->faces.size();
+    };
+
+    inline unsigned int addVertex()
+    {
+        this->vertices.push_back( Vertex() );
+        return this->vertices.size()-1;
+    };
+
+    inline unsigned int addHalfEdgePair()
+    {
+        this->edges.push_back( HalfEdge() );
+        this->edges.push_back( HalfEdge() );
+        return this->edges.size()-2;
+    };
+
+    inline unsigned int addFace()
+    {
+        this->faces.push_back( Face() );
+        return this->faces.size()-1;
+    };
+
+    inline void resizeStorage(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+    {
+        this->vertices.resize( numVertices );
+        this->edges.resize( numHalfEdges );
+        this->faces.resize( numFaces );
+    };
+
+    inline void reserveStorage(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+    {
+        this->vertices.reserve( numVertices );
+        this->edges.reserve( numHalfEdges );
+        this->faces.reserve( numFaces );
+    };
+
+    inline void clearStorage()
+    {
+        this->vertices.clear();
+        this->edges.clear();
+        this->faces.clear();
+    };
+
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    std::vector<HalfEdge> edges;
+};
+
+template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
+class MeshStorage<VertexDataT, HalfEdgeDataT, FaceDataT, IndexStorage>:
+    public IdMeshStorageBase<VertexDataT, HalfEdgeDataT, FaceDataT, IndexHalfEdgeT<HalfEdgeDataT> >
+{
+public:
+
+    inline unsigned int getHalfEdgeTwin(unsigned int halfEdgeId) const
+    {
+        return this->edges[halfEdgeId].getTwinId();
+    };
+
+    inline void setHalfEdgeTwin(unsigned int halfEdgeId, unsigned int twinId)
+    {
+        this->edges[halfEdgeId].setTwinId( twinId );
+        if( twinId!=MESH_NULL_ID )
+        {
+            this->edges[twinId].setTwinId( halfEdgeId );
+        }
+    };
+};
+
+template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
+class MeshStorage<VertexDataT, HalfEdgeDataT, FaceDataT, CompactStorage>:
+    public IdMeshStorageBase<VertexDataT, HalfEdgeDataT, FaceDataT, CompactHalfEdgeT<HalfEdgeDataT> >
+{
+public:
+
+    inline unsigned int getHalfEdgeTwin(unsigned int halfEdgeId) const
+    {
+        return halfEdgeId ^ 1u;
+    };
+
+    /**
+    	The twins are fixed by their IDs, so this only checks that twinId is
+        the pair of halfEdgeId.
+    */
+    inline void setHalfEdgeTwin(unsigned int halfEdgeId, unsigned int twinId)
+    {
+        if( twinId!=(halfEdgeId ^ 1u) )
+        {
+            throw cpp::Exception("With the CompactStorage, the twin of the half-edge 2k must be the half-edge 2k+1");
+        }
+    };
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                              SoAStorage                              //
+//////////////////////////////////////////////////////////////////////////
+
+
+/**
+	The SoAStorage has no element objects. These classes are only declared,
+    so the Mesh methods that deal with pointers to the elements can't be used
+    with it.
+*/
+template<class DataT> class SoAVertexT;
+template<class DataT> class SoAHalfEdgeT;
+template<class DataT> class SoAFaceT;
+
+template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
+class MeshStorage<VertexDataT, HalfEdgeDataT, FaceDataT, SoAStorage>
+{
+public:
+
+    typedef SoAVertexT<VertexDataT> Vertex;
+    typedef SoAHalfEdgeT<HalfEdgeDataT> HalfEdge;
+    typedef SoAFaceT<FaceDataT> Face;
+
+    inline unsigned int getVertexIncidentEdge(unsigned int vertexId) const
+    {
+        return this->incidentEdgeIds[vertexId];
+    };
+
+    inline void setVertexIncidentEdge(unsigned int vertexId, unsigned int halfEdgeId)
+    {
+        this->incidentEdgeIds[vertexId] = halfEdgeId;
+    };
+
+    inline unsigned int getFaceBoundary(unsigned int faceId) const
+    {
+        return this->boundaryIds[faceId];
+    };
+
+    inline void setFaceBoundary(unsigned int faceId, unsigned int halfEdgeId)
+    {
+        this->boundaryIds[faceId] = halfEdgeId;
+    };
+
+    inline unsigned int getHalfEdgeTwin(unsigned int halfEdgeId) const
+    {
+        return halfEdgeId ^ 1u;
+    };
+
+    /**
+    	As in the CompactStorage, this only checks that twinId is the pair
+        of halfEdgeId.
+    */
+    inline void setHalfEdgeTwin(unsigned int halfEdgeId, unsigned int twinId)
+    {
+        if( twinId!=(halfEdgeId ^ 1u) )
+        {
+            throw cpp::Exception("With the SoAStorage, the twin of the half-edge 2k must be the half-edge 2k+1");
+        }
+    };
+
+    inline unsigned int getHalfEdgeNext(unsigned int halfEdgeId) const
+    {
+        return this->nextIds[halfEdgeId];
+    };
+
+    inline void setHalfEdgeNext(unsigned int halfEdgeId, unsigned int nextId)
+    {
+        this->nextIds[halfEdgeId] = nextId;
+        if( nextId!=MESH_NULL_ID )
+        {
+            this->prevIds[nextId] = halfEdgeId;
+        }
+    };
+
+    inline unsigned int getHalfEdgePrev(unsigned int halfEdgeId) const
+    {
+        return this->prevIds[halfEdgeId];
+    };
+
+    inline void setHalfEdgePrev(unsigned int halfEdgeId, unsigned int prevId)
+    {
+        this->prevIds[halfEdgeId] = prevId;
+        if( prevId!=MESH_NULL_ID )
+        {
+            this->nextIds[prevId] = halfEdgeId;
+        }
+    };
+
+    inline unsigned int getHalfEdgeOrigin(unsigned int halfEdgeId) const
+    {
+        return this->originIds[halfEdgeId];
+    };
+
+    inline void setHalfEdgeOrigin(unsigned int halfEdgeId, unsigned int vertexId)
+    {
+        this->originIds[halfEdgeId] = vertexId;
+    };
+
+    inline unsigned int getHalfEdgeFace(unsigned int halfEdgeId) const
+    {
+        return this->faceIds[halfEdgeId];
+    };
+
+    inline void setHalfEdgeFace(unsigned int halfEdgeId, unsigned int faceId)
+    {
+        this->faceIds[halfEdgeId] = faceId;
+    };
+
+    inline VertexDataT& getVertexData(unsigned int vertexId)
+    {
+        return this->vertexData[vertexId];
+    };
+
+    inline const VertexDataT& getVertexData(unsigned int vertexId) const
+    {
+        return this->vertexData[vertexId];
+    };
+
+    inline HalfEdgeDataT& getHalfEdgeData(unsigned int halfEdgeId)
+    {
+        return this->halfEdgeData[halfEdgeId];
+    };
+
+    inline const HalfEdgeDataT& getHalfEdgeData(unsigned int halfEdgeId) const
+    {
+        return this->halfEdgeData[halfEdgeId];
+    };
+
+    inline FaceDataT& getFaceData(unsigned int faceId)
+    {
+        return this->faceData[faceId];
+    };
+
+    inline const FaceDataT& getFaceData(unsigned int faceId) const
+    {
+        return this->faceData[faceId];
+    };
+
+protected:
+
+    inline unsigned int vertexCount() const
+    {
+        return this->incidentEdgeIds.size();
+    };
+
+    inline unsigned int halfEdgeCount() const
+    {
+        return this->nextIds.size();
+    };
+
+    inline unsigned int faceCount() const
+    {
+        return this->boundaryIds.size();
+    };
+
+    inline unsigned int addVertex()
+    {
+        this->incidentEdgeIds.push_back( MESH_NULL_ID );
+        this->vertexData.push_back( VertexDataT() );
+        return this->incidentEdgeIds.size()-1;
+    };
+
+    inline unsigned int addHalfEdgePair()
+    {
+        const unsigned int halfEdgeId = this->nextIds.size();
+        this->resizeHalfEdges( halfEdgeId+2 );
+        return halfEdgeId;
+    };
+
+    inline unsigned int addFace()
+    {
+        this->boundaryIds.push_back( MESH_NULL_ID );
+        this->faceData.push_back( FaceDataT() );
+        return this->boundaryIds.size()-1;
+    };
+
+    inline void resizeStorage(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+    {
+        this->incidentEdgeIds.resize( numVertices, MESH_NULL_ID );
+        this->vertexData.resize( numVertices );
+        this->resizeHalfEdges( numHalfEdges );
+        this->boundaryIds.resize( numFaces, MESH_NULL_ID );
+        this->faceData.resize( numFaces );
+    };
+
+    inline void reserveStorage(unsigned int numVertices, unsigned int numHalfEdges, unsigned int numFaces)
+    {
+        this->incidentEdgeIds.reserve( numVertices );
+        this->vertexData.reserve( numVertices );
+        this->nextIds.reserve( numHalfEdges );
+        this->prevIds.reserve( numHalfEdges );
+        this->originIds.reserve( numHalfEdges );
+        this->faceIds.reserve( numHalfEdges );
+        this->halfEdgeData.reserve( numHalfEdges );
+        this->boundaryIds.reserve( numFaces );
+        this->faceData.reserve( numFaces );
+    };
+
+    inline void clearStorage()
+    {
+        this->resizeStorage( 0, 0, 0 );
+    };
+
+    std::vector<uint32_t> incidentEdgeIds;
+    std::vector<VertexDataT> vertexData;
+
+    std::vector<uint32_t> nextIds;
+    std::vector<uint32_t> prevIds;
+    std::vector<uint32_t> originIds;
+    std::vector<uint32_t> faceIds;
+    std::vector<HalfEdgeDataT> halfEdgeData;
+
+    std::vector<uint32_t> boundaryIds;
+    std::vector<FaceDataT> faceData;
+
+private:
+
+    inline void resizeHalfEdges(unsigned int numHalfEdges)
+    {
+        this->nextIds.resize( numHalfEdges, MESH_NULL_ID );
+        this->prevIds.resize( numHalfEdges, MESH_NULL_ID );
+        this->originIds.resize( numHalfEdges, MESH_NULL_ID );
+        this->faceIds.resize( numHalfEdges, MESH_NULL_ID );
+        this->halfEdgeData.resize( numHalfEdges );
+    };
+};
+
+#endif//DCEL_MeshStorage_h
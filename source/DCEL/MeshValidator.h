@@ -0,0 +1,622 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_MeshValidator_h
+#define DCEL_MeshValidator_h
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#include "MeshStorage.h"
+#include "Parallel.h"
+#include "Exception.h"
+
+/**
+	A broken invariant of a mesh, found by the MeshValidator: the element
+    where it was found, and the number of the invariant (the same numbers
+    used by Mesh::checkFace).
+*/
+class MeshViolation
+{
+public:
+
+    enum ElementType
+    {
+        VERTEX,
+        HALF_EDGE,
+        FACE
+    };
+
+    MeshViolation(ElementType elementType, unsigned int elementId, unsigned int invariant):
+        elementType(elementType),
+        elementId(elementId),
+        invariant(invariant)
+    {
+    };
+
+    /**
+    	The text of the invariant, ending with its number, like
+        "Every face must have a boundary (1)".
+    */
+    const char* getDescription() const
+    {
+        switch( this->invariant )
+        {
+        case 1:  return "Every face must have a boundary (1)";
+        case 2:  return "The sequence of half-edges pointed by face->boundary must point to the same face (2)";
+        case 3:  return "Every edge must have an origin vertex (3)";
+        case 4:  return "Every vertex must have a incident pointer (4)";
+        case 5:  return "Every edge must have an twin edge (5)";
+        case 6:  return "Every edge must have a next half-edge pointer (6)";
+        case 7:  return "The pointer edge->next->origin must be equal to edge->twin->origin (7)";
+        case 8:  return "Every edge must have a prev pointer (8)";
+        case 9:  return "The pointer edge->prev->twin->origin must be equal to edge->origin (9)";
+        case 10: return "There is an error iterating through the edges of a vertex - possible infinite loop - (10)";
+        case 11: return "The edge cannot be reachable iterating thought its origin (11)";
+        case 12: return "The sequence of half edges on the border does not points to a null face (12)";
+        case 13: return "The half-edges of a face must form a closed loop (13)";
+        case 14: return "Every ID must refer to an existing element (14)";
+        case 15: return "The twin of the twin of an edge must be the edge itself (15)";
+        case 16: return "The pointer edge->next->prev must be equal to edge (16)";
+        case 17: return "The incident edge of a vertex must start at the vertex (17)";
+        default: return "Unknown invariant";
+        }
+    };
+
+    /**
+    	The description followed by the element, like
+        "Every face must have a boundary (1), at the face 10".
+    */
+    std::string getMessage() const
+    {
+        static const char* elementNames[] = { "vertex", "half-edge", "face" };
+        std::ostringstream message;
+        message << this->getDescription() << ", at the " << elementNames[this->elementType] << " " << this->elementId;
+        return message.str();
+    };
+
+    ElementType elementType;
+    unsigned int elementId;
+    unsigned int invariant;
+};
+
+/**
+	All violations found by the MeshValidator, sorted by the element type
+    (vertices, then half-edges, then faces) and by the element ID. The same
+    mesh always gives the same report, with any number of threads.
+*/
+class ValidationReport
+{
+public:
+
+    inline bool isValid() const
+    {
+        return this->violations.empty();
+    };
+
+    inline size_t getNumViolations() const
+    {
+        return this->violations.size();
+    };
+
+    inline const MeshViolation& getViolation(size_t index) const
+    {
+        return this->violations[index];
+    };
+
+    inline const std::vector<MeshViolation>& getViolations() const
+    {
+        return this->violations;
+    };
+
+    inline void clear()
+    {
+        this->violations.clear();
+    };
+
+    inline void addViolation(const MeshViolation& violation)
+    {
+        this->violations.push_back( violation );
+    };
+
+    /**
+    	Throws a cpp::Exception with the message of the first violation, if
+        there is any.
+    */
+    void throwIfInvalid() const
+    {
+        if( !this->violations.empty() )
+        {
+            throw cpp::Exception( this->violations[0].getMessage() );
+        }
+    };
+
+private:
+
+    std::vector<MeshViolation> violations;
+};
+
+/**
+	Checks all the invariants of a mesh (the ones listed in Mesh::checkFace,
+    and some more) using several threads, and reports all the elements that
+    break them instead of stopping at the first one.
+
+    Each invariant is checked once for each element: the pointers of each
+    half-edge, the loop of each face, and the ring of each vertex, that is
+    walked only once to find all its outgoing half-edges. The elements are
+    split in blocks, and each block is checked by any thread.
+
+    It works with any class that has the ID methods of the Mesh (like
+    MeshView). The mesh must not change while it is validated.
+*/
+template<class MeshT>
+class MeshValidator
+{
+public:
+
+    /**
+    	Fills the report with the violations of the mesh, using up to
+        threadCount threads (0 for one per core).
+    */
+    static void validate(const MeshT& mesh, ValidationReport& report, unsigned int threadCount = 0);
+
+    /**
+    	Fills the report with the violations of the given elements only, in a
+        single thread. Each list must be sorted, without repeated IDs. The
+        rings of the origins of the half-edges are always walked (and the
+        origins are checked as well), to find if each half-edge is reachable
+        from its origin.
+
+        Its cost depends only on the number of elements in the lists (and on
+        the size of their rings). Used by Mesh::validateDirty.
+    */
+    static void validateRegion(const MeshT& mesh, const std::vector<unsigned int>& vertexIds,
+        const std::vector<unsigned int>& halfEdgeIds, const std::vector<unsigned int>& faceIds, ValidationReport& report);
+
+protected:
+private:
+
+    /**
+    	The number of elements checked at once by a thread.
+    */
+    enum { BLOCK_SIZE = 1<<14 };
+
+    typedef std::vector< std::vector<MeshViolation> > BlockViolations;
+
+    /**
+    	The half-edges reached by walking the rings of the vertices, as one
+        flag for each half-edge of the mesh. Each thread only marks the
+        half-edges that leave its vertices, so no flag is written twice.
+    */
+    class ReachedFlags
+    {
+    public:
+
+        explicit ReachedFlags(size_t numHalfEdges):
+            flags(numHalfEdges, 0)
+        {
+        };
+
+        inline void mark(unsigned int halfEdgeId)
+        {
+            this->flags[halfEdgeId] = 1;
+        };
+
+        inline bool isReached(unsigned int halfEdgeId) const
+        {
+            return this->flags[halfEdgeId]!=0;
+        };
+
+    private:
+
+        std::vector<char> flags;
+    };
+
+    /**
+    	The same as ReachedFlags, for a few vertices: a list of half-edges,
+        that must be sorted before it is searched.
+    */
+    class ReachedList
+    {
+    public:
+
+        inline void mark(unsigned int halfEdgeId)
+        {
+            this->halfEdgeIds.push_back( halfEdgeId );
+        };
+
+        inline void sort()
+        {
+            std::sort( this->halfEdgeIds.begin(), this->halfEdgeIds.end() );
+        };
+
+        inline bool isReached(unsigned int halfEdgeId) const
+        {
+            return std::binary_search( this->halfEdgeIds.begin(), this->halfEdgeIds.end(), halfEdgeId );
+        };
+
+    private:
+
+        std::vector<unsigned int> halfEdgeIds;
+    };
+
+    /**
+    	Walks the ring of each vertex, marking the half-edges that leave it.
+    */
+    class VertexTask: public ParallelTask
+    {
+    public:
+
+        VertexTask(const MeshT& mesh, ReachedFlags& reached, BlockViolations& violations):
+            mesh(mesh),
+            reached(reached),
+            violations(violations)
+        {
+        };
+
+        virtual void run(unsigned int index);
+
+    private:
+
+        VertexTask& operator=(const VertexTask&);
+
+        const MeshT& mesh;
+        ReachedFlags& reached;
+        BlockViolations& violations;
+    };
+
+    /**
+    	Checks the pointers of each half-edge (the first blocks) and the loop
+        of each face (the last blocks).
+    */
+    class ElementTask: public ParallelTask
+    {
+    public:
+
+        ElementTask(const MeshT& mesh, const ReachedFlags& reached, unsigned int numHalfEdgeBlocks, BlockViolations& violations):
+            mesh(mesh),
+            reached(reached),
+            numHalfEdgeBlocks(numHalfEdgeBlocks),
+            violations(violations)
+        {
+        };
+
+        virtual void run(unsigned int index);
+
+    private:
+
+        ElementTask& operator=(const ElementTask&);
+
+        const MeshT& mesh;
+        const ReachedFlags& reached;
+        unsigned int numHalfEdgeBlocks;
+        BlockViolations& violations;
+    };
+
+    /**
+    	Walks the ring of the vertex, marking the half-edges that leave it.
+        A broken pointer stops the walk, and is reported by the half-edge
+        that has it.
+    */
+    template<class ReachedT>
+    static void checkVertex(const MeshT& mesh, unsigned int vertexId, std::vector<MeshViolation>& found, ReachedT& reached);
+
+    template<class ReachedT>
+    static void checkHalfEdge(const MeshT& mesh, unsigned int halfEdgeId, std::vector<MeshViolation>& found, const ReachedT& reached);
+
+    static void checkFace(const MeshT& mesh, unsigned int faceId, std::vector<MeshViolation>& found);
+
+    static inline unsigned int countBlocks(unsigned int numElements)
+    {
+        return (numElements+BLOCK_SIZE-1)/BLOCK_SIZE;
+    };
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                            IMPLEMENTATION                            //
+//////////////////////////////////////////////////////////////////////////
+
+
+template<class MeshT>
+void MeshValidator<MeshT>::validate(const MeshT& mesh, ValidationReport& report, unsigned int threadCount)
+{
+    report.clear();
+
+    const unsigned int numVertexBlocks = countBlocks( mesh.getNumVertices() );
+    const unsigned int numHalfEdgeBlocks = countBlocks( mesh.getNumHalfEdges() );
+    const unsigned int numFaceBlocks = countBlocks( mesh.getNumFaces() );
+
+    // the rings are walked first, as the half-edges check if they were
+    // reached from their origin
+    ReachedFlags reached( mesh.getNumHalfEdges() );
+    BlockViolations vertexViolations( numVertexBlocks );
+    VertexTask vertexTask( mesh, reached, vertexViolations );
+    runParallel( vertexTask, numVertexBlocks, threadCount );
+
+    BlockViolations elementViolations( numHalfEdgeBlocks+numFaceBlocks );
+    ElementTask elementTask( mesh, reached, numHalfEdgeBlocks, elementViolations );
+    runParallel( elementTask, numHalfEdgeBlocks+numFaceBlocks, threadCount );
+
+    for( size_t block=0; block<vertexViolations.size(); ++block )
+    {
+        for( size_t i=0; i<vertexViolations[block].size(); ++i )
+        {
+            report.addViolation( vertexViolations[block][i] );
+        }
+    }
+    for( size_t block=0; block<elementViolations.size(); ++block )
+    {
+        for( size_t i=0; i<elementViolations[block].size(); ++i )
+        {
+            report.addViolation( elementViolations[block][i] );
+        }
+    }
+}
+
+template<class MeshT>
+void MeshValidator<MeshT>::validateRegion(const MeshT& mesh, const std::vector<unsigned int>& vertexIds,
+    const std::vector<unsigned int>& halfEdgeIds, const std::vector<unsigned int>& faceIds, ValidationReport& report)
+{
+    report.clear();
+
+    const unsigned int numVertices = mesh.getNumVertices();
+    const unsigned int numHalfEdges = mesh.getNumHalfEdges();
+    const unsigned int numFaces = mesh.getNumFaces();
+
+    std::vector<unsigned int> walkedVertexIds( vertexIds );
+    for( size_t i=0; i<halfEdgeIds.size(); ++i )
+    {
+        if( halfEdgeIds[i]<numHalfEdges )
+        {
+            const unsigned int origin = mesh.getHalfEdgeOrigin( halfEdgeIds[i] );
+            if( origin<numVertices )
+            {
+                walkedVertexIds.push_back( origin );
+            }
+        }
+    }
+    std::sort( walkedVertexIds.begin(), walkedVertexIds.end() );
+    walkedVertexIds.erase( std::unique( walkedVertexIds.begin(), walkedVertexIds.end() ), walkedVertexIds.end() );
+
+    std::vector<MeshViolation> found;
+    ReachedList reached;
+    for( size_t i=0; i<walkedVertexIds.size() && walkedVertexIds[i]<numVertices; ++i )
+    {
+        checkVertex( mesh, walkedVertexIds[i], found, reached );
+    }
+    reached.sort();
+    for( size_t i=0; i<halfEdgeIds.size() && halfEdgeIds[i]<numHalfEdges; ++i )
+    {
+        checkHalfEdge( mesh, halfEdgeIds[i], found, reached );
+    }
+    for( size_t i=0; i<faceIds.size() && faceIds[i]<numFaces; ++i )
+    {
+        checkFace( mesh, faceIds[i], found );
+    }
+
+    for( size_t i=0; i<found.size(); ++i )
+    {
+        report.addViolation( found[i] );
+    }
+}
+
+template<class MeshT>
+void MeshValidator<MeshT>::VertexTask::run(unsigned int index)
+{
+    const unsigned int first = index*BLOCK_SIZE;
+    const unsigned int last = std::min( first+BLOCK_SIZE, this->mesh.getNumVertices() );
+    std::vector<MeshViolation>& found = this->violations[index];
+
+    for( unsigned int vertexId=first; vertexId<last; ++vertexId )
+    {
+        checkVertex( this->mesh, vertexId, found, this->reached );
+    }
+}
+
+template<class MeshT>
+void MeshValidator<MeshT>::ElementTask::run(unsigned int index)
+{
+    std::vector<MeshViolation>& found = this->violations[index];
+    if( index<this->numHalfEdgeBlocks )
+    {
+        const unsigned int first = index*BLOCK_SIZE;
+        const unsigned int last = std::min( first+BLOCK_SIZE, this->mesh.getNumHalfEdges() );
+        for( unsigned int halfEdgeId=first; halfEdgeId<last; ++halfEdgeId )
+        {
+            checkHalfEdge( this->mesh, halfEdgeId, found, this->reached );
+        }
+    }
+    else
+    {
+        const unsigned int first = (index-this->numHalfEdgeBlocks)*BLOCK_SIZE;
+        const unsigned int last = std::min( first+BLOCK_SIZE, this->mesh.getNumFaces() );
+        for( unsigned int faceId=first; faceId<last; ++faceId )
+        {
+            checkFace( this->mesh, faceId, found );
+        }
+    }
+}
+
+template<class MeshT>
+template<class ReachedT>
+void MeshValidator<MeshT>::checkVertex(const MeshT& mesh, unsigned int vertexId, std::vector<MeshViolation>& found, ReachedT& reached)
+{
+    const unsigned int numHalfEdges = mesh.getNumHalfEdges();
+    const unsigned int start = mesh.getVertexIncidentEdge( vertexId );
+    if( start==MESH_NULL_ID )
+    {
+        return;
+    }
+    if( start>=numHalfEdges )
+    {
+        found.push_back( MeshViolation( MeshViolation::VERTEX, vertexId, 14 ) );
+        return;
+    }
+    if( mesh.getHalfEdgeOrigin(start)!=vertexId )
+    {
+        found.push_back( MeshViolation( MeshViolation::VERTEX, vertexId, 17 ) );
+        return;
+    }
+
+    unsigned int edge = start;
+    unsigned int count = 0;
+    do
+    {
+        if( mesh.getHalfEdgeOrigin(edge)!=vertexId )
+        {
+            break;
+        }
+        reached.mark( edge );
+
+        const unsigned int twin = mesh.getHalfEdgeTwin(edge);
+        if( twin>=numHalfEdges )
+        {
+            break;
+        }
+        edge = mesh.getHalfEdgeNext(twin);
+        if( edge>=numHalfEdges )
+        {
+            break;
+        }
+
+        if( ++count>numHalfEdges )
+        {
+            found.push_back( MeshViolation( MeshViolation::VERTEX, vertexId, 10 ) );
+            break;
+        }
+    }
+    while( edge!=start );
+}
+
+template<class MeshT>
+template<class ReachedT>
+void MeshValidator<MeshT>::checkHalfEdge(const MeshT& mesh, unsigned int halfEdgeId, std::vector<MeshViolation>& found, const ReachedT& reached)
+{
+    const unsigned int numVertices = mesh.getNumVertices();
+    const unsigned int numHalfEdges = mesh.getNumHalfEdges();
+
+    const unsigned int origin = mesh.getHalfEdgeOrigin(halfEdgeId);
+    const unsigned int twin = mesh.getHalfEdgeTwin(halfEdgeId);
+    const unsigned int next = mesh.getHalfEdgeNext(halfEdgeId);
+    const unsigned int prev = mesh.getHalfEdgePrev(halfEdgeId);
+    const unsigned int face = mesh.getHalfEdgeFace(halfEdgeId);
+
+    if( (origin!=MESH_NULL_ID && origin>=numVertices)
+        || (twin!=MESH_NULL_ID && twin>=numHalfEdges)
+        || (next!=MESH_NULL_ID && next>=numHalfEdges)
+        || (prev!=MESH_NULL_ID && prev>=numHalfEdges)
+        || (face!=MESH_NULL_ID && face>=mesh.getNumFaces()) )
+    {
+        found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 14 ) );
+        return;
+    }
+
+    if( origin==MESH_NULL_ID )
+    {
+        found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 3 ) );
+    }
+    else if( mesh.getVertexIncidentEdge(origin)==MESH_NULL_ID )
+    {
+        found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 4 ) );
+    }
+    else if( !reached.isReached(halfEdgeId) )
+    {
+        found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 11 ) );
+    }
+
+    if( twin==MESH_NULL_ID )
+    {
+        found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 5 ) );
+    }
+    else if( mesh.getHalfEdgeTwin(twin)!=halfEdgeId )
+    {
+        found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 15 ) );
+    }
+
+    if( next==MESH_NULL_ID )
+    {
+        found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 6 ) );
+    }
+    else
+    {
+        if( twin!=MESH_NULL_ID && mesh.getHalfEdgeOrigin(next)!=mesh.getHalfEdgeOrigin(twin) )
+        {
+            found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 7 ) );
+        }
+        if( mesh.getHalfEdgePrev(next)!=halfEdgeId )
+        {
+            found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 16 ) );
+        }
+        if( face==MESH_NULL_ID && mesh.getHalfEdgeFace(next)!=MESH_NULL_ID )
+        {
+            found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 12 ) );
+        }
+    }
+
+    if( prev==MESH_NULL_ID )
+    {
+        found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 8 ) );
+    }
+    else
+    {
+        const unsigned int prevTwin = mesh.getHalfEdgeTwin(prev);
+        if( prevTwin!=MESH_NULL_ID && prevTwin<numHalfEdges && mesh.getHalfEdgeOrigin(prevTwin)!=origin )
+        {
+            found.push_back( MeshViolation( MeshViolation::HALF_EDGE, halfEdgeId, 9 ) );
+        }
+    }
+}
+
+template<class MeshT>
+void MeshValidator<MeshT>::checkFace(const MeshT& mesh, unsigned int faceId, std::vector<MeshViolation>& found)
+{
+    const unsigned int numHalfEdges = mesh.getNumHalfEdges();
+
+    const unsigned int boundary = mesh.getFaceBoundary(faceId);
+    if( boundary==MESH_NULL_ID )
+    {
+        found.push_back( MeshViolation( MeshViolation::FACE, faceId, 1 ) );
+        return;
+    }
+    if( boundary>=numHalfEdges )
+    {
+        found.push_back( MeshViolation( MeshViolation::FACE, faceId, 14 ) );
+        return;
+    }
+
+    // the pointers of each half-edge are checked by checkHalfEdge, so the
+    // walk only stops at a broken next
+    unsigned int edge = boundary;
+    unsigned int count = 0;
+    bool otherFace = false;
+    do
+    {
+        if( mesh.getHalfEdgeFace(edge)!=faceId )
+        {
+            otherFace = true;
+        }
+        edge = mesh.getHalfEdgeNext(edge);
+        if( edge>=numHalfEdges || ++count>numHalfEdges )
+        {
+            found.push_back( MeshViolation( MeshViolation::FACE, faceId, 13 ) );
+            break;
+        }
+    }
+    while( edge!=boundary );
+
+    if( otherFace )
+    {
+        found.push_back( MeshViolation( MeshViolation::FACE, faceId, 2 ) );
+    }
+}
+
+#endif//DCEL_MeshValidator_h
@@ -0,0 +1,297 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_MeshView_h
+#define DCEL_MeshView_h
+
+#include <string>
+
+#include "MeshStorage.h"
+#include "EdgeIterator.h"
+#include "Circulators.h"
+#include "DCELBinaryFormat.h"
+#include "MappedFile.h"
+#include "Exception.h"
+
+/**
+	A read-only mesh over a binary DCEL file (written by
+    DCELStream::writeBinary), that is mapped in memory instead of loaded.
+
+    Opening a view doesn't read nor copy the arrays of the file: they are
+    loaded by the operating system as they are accessed, and their pages are
+    shared by all processes that map the same file.
+
+    It has the same navigation methods as a Mesh that uses IDs (like
+    getHalfEdgeNext, getVertexIncidentEdge, findHalfEdge or getFaceData), so
+    the circulators and the code written for the ID methods work with both:
+
+        typedef MeshView<VertexData, HalfEdgeData, FaceData> MyView;
+        MyView view( "mesh.dcelb" );
+        CirculatorRange<MyView, AroundFaceStep, OriginValue> vertices = faceVertices( view, faceId );
+        for( CirculatorRange<MyView, AroundFaceStep, OriginValue>::iterator it=vertices.begin(); it!=vertices.end(); ++it ) ...
+
+    There are no Vertex, HalfEdge or Face objects in the file, so the methods
+    that return pointers to them are not available.
+
+    The user data is read as the raw bytes written by writeBinary, so the
+    data types must be the ones used to write the file. The data of the
+    elements without a user data block in the file is a default-constructed
+    value. The IDs in the file are not checked when it is opened.
+*/
+template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
+class MeshView
+{
+public:
+
+    typedef VertexDataT VertexData;
+    typedef HalfEdgeDataT HalfEdgeData;
+    typedef FaceDataT FaceData;
+    typedef EdgeIdIteratorT< MeshView<VertexDataT, HalfEdgeDataT, FaceDataT> > EdgeIdIterator;
+
+    MeshView();
+
+    /**
+    	Opens the given file. See open().
+    */
+    explicit MeshView(const std::string& filename);
+
+    /**
+    	Maps the given binary DCEL file, closing the previous one.
+
+        Throws a cpp::Exception if the file is not a binary DCEL file, if it
+        is truncated, or if its user data has another size than the data types
+        of this view.
+    */
+    void open(const std::string& filename);
+
+    void close();
+
+    inline bool isOpen() const
+    {
+        return this->file.isOpen();
+    };
+
+    inline unsigned int getNumVertices() const
+    {
+        return this->header.numVertices;
+    };
+
+    inline unsigned int getNumHalfEdges() const
+    {
+        return this->header.numHalfEdges;
+    };
+
+    inline unsigned int getNumFaces() const
+    {
+        return this->header.numFaces;
+    };
+
+    inline unsigned int getVertexIncidentEdge(unsigned int vertexId) const
+    {
+        return this->incidentEdgeIds[vertexId];
+    };
+
+    inline unsigned int getFaceBoundary(unsigned int faceId) const
+    {
+        return this->boundaryIds[faceId];
+    };
+
+    inline unsigned int getHalfEdgeTwin(unsigned int halfEdgeId) const
+    {
+        return this->twinIds[halfEdgeId];
+    };
+
+    inline unsigned int getHalfEdgeNext(unsigned int halfEdgeId) const
+    {
+        return this->nextIds[halfEdgeId];
+    };
+
+    inline unsigned int getHalfEdgePrev(unsigned int halfEdgeId) const
+    {
+        return this->prevIds[halfEdgeId];
+    };
+
+    inline unsigned int getHalfEdgeOrigin(unsigned int halfEdgeId) const
+    {
+        return this->originIds[halfEdgeId];
+    };
+
+    inline unsigned int getHalfEdgeFace(unsigned int halfEdgeId) const
+    {
+        return this->faceIds[halfEdgeId];
+    };
+
+    inline const VertexDataT& getVertexData(unsigned int vertexId) const
+    {
+        return this->vertexData!=NULL? this->vertexData[vertexId] : this->defaultVertexData;
+    };
+
+    inline const HalfEdgeDataT& getHalfEdgeData(unsigned int halfEdgeId) const
+    {
+        return this->halfEdgeData!=NULL? this->halfEdgeData[halfEdgeId] : this->defaultHalfEdgeData;
+    };
+
+    inline const FaceDataT& getFaceData(unsigned int faceId) const
+    {
+        return this->faceData!=NULL? this->faceData[faceId] : this->defaultFaceData;
+    };
+
+    /**
+    	Returns the ID of the half-edge that goes from the vertex originId to
+        the vertex targetId, or MESH_NULL_ID if there is no such half-edge.
+        It rotates around the origin vertex, as the Mesh does when its
+        half-edge index is disabled.
+    */
+    unsigned int findHalfEdge(unsigned int originId, unsigned int targetId) const;
+
+protected:
+private:
+
+    // a view owns its mapping, so it can't be copied
+    MeshView(const MeshView&);
+    MeshView& operator=(const MeshView&);
+
+    /**
+    	Sets all arrays to NULL and all counts to 0.
+    */
+    void reset();
+
+    MappedFile file;
+    DCELBinaryHeader header;
+
+    const uint32_t* incidentEdgeIds;
+    const uint32_t* twinIds;
+    const uint32_t* nextIds;
+    const uint32_t* prevIds;
+    const uint32_t* originIds;
+    const uint32_t* faceIds;
+    const uint32_t* boundaryIds;
+
+    const VertexDataT* vertexData;
+    const HalfEdgeDataT* halfEdgeData;
+    const FaceDataT* faceData;
+
+    VertexDataT defaultVertexData;
+    HalfEdgeDataT defaultHalfEdgeData;
+    FaceDataT defaultFaceData;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                            IMPLEMENTATION                            //
+//////////////////////////////////////////////////////////////////////////
+
+
+template<class Vdt, class Hdt, class Fdt>
+MeshView<Vdt,Hdt,Fdt>::MeshView()
+{
+    this->reset();
+};
+
+template<class Vdt, class Hdt, class Fdt>
+MeshView<Vdt,Hdt,Fdt>::MeshView(const std::string& filename)
+{
+    this->reset();
+    this->open( filename );
+};
+
+template<class Vdt, class Hdt, class Fdt>
+void MeshView<Vdt,Hdt,Fdt>::open(const std::string& filename)
+{
+    this->close();
+    this->file.open( filename, MappedFile::RANDOM_ACCESS );
+
+    try
+    {
+        if( this->file.getSize()<sizeof(DCELBinaryHeader) )
+        {
+            throw cpp::Exception("This is not a binary DCEL file");
+        }
+        const char* data = this->file.getData();
+        DCELBinaryHeader fileHeader;
+        std::memcpy( &fileHeader, data, sizeof(fileHeader) );
+        fileHeader.check();
+        if( this->file.getSize()<fileHeader.getFileSize() )
+        {
+            throw cpp::Exception("The binary DCEL file '"+filename+"' is truncated");
+        }
+        if( (fileHeader.vertexDataSize!=0 && fileHeader.vertexDataSize!=sizeof(Vdt))
+            || (fileHeader.halfEdgeDataSize!=0 && fileHeader.halfEdgeDataSize!=sizeof(Hdt))
+            || (fileHeader.faceDataSize!=0 && fileHeader.faceDataSize!=sizeof(Fdt)) )
+        {
+            throw cpp::Exception("The user data in the binary DCEL file has another size than the data of the view");
+        }
+
+        this->header = fileHeader;
+        this->incidentEdgeIds = (const uint32_t*)( data + fileHeader.getVertexIncidentEdgesOffset() );
+        this->twinIds = (const uint32_t*)( data + fileHeader.getHalfEdgeIdsOffset(0) );
+        this->nextIds = (const uint32_t*)( data + fileHeader.getHalfEdgeIdsOffset(1) );
+        this->prevIds = (const uint32_t*)( data + fileHeader.getHalfEdgeIdsOffset(2) );
+        this->originIds = (const uint32_t*)( data + fileHeader.getHalfEdgeIdsOffset(3) );
+        this->faceIds = (const uint32_t*)( data + fileHeader.getHalfEdgeIdsOffset(4) );
+        this->boundaryIds = (const uint32_t*)( data + fileHeader.getFaceBoundariesOffset() );
+        if( fileHeader.vertexDataSize!=0 )
+        {
+            this->vertexData = (const Vdt*)( data + fileHeader.getVertexDataOffset() );
+        }
+        if( fileHeader.halfEdgeDataSize!=0 )
+        {
+            this->halfEdgeData = (const Hdt*)( data + fileHeader.getHalfEdgeDataOffset() );
+        }
+        if( fileHeader.faceDataSize!=0 )
+        {
+            this->faceData = (const Fdt*)( data + fileHeader.getFaceDataOffset() );
+        }
+    }
+    catch( ... )
+    {
+        this->close();
+        throw;
+    }
+};
+
+template<class Vdt, class Hdt, class Fdt>
+void MeshView<Vdt,Hdt,Fdt>::close()
+{
+    this->file.close();
+    this->reset();
+};
+
+template<class Vdt, class Hdt, class Fdt>
+void MeshView<Vdt,Hdt,Fdt>::reset()
+{
+    this->header = DCELBinaryHeader();
+    this->incidentEdgeIds = NULL;
+    this->twinIds = NULL;
+    this->nextIds = NULL;
+    this->prevIds = NULL;
+    this->originIds = NULL;
+    this->faceIds = NULL;
+    this->boundaryIds = NULL;
+    this->vertexData = NULL;
+    this->halfEdgeData = NULL;
+    this->faceData = NULL;
+};
+
+template<class Vdt, class Hdt, class Fdt>
+unsigned int MeshView<Vdt,Hdt,Fdt>::findHalfEdge(unsigned int originId, unsigned int targetId) const
+{
+    typedef CirculatorRange<MeshView, AroundVertexStep, TargetValue> NeighbourRange;
+    const NeighbourRange neighbours = vertexNeighbours( *this, originId );
+    for( typename NeighbourRange::iterator it=neighbours.begin(); it!=neighbours.end(); ++it )
+    {
+        if( *it==targetId )
+        {
+            return it.getHalfEdge();
+        }
+    }
+    return MESH_NULL_ID;
+};
+
+#endif//DCEL_MeshView_h
@@ -0,0 +1,446 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Parallel.h"
+#include "Exception.h"
+#include <vector>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    /**
+    	The state shared by all threads of a runParallel call.
+    */
+    struct SharedState
+    {
+        ParallelTask* task;
+        unsigned int count;
+#ifdef _WIN32
+        volatile LONG next;
+        volatile LONG failed;
+#else
+        volatile long next;
+        volatile long failed;
+#endif
+    };
+
+    /**
+    	The state of one thread. The error is kept per thread, so no lock
+        is needed to report it.
+    */
+    struct WorkerState
+    {
+        SharedState* shared;
+        bool failed;
+        std::string error;
+    };
+
+    /**
+    	Returns the next index to run, and increments it.
+    */
+    inline unsigned int takeNextIndex(SharedState& shared)
+    {
+#ifdef _WIN32
+        return (unsigned int)( InterlockedIncrement( &shared.next ) - 1 );
+#else
+        return (unsigned int)__sync_fetch_and_add( &shared.next, 1 );
+#endif
+    }
+
+    inline void setFailed(SharedState& shared)
+    {
+#ifdef _WIN32
+        InterlockedExchange( &shared.failed, 1 );
+#else
+        __sync_lock_test_and_set( &shared.failed, 1 );
+#endif
+    }
+
+    void work(WorkerState& worker)
+    {
+        SharedState& shared = *worker.shared;
+        try
+        {
+            for( unsigned int index=takeNextIndex(shared); index<shared.count && !shared.failed; index=takeNextIndex(shared) )
+            {
+                shared.task->run( index );
+            }
+        }
+        catch( const std::exception& e )
+        {
+            worker.failed = true;
+            worker.error = e.what();
+            setFailed( shared );
+        }
+        catch( ... )
+        {
+            worker.failed = true;
+            worker.error = "Unknown exception in a parallel task";
+            setFailed( shared );
+        }
+    }
+
+#ifdef _WIN32
+    DWORD WINAPI threadMain(LPVOID parameter)
+    {
+        work( *(WorkerState*)parameter );
+        return 0;
+    }
+#else
+    void* threadMain(void* parameter)
+    {
+        work( *(WorkerState*)parameter );
+        return NULL;
+    }
+#endif
+
+    /**
+    	A counting semaphore, used by runPipeline to pass the slots between
+        the producer and the consumer.
+    */
+    class Semaphore
+    {
+    public:
+        explicit Semaphore(unsigned int count)
+        {
+#ifdef _WIN32
+            this->handle = CreateSemaphore( NULL, (LONG)count, 0x7fffffff, NULL );
+#else
+            pthread_mutex_init( &this->mutex, NULL );
+            pthread_cond_init( &this->condition, NULL );
+            this->count = count;
+#endif
+        };
+
+        ~Semaphore()
+        {
+#ifdef _WIN32
+            CloseHandle( this->handle );
+#else
+            pthread_cond_destroy( &this->condition );
+            pthread_mutex_destroy( &this->mutex );
+#endif
+        };
+
+        void wait()
+        {
+#ifdef _WIN32
+            WaitForSingleObject( this->handle, INFINITE );
+#else
+            pthread_mutex_lock( &this->mutex );
+            while( this->count==0 )
+            {
+                pthread_cond_wait( &this->condition, &this->mutex );
+            }
+            --this->count;
+            pthread_mutex_unlock( &this->mutex );
+#endif
+        };
+
+        void post()
+        {
+#ifdef _WIN32
+            ReleaseSemaphore( this->handle, 1, NULL );
+#else
+            pthread_mutex_lock( &this->mutex );
+            ++this->count;
+            pthread_cond_signal( &this->condition );
+            pthread_mutex_unlock( &this->mutex );
+#endif
+        };
+
+    private:
+        Semaphore(const Semaphore&);
+        Semaphore& operator=(const Semaphore&);
+
+#ifdef _WIN32
+        HANDLE handle;
+#else
+        pthread_mutex_t mutex;
+        pthread_cond_t condition;
+        unsigned int count;
+#endif
+    };
+
+    /**
+    	A flag set by one thread and read by another one.
+    */
+#ifdef _WIN32
+    typedef volatile LONG Flag;
+#else
+    typedef volatile long Flag;
+#endif
+
+    inline void setFlag(Flag& flag)
+    {
+#ifdef _WIN32
+        InterlockedExchange( &flag, 1 );
+#else
+        __sync_lock_test_and_set( &flag, 1 );
+#endif
+    }
+
+    inline bool isFlagSet(Flag& flag)
+    {
+#ifdef _WIN32
+        return InterlockedCompareExchange( &flag, 0, 0 )!=0;
+#else
+        return __sync_fetch_and_add( &flag, 0 )!=0;
+#endif
+    }
+
+    /**
+    	The state shared by the two stages of a runPipeline. The free slots
+        and the batches ready to be consumed are counted by the semaphores,
+        and the producer also posts one last "ready" when it is done.
+    */
+    struct PipelineState
+    {
+        PipelineState(BatchConsumer& consumer, unsigned int slotCount):
+            consumer(consumer),
+            slotCount(slotCount),
+            freeSlots(slotCount),
+            readyBatches(0),
+            batchCount(0),
+            finished(0),
+            failed(0)
+        {
+        };
+
+        BatchConsumer& consumer;
+        unsigned int slotCount;
+        Semaphore freeSlots;
+        Semaphore readyBatches;
+
+        // written by the producer before it sets finished
+        unsigned int batchCount;
+        Flag finished;
+
+        // set by the stage that fails, before it wakes the other one
+        Flag failed;
+        std::string error;
+    };
+
+    void consumeBatches(PipelineState& state)
+    {
+        try
+        {
+            for( unsigned int batch=0; ; ++batch )
+            {
+                state.readyBatches.wait();
+                if( isFlagSet(state.failed) || (isFlagSet(state.finished) && batch==state.batchCount) )
+                {
+                    return;
+                }
+                state.consumer.consume( batch%state.slotCount );
+                state.freeSlots.post();
+            }
+        }
+        catch( const std::exception& e )
+        {
+            state.error = e.what();
+        }
+        catch( ... )
+        {
+            state.error = "Unknown exception in a pipeline stage";
+        }
+        setFlag( state.failed );
+        state.freeSlots.post();
+    }
+
+#ifdef _WIN32
+    DWORD WINAPI consumerMain(LPVOID parameter)
+    {
+        consumeBatches( *(PipelineState*)parameter );
+        return 0;
+    }
+#else
+    void* consumerMain(void* parameter)
+    {
+        consumeBatches( *(PipelineState*)parameter );
+        return NULL;
+    }
+#endif
+}
+
+unsigned int getNumCores()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    const long cores = (long)info.dwNumberOfProcessors;
+#else
+    const long cores = sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+    return cores>0? (unsigned int)cores : 1;
+}
+
+void runParallel(ParallelTask& task, unsigned int count, unsigned int threadCount)
+{
+    if( threadCount==0 )
+    {
+        threadCount = getNumCores();
+    }
+    if( threadCount>count )
+    {
+        threadCount = count;
+    }
+
+    SharedState shared;
+    shared.task = &task;
+    shared.count = count;
+    shared.next = 0;
+    shared.failed = 0;
+
+    std::vector<WorkerState> workers( threadCount>0? threadCount : 1 );
+    for( unsigned int i=0; i<workers.size(); ++i )
+    {
+        workers[i].shared = &shared;
+        workers[i].failed = false;
+    }
+
+    // the calling thread is the worker 0. If a thread can't be created,
+    // its share of the work is done by the others
+#ifdef _WIN32
+    std::vector<HANDLE> threads;
+    for( unsigned int i=1; i<workers.size(); ++i )
+    {
+        HANDLE thread = CreateThread( NULL, 0, threadMain, &workers[i], 0, NULL );
+        if( thread!=NULL )
+        {
+            threads.push_back( thread );
+        }
+    }
+    work( workers[0] );
+    for( unsigned int i=0; i<threads.size(); ++i )
+    {
+        WaitForSingleObject( threads[i], INFINITE );
+        CloseHandle( threads[i] );
+    }
+#else
+    std::vector<pthread_t> threads;
+    for( unsigned int i=1; i<workers.size(); ++i )
+    {
+        pthread_t thread;
+        if( pthread_create( &thread, NULL, threadMain, &workers[i] )==0 )
+        {
+            threads.push_back( thread );
+        }
+    }
+    work( workers[0] );
+    for( unsigned int i=0; i<threads.size(); ++i )
+    {
+        pthread_join( threads[i], NULL );
+    }
+#endif
+
+    for( unsigned int i=0; i<workers.size(); ++i )
+    {
+        if( workers[i].failed )
+        {
+            throw cpp::Exception( workers[i].error );
+        }
+    }
+}
+
+void runPipeline(BatchProducer& producer, BatchConsumer& consumer, unsigned int slotCount, bool inParallel)
+{
+    if( slotCount==0 )
+    {
+        slotCount = 1;
+    }
+
+    PipelineState state( consumer, slotCount );
+    bool threadCreated = false;
+#ifdef _WIN32
+    HANDLE thread = NULL;
+    if( inParallel )
+    {
+        thread = CreateThread( NULL, 0, consumerMain, &state, 0, NULL );
+        threadCreated = thread!=NULL;
+    }
+#else
+    pthread_t thread;
+    if( inParallel )
+    {
+        threadCreated = pthread_create( &thread, NULL, consumerMain, &state )==0;
+    }
+#endif
+
+    if( !threadCreated )
+    {
+        try
+        {
+            for( unsigned int batch=0; producer.produce( batch%slotCount ); ++batch )
+            {
+                consumer.consume( batch%slotCount );
+            }
+        }
+        catch( const std::exception& e )
+        {
+            throw cpp::Exception( e.what() );
+        }
+        return;
+    }
+
+    bool producerFailed = false;
+    std::string producerError;
+    try
+    {
+        for( unsigned int batch=0; ; ++batch )
+        {
+            state.freeSlots.wait();
+            if( isFlagSet(state.failed) || !producer.produce( batch%slotCount ) )
+            {
+                state.batchCount = batch;
+                break;
+            }
+            state.readyBatches.post();
+        }
+    }
+    catch( const std::exception& e )
+    {
+        producerFailed = true;
+        producerError = e.what();
+    }
+    catch( ... )
+    {
+        producerFailed = true;
+        producerError = "Unknown exception in a pipeline stage";
+    }
+    if( producerFailed )
+    {
+        setFlag( state.failed );
+    }
+    setFlag( state.finished );
+    state.readyBatches.post();
+
+#ifdef _WIN32
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+#else
+    pthread_join( thread, NULL );
+#endif
+
+    if( producerFailed )
+    {
+        throw cpp::Exception( producerError );
+    }
+    if( isFlagSet(state.failed) )
+    {
+        throw cpp::Exception( state.error );
+    }
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef Parallel_h
+#define Parallel_h
+
+/**
+	A job split into independent pieces, that can be run by several threads
+    with runParallel. Each index is run exactly once, in any order and in any
+    thread, so run() must only write to data owned by its index.
+*/
+class ParallelTask
+{
+public:
+
+    virtual ~ParallelTask()
+    {
+    };
+
+    virtual void run(unsigned int index) = 0;
+};
+
+/**
+	Returns the number of processors of the machine (at least 1).
+*/
+unsigned int getNumCores();
+
+/**
+	Calls task.run(i) for each i in [0, count), using up to threadCount
+    threads, including the calling thread. A threadCount of 0 uses one thread
+    per core. The function returns after all pieces are done.
+
+    If a piece throws an exception, the pieces not started yet are skipped
+    and a cpp::Exception with the same message is thrown by runParallel.
+*/
+void runParallel(ParallelTask& task, unsigned int count, unsigned int threadCount);
+
+/**
+	The first stage of a runPipeline: makes the batches, in order.
+*/
+class BatchProducer
+{
+public:
+
+    virtual ~BatchProducer()
+    {
+    };
+
+    /**
+    	Makes the next batch in the given slot (an index in [0, slotCount)),
+        and returns true. Returns false when there are no more batches.
+    */
+    virtual bool produce(unsigned int slot) = 0;
+};
+
+/**
+	The second stage of a runPipeline: receives the batches in the order they
+    were made.
+*/
+class BatchConsumer
+{
+public:
+
+    virtual ~BatchConsumer()
+    {
+    };
+
+    virtual void consume(unsigned int slot) = 0;
+};
+
+/**
+	Runs the producer in the calling thread and, if inParallel is true, the
+    consumer in another thread, so that the batch i+1 can be made while the
+    batch i is consumed. The slots are used in turn, and a slot is not given
+    to the producer again before the consumer is done with it, so at most
+    slotCount batches exist at a time.
+
+    Without inParallel (or if the thread can't be created), each batch is
+    consumed right after it is made. If a stage throws an exception, the
+    other one stops and a cpp::Exception with the same message is thrown.
+*/
+void runPipeline(BatchProducer& producer, BatchConsumer& consumer, unsigned int slotCount, bool inParallel);
+
+#endif//Parallel_h
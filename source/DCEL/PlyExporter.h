@@ -0,0 +1,534 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PlyExporter_h
+#define PlyExporter_h
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#include "IntTypes.h"
+#include "Mesh.h"
+#include "Circulators.h"
+#include "TextWriter.h"
+#include "DCELBinaryFormat.h"
+
+/**
+	The formats that the PlyExporter can write.
+*/
+enum PlyExportFormat
+{
+    PLY_EXPORT_BINARY_LITTLE_ENDIAN,
+    PLY_EXPORT_ASCII
+};
+
+/**
+	The name in a PLY header, and the text format, of the types that the
+    attributes written by the PlyExporter can have. There is no definition
+    for the other types, so they don't compile.
+*/
+template<class T>
+struct PlyPropertyType;
+
+template<>
+struct PlyPropertyType<signed char>
+{
+    static const char* getName() { return "char"; };
+    static void writeText(TextWriter& writer, signed char value) { writeSigned( writer, value ); };
+    static void writeSigned(TextWriter& writer, long long value)
+    {
+        if( value<0 )
+        {
+            writer.write( '-' );
+        }
+        writer.writeUnsigned( value<0? (unsigned long long)-value : (unsigned long long)value );
+    };
+};
+
+template<>
+struct PlyPropertyType<unsigned char>
+{
+    static const char* getName() { return "uchar"; };
+    static void writeText(TextWriter& writer, unsigned char value) { writer.writeUnsigned( value ); };
+};
+
+template<>
+struct PlyPropertyType<short>
+{
+    static const char* getName() { return "short"; };
+    static void writeText(TextWriter& writer, short value) { PlyPropertyType<signed char>::writeSigned( writer, value ); };
+};
+
+template<>
+struct PlyPropertyType<unsigned short>
+{
+    static const char* getName() { return "ushort"; };
+    static void writeText(TextWriter& writer, unsigned short value) { writer.writeUnsigned( value ); };
+};
+
+template<>
+struct PlyPropertyType<int>
+{
+    static const char* getName() { return "int"; };
+    static void writeText(TextWriter& writer, int value) { PlyPropertyType<signed char>::writeSigned( writer, value ); };
+};
+
+template<>
+struct PlyPropertyType<unsigned int>
+{
+    static const char* getName() { return "uint"; };
+    static void writeText(TextWriter& writer, unsigned int value) { writer.writeUnsigned( value ); };
+};
+
+template<>
+struct PlyPropertyType<float>
+{
+    static const char* getName() { return "float"; };
+    static void writeText(TextWriter& writer, float value) { writer.writeFloat( value ); };
+};
+
+template<>
+struct PlyPropertyType<double>
+{
+    static const char* getName() { return "double"; };
+    static void writeText(TextWriter& writer, double value)
+    {
+        writer.getStream().precision( 17 );
+        writer.getStream() << value;
+    };
+};
+
+/**
+	Used internally by the PlyExporter: writes the values of an attribute
+    channel of the mesh as a property of the vertices or of the faces.
+*/
+class PlyAttributeWriter
+{
+public:
+    virtual ~PlyAttributeWriter()
+    {
+    };
+
+    virtual const std::string& getName() const = 0;
+    virtual const char* getTypeName() const = 0;
+    virtual size_t getSize() const = 0;
+
+    /**
+    	Finds the channel in the set. Throws a cpp::Exception if there is no
+        channel with the name and the type of this property.
+    */
+    virtual void begin(const AttributeSet& attributes) = 0;
+
+    /**
+    	Copies the little-endian bytes of the value of the element.
+    */
+    virtual void writeBinary(unsigned int id, char* destination) const = 0;
+
+    virtual void writeText(unsigned int id, TextWriter& writer) const = 0;
+};
+
+template<class T>
+class TypedPlyAttributeWriter: public PlyAttributeWriter
+{
+public:
+    TypedPlyAttributeWriter(const std::string& name):
+        name(name),
+        channel(NULL)
+    {
+    };
+
+    virtual const std::string& getName() const
+    {
+        return this->name;
+    };
+
+    virtual const char* getTypeName() const
+    {
+        return PlyPropertyType<T>::getName();
+    };
+
+    virtual size_t getSize() const
+    {
+        return sizeof(T);
+    };
+
+    virtual void begin(const AttributeSet& attributes)
+    {
+        this->channel = &attributes.get<T>( this->name );
+    };
+
+    virtual void writeBinary(unsigned int id, char* destination) const
+    {
+        std::memcpy( destination, &(*this->channel)[id], sizeof(T) );
+        if( !isLittleEndianHost() )
+        {
+            std::reverse( destination, destination+sizeof(T) );
+        }
+    };
+
+    virtual void writeText(unsigned int id, TextWriter& writer) const
+    {
+        PlyPropertyType<T>::writeText( writer, (*this->channel)[id] );
+    };
+
+private:
+    std::string name;
+    const AttributeChannel<T>* channel;
+};
+
+/**
+    Class that exports a DCEL mesh to a PLY file.
+
+    The vertices are written with their position (VertexData::position, as
+    three floats), and the faces with the list of their vertices. Any face
+    with up to 255 vertices can be written. The attribute channels of the
+    mesh that are selected are written as properties with the same name,
+    after the position of the vertices and after the list of the faces:
+
+        PlyExporter<MyMesh> exporter;
+        exporter.addVertexAttribute<float>( "confidence" );
+        exporter.addFaceAttribute<unsigned char>( "label" );
+        exporter.writeFile( mesh, "mesh.ply" );
+
+    They can be read back with ImportOptions::importAttributes.
+
+    The binary format (the default) is written little-endian, in blocks of
+    many elements that are sent to the stream with a single write each. The
+    ASCII format is written through a large TextWriter buffer.
+*/
+template <class MeshT>
+class PlyExporter
+{
+public:
+
+    PlyExporter():
+        format(PLY_EXPORT_BINARY_LITTLE_ENDIAN)
+    {
+    };
+
+    ~PlyExporter()
+    {
+        this->clearAttributes();
+    };
+
+    inline void setFormat(PlyExportFormat format)
+    {
+        this->format = format;
+    };
+
+    inline PlyExportFormat getFormat() const
+    {
+        return this->format;
+    };
+
+    /**
+    	Selects a vertex attribute channel to be written. T must be the type
+        of the channel, and one of the types of PlyPropertyType.
+    */
+    template<class T>
+    void addVertexAttribute(const std::string& name)
+    {
+        this->vertexAttributes.push_back( new TypedPlyAttributeWriter<T>( name ) );
+    };
+
+    template<class T>
+    void addFaceAttribute(const std::string& name)
+    {
+        this->faceAttributes.push_back( new TypedPlyAttributeWriter<T>( name ) );
+    };
+
+    /**
+    	Unselects all the attributes.
+    */
+    void clearAttributes();
+
+    /**
+    	Writes the mesh to the stream, that must be opened in binary mode.
+
+        Throws a cpp::Exception if a selected attribute is not in the mesh, or
+        if a face has more than 255 vertices.
+    */
+    void write(const MeshT& mesh, std::ostream& stream);
+
+    /**
+    	Creates the file and writes the mesh to it.
+    */
+    void writeFile(const MeshT& mesh, const std::string& filename);
+
+private:
+
+    // the attribute writers can't be shared
+    PlyExporter(const PlyExporter&);
+    PlyExporter& operator=(const PlyExporter&);
+
+    typedef std::vector<PlyAttributeWriter*> AttributeWriterList;
+
+    /**
+    	The number of elements written by each write call.
+    */
+    enum { BLOCK_SIZE = 1<<16 };
+
+    void writeHeader(const MeshT& mesh, std::ostream& stream) const;
+    void writeBinary(const MeshT& mesh, std::ostream& stream) const;
+    void writeText(const MeshT& mesh, std::ostream& stream) const;
+
+    /**
+    	Returns the vertices of the face. Throws a cpp::Exception if there
+        are more than a PLY "uchar" can count.
+    */
+    static void getFaceVertices(const MeshT& mesh, unsigned int faceId, std::vector<uint32_t>& vertexIds);
+
+    static inline void writeFloat(float value, char* destination);
+    static inline void writeId(uint32_t value, char* destination);
+
+    PlyExportFormat format;
+    AttributeWriterList vertexAttributes;
+    AttributeWriterList faceAttributes;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                            IMPLEMENTATION                            //
+//////////////////////////////////////////////////////////////////////////
+
+
+template <class MeshT>
+void PlyExporter<MeshT>::clearAttributes()
+{
+    for( size_t i=0; i<this->vertexAttributes.size(); ++i )
+    {
+        delete this->vertexAttributes[i];
+    }
+    for( size_t i=0; i<this->faceAttributes.size(); ++i )
+    {
+        delete this->faceAttributes[i];
+    }
+    this->vertexAttributes.clear();
+    this->faceAttributes.clear();
+}
+
+template <class MeshT>
+void PlyExporter<MeshT>::write(const MeshT& mesh, std::ostream& stream)
+{
+    for( size_t i=0; i<this->vertexAttributes.size(); ++i )
+    {
+        this->vertexAttributes[i]->begin( mesh.getVertexAttributes() );
+    }
+    for( size_t i=0; i<this->faceAttributes.size(); ++i )
+    {
+        this->faceAttributes[i]->begin( mesh.getFaceAttributes() );
+    }
+
+    this->writeHeader( mesh, stream );
+    if( this->format==PLY_EXPORT_ASCII )
+    {
+        this->writeText( mesh, stream );
+    }
+    else
+    {
+        this->writeBinary( mesh, stream );
+    }
+    stream.flush();
+}
+
+template <class MeshT>
+void PlyExporter<MeshT>::writeFile(const MeshT& mesh, const std::string& filename)
+{
+    std::ofstream stream( filename.c_str(), std::ios::out | std::ios::binary );
+    if( !stream )
+    {
+        throw cpp::Exception(std::string("Cannot create the file '")+filename+"'");
+    }
+    this->write( mesh, stream );
+    if( !stream )
+    {
+        throw cpp::Exception(std::string("Error writing the file '")+filename+"'");
+    }
+}
+
+template <class MeshT>
+void PlyExporter<MeshT>::writeHeader(const MeshT& mesh, std::ostream& stream) const
+{
+    TextWriter writer( stream, 1<<12 );
+    writer.write( "ply\nformat " );
+    writer.write( this->format==PLY_EXPORT_ASCII? "ascii" : "binary_little_endian" );
+    writer.write( " 1.0\nelement vertex " );
+    writer.writeUnsigned( mesh.getNumVertices() );
+    writer.write( "\nproperty float x\nproperty float y\nproperty float z\n" );
+    for( size_t i=0; i<this->vertexAttributes.size(); ++i )
+    {
+        writer.write( "property " );
+        writer.write( this->vertexAttributes[i]->getTypeName() );
+        writer.write( ' ' );
+        writer.write( this->vertexAttributes[i]->getName().c_str() );
+        writer.newLine();
+    }
+    writer.write( "element face " );
+    writer.writeUnsigned( mesh.getNumFaces() );
+    writer.write( "\nproperty list uchar int vertex_indices\n" );
+    for( size_t i=0; i<this->faceAttributes.size(); ++i )
+    {
+        writer.write( "property " );
+        writer.write( this->faceAttributes[i]->getTypeName() );
+        writer.write( ' ' );
+        writer.write( this->faceAttributes[i]->getName().c_str() );
+        writer.newLine();
+    }
+    writer.write( "end_header\n" );
+    writer.flush();
+}
+
+template <class MeshT>
+void PlyExporter<MeshT>::writeBinary(const MeshT& mesh, std::ostream& stream) const
+{
+    const unsigned int numVertices = mesh.getNumVertices();
+    const unsigned int numFaces = mesh.getNumFaces();
+
+    // the vertices have a fixed size, so each block is filled in place
+    size_t vertexSize = 3*sizeof(float);
+    for( size_t i=0; i<this->vertexAttributes.size(); ++i )
+    {
+        vertexSize += this->vertexAttributes[i]->getSize();
+    }
+    std::vector<char> buffer( std::min<unsigned int>( numVertices, BLOCK_SIZE )*vertexSize );
+    for( unsigned int first=0; first<numVertices; first+=BLOCK_SIZE )
+    {
+        const unsigned int blockCount = std::min<unsigned int>( numVertices-first, BLOCK_SIZE );
+        char* record = buffer.empty()? NULL : &buffer[0];
+        for( unsigned int vertexId=first; vertexId<first+blockCount; ++vertexId )
+        {
+            writeFloat( (float)mesh.getVertexData(vertexId).position.x, record );
+            writeFloat( (float)mesh.getVertexData(vertexId).position.y, record+4 );
+            writeFloat( (float)mesh.getVertexData(vertexId).position.z, record+8 );
+            record += 3*sizeof(float);
+            for( size_t i=0; i<this->vertexAttributes.size(); ++i )
+            {
+                this->vertexAttributes[i]->writeBinary( vertexId, record );
+                record += this->vertexAttributes[i]->getSize();
+            }
+        }
+        stream.write( &buffer[0], blockCount*vertexSize );
+    }
+
+    // the faces can have any size, so the buffer is sent when it has
+    // about BLOCK_SIZE triangles
+    size_t faceAttributesSize = 0;
+    for( size_t i=0; i<this->faceAttributes.size(); ++i )
+    {
+        faceAttributesSize += this->faceAttributes[i]->getSize();
+    }
+    const size_t flushSize = BLOCK_SIZE*(1+3*sizeof(uint32_t)+faceAttributesSize);
+    std::vector<uint32_t> vertexIds;
+    buffer.clear();
+    buffer.reserve( flushSize + 1024 );
+    for( unsigned int faceId=0; faceId<numFaces; ++faceId )
+    {
+        getFaceVertices( mesh, faceId, vertexIds );
+        size_t position = buffer.size();
+        buffer.resize( position + 1 + vertexIds.size()*sizeof(uint32_t) + faceAttributesSize );
+        buffer[position++] = (char)vertexIds.size();
+        for( size_t v=0; v<vertexIds.size(); ++v, position+=sizeof(uint32_t) )
+        {
+            writeId( vertexIds[v], &buffer[position] );
+        }
+        for( size_t i=0; i<this->faceAttributes.size(); ++i )
+        {
+            this->faceAttributes[i]->writeBinary( faceId, &buffer[position] );
+            position += this->faceAttributes[i]->getSize();
+        }
+        if( buffer.size()>=flushSize )
+        {
+            stream.write( &buffer[0], buffer.size() );
+            buffer.clear();
+        }
+    }
+    if( !buffer.empty() )
+    {
+        stream.write( &buffer[0], buffer.size() );
+    }
+}
+
+template <class MeshT>
+void PlyExporter<MeshT>::writeText(const MeshT& mesh, std::ostream& stream) const
+{
+    const unsigned int numVertices = mesh.getNumVertices();
+    const unsigned int numFaces = mesh.getNumFaces();
+
+    TextWriter writer( stream );
+    for( unsigned int vertexId=0; vertexId<numVertices; ++vertexId )
+    {
+        PlyPropertyType<float>::writeText( writer, (float)mesh.getVertexData(vertexId).position.x );
+        writer.write( ' ' );
+        PlyPropertyType<float>::writeText( writer, (float)mesh.getVertexData(vertexId).position.y );
+        writer.write( ' ' );
+        PlyPropertyType<float>::writeText( writer, (float)mesh.getVertexData(vertexId).position.z );
+        for( size_t i=0; i<this->vertexAttributes.size(); ++i )
+        {
+            writer.write( ' ' );
+            this->vertexAttributes[i]->writeText( vertexId, writer );
+        }
+        writer.newLine();
+    }
+
+    std::vector<uint32_t> vertexIds;
+    for( unsigned int faceId=0; faceId<numFaces; ++faceId )
+    {
+        getFaceVertices( mesh, faceId, vertexIds );
+        writer.writeUnsigned( vertexIds.size() );
+        for( size_t v=0; v<vertexIds.size(); ++v )
+        {
+            writer.write( ' ' );
+            writer.writeUnsigned( vertexIds[v] );
+        }
+        for( size_t i=0; i<this->faceAttributes.size(); ++i )
+        {
+            writer.write( ' ' );
+            this->faceAttributes[i]->writeText( faceId, writer );
+        }
+        writer.newLine();
+    }
+    writer.flush();
+}
+
+template <class MeshT>
+void PlyExporter<MeshT>::getFaceVertices(const MeshT& mesh, unsigned int faceId, std::vector<uint32_t>& vertexIds)
+{
+    typedef CirculatorRange<MeshT, AroundFaceStep, OriginValue> FaceVertexRange;
+    const FaceVertexRange vertices = faceVertices( mesh, faceId );
+    vertexIds.assign( vertices.begin(), vertices.end() );
+    if( vertexIds.size()>255 )
+    {
+        throw cpp::Exception("A face with more than 255 vertices cannot be written to a PLY file");
+    }
+}
+
+template <class MeshT>
+void PlyExporter<MeshT>::writeFloat(float value, char* destination)
+{
+    std::memcpy( destination, &value, sizeof(float) );
+    if( !isLittleEndianHost() )
+    {
+        std::reverse( destination, destination+sizeof(float) );
+    }
+}
+
+template <class MeshT>
+void PlyExporter<MeshT>::writeId(uint32_t value, char* destination)
+{
+    std::memcpy( destination, &value, sizeof(uint32_t) );
+    if( !isLittleEndianHost() )
+    {
+        std::reverse( destination, destination+sizeof(uint32_t) );
+    }
+}
+
+#endif//PlyExporter_h
@@ -8,7 +8,13 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "PlyImporter.h"
+#include "MappedFile.h"
+#include "TextScanner.h"
+#include "DCELBinaryFormat.h"
+#include "IntTypes.h"
 #include "../rply/rply.h"
+#include <cstring>
+#include <algorithm>
 
 /*
     This code uses the RPly 1.01 library, from 
@@ -71,13 +77,580 @@ void error_cb(const char *message)
     std::cerr << message << std::endl;
 }
 
-void PlyLoader::load( const std::string& plyFilename )
+namespace
+{
+    enum PlyFormat
+    {
+        FORMAT_ASCII,
+        FORMAT_BINARY_LITTLE_ENDIAN,
+        FORMAT_BINARY_BIG_ENDIAN
+    };
+
+    enum PlyValueType
+    {
+        VALUE_INT8,
+        VALUE_UINT8,
+        VALUE_INT16,
+        VALUE_UINT16,
+        VALUE_INT32,
+        VALUE_UINT32,
+        VALUE_FLOAT32,
+        VALUE_FLOAT64,
+        VALUE_INVALID
+    };
+
+    struct PlyProperty
+    {
+        std::string name;
+        bool isList;
+        PlyValueType type; // the type of the values of a list
+        PlyValueType countType;
+    };
+
+    struct PlyElement
+    {
+        std::string name;
+        unsigned int count;
+        std::vector<PlyProperty> properties;
+    };
+
+    struct PlyHeader
+    {
+        PlyHeader():
+            format(FORMAT_ASCII),
+            dataOffset(0)
+        {
+        }
+
+        PlyFormat format;
+        std::vector<PlyElement> elements;
+        size_t dataOffset;
+    };
+
+    PlyValueType getValueType(const std::string& name)
+    {
+        if( name=="char" || name=="int8" ) return VALUE_INT8;
+        if( name=="uchar" || name=="uint8" ) return VALUE_UINT8;
+        if( name=="short" || name=="int16" ) return VALUE_INT16;
+        if( name=="ushort" || name=="uint16" ) return VALUE_UINT16;
+        if( name=="int" || name=="int32" ) return VALUE_INT32;
+        if( name=="uint" || name=="uint32" ) return VALUE_UINT32;
+        if( name=="float" || name=="float32" ) return VALUE_FLOAT32;
+        if( name=="double" || name=="float64" ) return VALUE_FLOAT64;
+        return VALUE_INVALID;
+    }
+
+    size_t getValueSize(PlyValueType type)
+    {
+        static const size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+        return sizes[type];
+    }
+
+    /**
+    	Reads the header of the file. Returns false if it is not a header that
+        this code understands (RPly will report what is wrong with it).
+    */
+    bool parsePlyHeader(const char* data, size_t size, PlyHeader& header)
+    {
+        TextScanner scanner( data, data+size );
+        size_t length;
+        const char* word = scanner.readWord(length);
+        if( std::string(word, length)!="ply" )
+        {
+            return false;
+        }
+        header.elements.clear();
+        bool hasFormat = false;
+        while( true )
+        {
+            scanner.skipLine();
+            if( scanner.atEnd() )
+            {
+                return false;
+            }
+            scanner.skipSpaces();
+            word = scanner.readWord(length);
+            const std::string keyword( word, length );
+            scanner.skipSpaces();
+            if( keyword=="format" )
+            {
+                word = scanner.readWord(length);
+                const std::string format( word, length );
+                if( format=="ascii" ) header.format = FORMAT_ASCII;
+                else if( format=="binary_little_endian" ) header.format = FORMAT_BINARY_LITTLE_ENDIAN;
+                else if( format=="binary_big_endian" ) header.format = FORMAT_BINARY_BIG_ENDIAN;
+                else return false;
+                hasFormat = true;
+            }
+            else if( keyword=="element" )
+            {
+                PlyElement element;
+                word = scanner.readWord(length);
+                element.name.assign( word, length );
+                scanner.skipSpaces();
+                if( !scanner.readUnsigned(element.count) )
+                {
+                    return false;
+                }
+                header.elements.push_back( element );
+            }
+            else if( keyword=="property" )
+            {
+                if( header.elements.empty() )
+                {
+                    return false;
+                }
+                PlyProperty property;
+                word = scanner.readWord(length);
+                property.isList = std::string(word, length)=="list";
+                property.countType = VALUE_INVALID;
+                if( property.isList )
+                {
+                    scanner.skipSpaces();
+                    word = scanner.readWord(length);
+                    property.countType = getValueType( std::string(word, length) );
+                    scanner.skipSpaces();
+                    word = scanner.readWord(length);
+                }
+                property.type = getValueType( std::string(word, length) );
+                scanner.skipSpaces();
+                word = scanner.readWord(length);
+                property.name.assign( word, length );
+                if( property.type==VALUE_INVALID || (property.isList && property.countType==VALUE_INVALID) )
+                {
+                    return false;
+                }
+                header.elements.back().properties.push_back( property );
+            }
+            else if( keyword=="end_header" )
+            {
+                scanner.skipLine();
+                header.dataOffset = scanner.getPosition() - data;
+                return hasFormat;
+            }
+            // comments and obj_info are ignored
+        }
+    }
+
+    /**
+    	Reverses the bytes of each value of an array.
+    */
+    void swapBytes(char* values, size_t count, size_t valueSize)
+    {
+        for( size_t i=0; i<count; ++i, values+=valueSize )
+        {
+            std::reverse( values, values+valueSize );
+        }
+    }
+
+    /**
+    	Reads one value of a binary file, converted to T.
+    */
+    template<class T>
+    inline T readValue(const char* data, PlyValueType type, bool swap)
+    {
+        char bytes[8];
+        const size_t size = getValueSize(type);
+        std::memcpy( bytes, data, size );
+        if( swap )
+        {
+            std::reverse( bytes, bytes+size );
+        }
+        switch( type )
+        {
+        case VALUE_INT8: return (T)*(const signed char*)bytes;
+        case VALUE_UINT8: return (T)*(const unsigned char*)bytes;
+        case VALUE_INT16: { int16_t v; std::memcpy( &v, bytes, 2 ); return (T)v; }
+        case VALUE_UINT16: { uint16_t v; std::memcpy( &v, bytes, 2 ); return (T)v; }
+        case VALUE_INT32: { int32_t v; std::memcpy( &v, bytes, 4 ); return (T)v; }
+        case VALUE_UINT32: { uint32_t v; std::memcpy( &v, bytes, 4 ); return (T)v; }
+        case VALUE_FLOAT32: { float v; std::memcpy( &v, bytes, 4 ); return (T)v; }
+        case VALUE_FLOAT64: { double v; std::memcpy( &v, bytes, 8 ); return (T)v; }
+        default: return T();
+        }
+    }
+
+    void throwEndOfFile()
+    {
+        throw cpp::Exception("Unexpected end of the PLY file");
+    }
+
+    void throwNotTriangles()
+    {
+        throw cpp::Exception("This file contains other things than triangles!");
+    }
+
+    /**
+    	The sum of the sizes of the properties of the element, if all of them
+        are scalars. Returns 0 if there is a list.
+    */
+    size_t getFixedSize(const PlyElement& element)
+    {
+        size_t size = 0;
+        for( size_t i=0; i<element.properties.size(); ++i )
+        {
+            if( element.properties[i].isList )
+            {
+                return 0;
+            }
+            size += getValueSize( element.properties[i].type );
+        }
+        return size;
+    }
+
+    /**
+    	Writes the values of a property of the file to an attribute channel.
+    */
+    class PropertyReader
+    {
+    public:
+        virtual ~PropertyReader()
+        {
+        };
+
+        /**
+        	Reads the value of the element from a binary file.
+        */
+        virtual void read(unsigned int index, const char* data, bool swap) = 0;
+
+        /**
+        	Sets the value read by RPly.
+        */
+        virtual void set(unsigned int index, double value) = 0;
+    };
+
+    template<class T>
+    class TypedPropertyReader: public PropertyReader
+    {
+    public:
+        TypedPropertyReader(AttributeChannel<T>& channel, PlyValueType type):
+            channel(channel),
+            type(type)
+        {
+        };
+
+        virtual void read(unsigned int index, const char* data, bool swap)
+        {
+            this->channel[index] = readValue<T>( data, this->type, swap );
+        };
+
+        virtual void set(unsigned int index, double value)
+        {
+            this->channel[index] = (T)value;
+        };
+
+    private:
+        AttributeChannel<T>& channel;
+        PlyValueType type;
+    };
+
+    /**
+    	Adds a channel with the name and the type of a property to the set,
+        and returns the reader that fills it.
+    */
+    PropertyReader* createPropertyReader(AttributeSet& attributes, const std::string& name, PlyValueType type)
+    {
+        switch( type )
+        {
+        case VALUE_INT8: return new TypedPropertyReader<signed char>( attributes.add<signed char>(name), type );
+        case VALUE_UINT8: return new TypedPropertyReader<unsigned char>( attributes.add<unsigned char>(name), type );
+        case VALUE_INT16: return new TypedPropertyReader<short>( attributes.add<short>(name), type );
+        case VALUE_UINT16: return new TypedPropertyReader<unsigned short>( attributes.add<unsigned short>(name), type );
+        case VALUE_INT32: return new TypedPropertyReader<int>( attributes.add<int>(name), type );
+        case VALUE_UINT32: return new TypedPropertyReader<unsigned int>( attributes.add<unsigned int>(name), type );
+        case VALUE_FLOAT32: return new TypedPropertyReader<float>( attributes.add<float>(name), type );
+        case VALUE_FLOAT64: return new TypedPropertyReader<double>( attributes.add<double>(name), type );
+        default: return NULL;
+        }
+    }
+
+    /**
+    	The readers of the properties of an element, NULL for the ones that
+        are not read to attributes. They are deleted with the list.
+    */
+    struct PropertyReaderList
+    {
+        ~PropertyReaderList()
+        {
+            for( size_t i=0; i<this->readers.size(); ++i )
+            {
+                delete this->readers[i];
+            }
+        };
+
+        std::vector<PropertyReader*> readers;
+    };
+
+    /**
+    	Creates the readers of the scalar properties of an element, except
+        the ones that are read to the buffers of the loader.
+    */
+    void createPropertyReaders(const PlyElement& element, AttributeSet& attributes, PropertyReaderList& list)
+    {
+        attributes.resize( element.count );
+        list.readers.assign( element.properties.size(), (PropertyReader*)NULL );
+        for( size_t p=0; p<element.properties.size(); ++p )
+        {
+            const PlyProperty& property = element.properties[p];
+            const bool isPosition = element.name=="vertex" && (property.name=="x" || property.name=="y" || property.name=="z");
+            if( !property.isList && !isPosition )
+            {
+                list.readers[p] = createPropertyReader( attributes, property.name, property.type );
+            }
+        }
+    }
+
+    int attribute_cb(p_ply_argument argument)
+    {
+        PropertyReader* reader;
+        long instance;
+        ply_get_argument_user_data(argument, (void**)&reader, NULL);
+        ply_get_argument_element(argument, NULL, &instance);
+        reader->set( (unsigned int)instance, ply_get_argument_value(argument) );
+        return 1;
+    }
+}
+
+bool PlyLoader::loadBinary(const char* data, size_t size, bool loadAttributes)
+{
+    PlyHeader header;
+    if( !parsePlyHeader( data, size, header ) || header.format==FORMAT_ASCII )
+    {
+        return false;
+    }
+    const bool swap = isLittleEndianHost()!=(header.format==FORMAT_BINARY_LITTLE_ENDIAN);
+
+    // checks the layout before reading anything
+    for( size_t e=0; e<header.elements.size(); ++e )
+    {
+        const PlyElement& element = header.elements[e];
+        if( element.name=="face" )
+        {
+            unsigned int lists = 0;
+            for( size_t p=0; p<element.properties.size(); ++p )
+            {
+                const PlyProperty& property = element.properties[p];
+                if( property.isList && (property.name!="vertex_indices" || property.type==VALUE_FLOAT32 || property.type==VALUE_FLOAT64) )
+                {
+                    return false;
+                }
+                lists += property.isList? 1 : 0;
+            }
+            if( lists!=1 )
+            {
+                return false;
+            }
+        }
+        else if( element.count>0 && getFixedSize(element)==0 )
+        {
+            return false;
+        }
+    }
+
+    const char* position = data + header.dataOffset;
+    const char* end = data + size;
+    for( size_t e=0; e<header.elements.size(); ++e )
+    {
+        const PlyElement& element = header.elements[e];
+        if( element.name=="vertex" )
+        {
+            const size_t stride = getFixedSize(element);
+            if( element.count>0 && (size_t)(end-position)/stride<element.count )
+            {
+                throwEndOfFile();
+            }
+
+            // the offset and type of each coordinate, and the offsets of the
+            // properties read to attributes
+            size_t offsets[3] = { 0, 0, 0 };
+            PlyValueType types[3] = { VALUE_INVALID, VALUE_INVALID, VALUE_INVALID };
+            PropertyReaderList attributeReaders;
+            std::vector< std::pair<PropertyReader*, size_t> > attributes;
+            if( loadAttributes )
+            {
+                createPropertyReaders( element, this->vertexAttributes, attributeReaders );
+            }
+            size_t offset = 0;
+            for( size_t p=0; p<element.properties.size(); ++p )
+            {
+                const PlyProperty& property = element.properties[p];
+                const int axis = property.name=="x"? 0 : property.name=="y"? 1 : property.name=="z"? 2 : -1;
+                if( axis>=0 )
+                {
+                    offsets[axis] = offset;
+                    types[axis] = property.type;
+                }
+                else if( loadAttributes && attributeReaders.readers[p]!=NULL )
+                {
+                    attributes.push_back( std::make_pair( attributeReaders.readers[p], offset ) );
+                }
+                offset += getValueSize( property.type );
+            }
+
+            this->verticeCount = element.count;
+            this->vertices.resize( element.count, Vector3f(0,0,0) );
+            const bool packedFloats = stride==3*sizeof(float)
+                && types[0]==VALUE_FLOAT32 && types[1]==VALUE_FLOAT32 && types[2]==VALUE_FLOAT32
+                && offsets[0]==0 && offsets[1]==4 && offsets[2]==8;
+            if( packedFloats )
+            {
+                // the whole element is an array of floats, copied in blocks
+                // to a plain buffer and assigned to the vertices from there
+                const unsigned int blockSize = 1<<10;
+                float coordinates[3*blockSize];
+                for( unsigned int first=0; first<element.count; first+=blockSize )
+                {
+                    const unsigned int count = std::min( element.count-first, blockSize );
+                    std::memcpy( coordinates, position + (size_t)first*stride, (size_t)count*stride );
+                    if( swap )
+                    {
+                        swapBytes( (char*)coordinates, (size_t)count*3, sizeof(float) );
+                    }
+                    for( unsigned int i=0; i<count; ++i )
+                    {
+                        this->vertices[first+i] = Vector3f( coordinates[3*i], coordinates[3*i+1], coordinates[3*i+2] );
+                    }
+                }
+            }
+            else
+            {
+                for( unsigned int i=0; i<element.count; ++i )
+                {
+                    const char* record = position + i*stride;
+                    float coordinates[3] = { 0, 0, 0 };
+                    for( int axis=0; axis<3; ++axis )
+                    {
+                        if( types[axis]!=VALUE_INVALID )
+                        {
+                            coordinates[axis] = readValue<float>( record+offsets[axis], types[axis], swap );
+                        }
+                    }
+                    this->vertices[i] = Vector3f( coordinates[0], coordinates[1], coordinates[2] );
+                    for( size_t a=0; a<attributes.size(); ++a )
+                    {
+                        attributes[a].first->read( i, record+attributes[a].second, swap );
+                    }
+                }
+            }
+            position += element.count*stride;
+        }
+        else if( element.name=="face" )
+        {
+            // the faces are triangles, so each record has at least the
+            // properties, and the count and 3 values of each list
+            size_t minimumRecordSize = 0;
+            for( size_t p=0; p<element.properties.size(); ++p )
+            {
+                const PlyProperty& property = element.properties[p];
+                minimumRecordSize += property.isList? getValueSize( property.countType ) + 3*getValueSize( property.type ) : getValueSize( property.type );
+            }
+            if( element.count>0 && (size_t)(end-position)/minimumRecordSize<element.count )
+            {
+                throwEndOfFile();
+            }
+
+            this->faceCount = element.count;
+            this->faces.resize( (size_t)element.count*3 );
+            unsigned int* faceVertices = this->faces.empty()? NULL : &this->faces[0];
+            PropertyReaderList attributeReaders;
+            if( loadAttributes )
+            {
+                createPropertyReaders( element, this->faceAttributes, attributeReaders );
+            }
+
+            if( element.properties.size()==1 && element.properties[0].countType==VALUE_UINT8
+                && getValueSize( element.properties[0].type )==4 )
+            {
+                // the most common layout: a byte with the 3, and three 32-bit indices
+                const size_t recordSize = 1 + 3*4;
+                if( (size_t)(end-position)/recordSize<element.count )
+                {
+                    throwEndOfFile();
+                }
+                for( unsigned int i=0; i<element.count; ++i, position+=recordSize )
+                {
+                    if( *position!=3 ) //ensures only triangles are read
+                    {
+                        throwNotTriangles();
+                    }
+                    std::memcpy( faceVertices+(size_t)i*3, position+1, 3*4 );
+                }
+                if( swap )
+                {
+                    swapBytes( (char*)faceVertices, (size_t)element.count*3, 4 );
+                }
+            }
+            else
+            {
+                for( unsigned int i=0; i<element.count; ++i )
+                {
+                    for( size_t p=0; p<element.properties.size(); ++p )
+                    {
+                        const PlyProperty& property = element.properties[p];
+                        const size_t countSize = property.isList? getValueSize( property.countType ) : 0;
+                        const size_t valueSize = getValueSize( property.type );
+                        if( (size_t)(end-position)<countSize+(property.isList? 3 : 1)*valueSize )
+                        {
+                            throwEndOfFile();
+                        }
+                        if( !property.isList )
+                        {
+                            if( loadAttributes && attributeReaders.readers[p]!=NULL )
+                            {
+                                attributeReaders.readers[p]->read( i, position, swap );
+                            }
+                            position += valueSize;
+                            continue;
+                        }
+                        if( readValue<unsigned int>( position, property.countType, swap )!=3 ) //ensures only triangles are read
+                        {
+                            throwNotTriangles();
+                        }
+                        position += countSize;
+                        for( int v=0; v<3; ++v, position+=valueSize )
+                        {
+                            faceVertices[(size_t)i*3+v] = readValue<unsigned int>( position, property.type, swap );
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            // other elements are skipped
+            const size_t stride = getFixedSize(element);
+            if( element.count>0 && (size_t)(end-position)/stride<element.count )
+            {
+                throwEndOfFile();
+            }
+            position += element.count*stride;
+        }
+    }
+    return true;
+}
+
+void PlyLoader::load( const std::string& plyFilename, bool loadAttributes )
 {
     this->vertices.clear();
     this->verticeCount = 0;
     this->faces.clear();
     this->faceCount = 0;
+    this->vertexAttributes = AttributeSet();
+    this->faceAttributes = AttributeSet();
 
+    {
+        MappedFile file;
+        file.open( plyFilename );
+        if( file.getData()!=NULL && this->loadBinary( file.getData(), file.getSize(), loadAttributes ) )
+        {
+            return;
+        }
+    }
+    this->loadWithRply( plyFilename, loadAttributes );
+}
+
+void PlyLoader::loadWithRply( const std::string& plyFilename, bool loadAttributes )
+{
     p_ply ply = ply_open(plyFilename.c_str(), error_cb);
     if( !ply )
     {
@@ -94,6 +667,56 @@ void PlyLoader::load( const std::string& plyFilename )
     ply_set_read_cb(ply, "vertex", "z", vertex_cb, this, 2);
 
     this->faceCount = ply_set_read_cb(ply, "face", "vertex_indices", face_cb, this, 0);
+
+    // the other scalar properties of the vertices and faces go to attributes
+    PropertyReaderList vertexReaders;
+    PropertyReaderList faceReaders;
+    if( loadAttributes )
+    {
+        p_ply_element plyElement = NULL;
+        while( (plyElement = ply_get_next_element(ply, plyElement))!=NULL )
+        {
+            const char* name;
+            long count;
+            ply_get_element_info(plyElement, &name, &count);
+            PlyElement element;
+            element.name = name;
+            element.count = (unsigned int)count;
+            if( element.name!="vertex" && element.name!="face" )
+            {
+                continue;
+            }
+
+            p_ply_property plyProperty = NULL;
+            while( (plyProperty = ply_get_next_property(plyElement, plyProperty))!=NULL )
+            {
+                PlyProperty property;
+                e_ply_type type;
+                ply_get_property_info(plyProperty, &name, &type, NULL, NULL);
+                property.name = name;
+                property.isList = type==PLY_LIST;
+                // the aliases (PLY_CHAR, ...) are in the same order as the sized types
+                property.type = property.isList? VALUE_INVALID : (PlyValueType)(type%8);
+                property.countType = VALUE_INVALID;
+                element.properties.push_back( property );
+            }
+
+            const bool isVertex = element.name=="vertex";
+            PropertyReaderList& readers = isVertex? vertexReaders : faceReaders;
+            createPropertyReaders( element, isVertex? this->vertexAttributes : this->faceAttributes, readers );
+            for( size_t p=0; p<readers.readers.size(); ++p )
+            {
+                if( readers.readers[p]!=NULL )
+                {
+                    ply_set_read_cb(ply, element.name.c_str(), element.properties[p].name.c_str(), attribute_cb, readers.readers[p], 0);
+                }
+            }
+        }
+    }
+
+    // the callbacks only append to the buffers
+    this->vertices.reserve( this->verticeCount );
+    this->faces.reserve( this->faceCount*3 );
     if (!ply_read(ply))
     {
         throw cpp::Exception(std::string("Error loading the the whole file '")+plyFilename+"'");
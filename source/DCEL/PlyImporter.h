@@ -11,24 +11,53 @@
 #define PlyImporter_h
 
 #include "DCELStream.h"
+#include "ImportOptions.h"
 #include "Vector3.h"
 
 /**
 	This class is used internally by the PlyImporter, and should not be used externally.
 
-    It loads a set of vertices into the "vertices" list and the set of faces into the 
-    "faces" list. Each 3 values into the "faces" lists stores one triangular face,
+    It loads a set of vertices into the "vertices" buffer and the set of faces into the 
+    "faces" buffer. Each 3 values into the "faces" buffer stores one triangular face,
     composed by the vertices referenced by the 3 unsigned int values.
+
+    The buffers are sized from the counts in the header of the file. They are only
+    cleared (not released) at each load, so a loader that is reused for several
+    files doesn't allocate them again.
+
+    The binary files are mapped in memory and read directly, without a call for
+    each value: the vertex positions and the faces are copied (and byte-swapped,
+    if the file has another endianness) into the buffers. The ASCII files, and the
+    binary ones with other lists than the faces, are read with the RPly library.
 */
 class PlyLoader
 {
 public:
-    void load(const std::string& plyFilename);
+    /**
+    	Loads the file. With loadAttributes, the scalar properties of the
+        vertices (other than x, y and z) and of the faces are also read, in
+        the same pass, to channels of vertexAttributes and faceAttributes with
+        the names of the properties and their types ("uchar" is an unsigned
+        char, "float" a float, and so on).
+    */
+    void load(const std::string& plyFilename, bool loadAttributes = false);
 
-    std::list<Vector3f> vertices;
+    std::vector<Vector3f> vertices;
     unsigned int verticeCount;
-    std::list<unsigned int> faces;
+    std::vector<unsigned int> faces;
     unsigned int faceCount;
+    AttributeSet vertexAttributes;
+    AttributeSet faceAttributes;
+protected:
+private:
+
+    /**
+    	Reads a binary file mapped in memory. Returns false, without reading
+        anything, if it is an ASCII file or its layout is not supported.
+    */
+    bool loadBinary(const char* data, size_t size, bool loadAttributes);
+
+    void loadWithRply(const std::string& plyFilename, bool loadAttributes);
 };
 
 /**
@@ -45,60 +74,68 @@ public:
         Loads from the given filename.
 
         It just calls the 'import' method with the opened stream.
+
+        The options define how the mesh is checked after (or while) it is built.
+        With options.importAttributes, the other properties of the vertices and
+        faces become attribute channels of the mesh, like:
+
+            mesh.getVertexAttributes().get<float>( "nx" )[vertexId]
+            mesh.getVertexAttributes().get<unsigned char>( "red" )[vertexId]
     */
-    void import( const std::string& plyFilename, MeshT& mesh );
+    void import( const std::string& plyFilename, MeshT& mesh, const ImportOptions& options = ImportOptions() );
 
 private:
+
+    // kept between imports, to reuse its buffers
+    PlyLoader loader;
 };
 
 
 template <class MeshT>
-void PlyImporter<MeshT>::import( const std::string& plyFilename, MeshT& mesh )
+void PlyImporter<MeshT>::import( const std::string& plyFilename, MeshT& mesh, const ImportOptions& options )
 {
     std::cerr << "Starting importing the file '" << plyFilename << "'" << std::endl;
 
     std::cerr << "- loading the PLY file" << std::endl;
     //loads the ply file
-    PlyLoader loader;
-    loader.load( plyFilename );
+    loader.load( plyFilename, options.importAttributes );
 
     // put it into the mesh
     std::cerr << "- loading the DCEL mesh: " << std::endl;
     std::cerr << "  + " << loader.verticeCount << " vertices" << std::endl;
     mesh.clear();
-    mesh.getVertices().reserve(loader.verticeCount);
-    mesh.getFaces().reserve(loader.faceCount);
-    mesh.getHalfEdges().reserve( 2*(loader.verticeCount+loader.faceCount-2) ); // Euler: V  A + F = 2 --> A = V + F - 2
-    std::list<Vector3f>::iterator vit = loader.vertices.begin();
-    while( vit!=loader.vertices.end() )
+    mesh.reserve(loader.verticeCount, 0, 0);
+    for( size_t i=0; i<loader.vertices.size(); ++i )
     {
         unsigned int id = mesh.createVertex();
-        mesh.getVertex(id)->getData().position = *vit;
-        vit++;
+        mesh.getVertexData(id).position = loader.vertices[i];
     }
 
     std::cerr << "  + " << loader.faceCount << " faces" << std::endl; 
 
-    std::list<unsigned int>::iterator fit = loader.faces.begin();
-    unsigned int count=0;
-    while( fit!=loader.faces.end() )
+    const bool facesInOrder = buildImportedMesh( mesh, loader.faces.empty()? NULL : &loader.faces[0], loader.faceCount, options );
+
+    if( options.importAttributes )
     {
-        count++;
-        unsigned int a = *fit; ++fit;
-        unsigned int b = *fit; ++fit;
-        unsigned int c = *fit; ++fit;
-        unsigned int fid = mesh.createTriangularFace( a, b, c );
-        if (fid!=-1)
+        const std::vector<std::string> vertexNames = loader.vertexAttributes.getNames();
+        const std::vector<std::string> faceNames = loader.faceAttributes.getNames();
+        std::cerr << "  + " << vertexNames.size() << " vertex and " << faceNames.size() << " face attributes" << std::endl;
+        for( size_t i=0; i<vertexNames.size(); ++i )
+        {
+            mesh.getVertexAttributes().moveFrom( loader.vertexAttributes, vertexNames[i] );
+        }
+        if( facesInOrder )
+        {
+            for( size_t i=0; i<faceNames.size(); ++i )
+            {
+                mesh.getFaceAttributes().moveFrom( loader.faceAttributes, faceNames[i] );
+            }
+        }
+        else if( !faceNames.empty() )
         {
-            mesh.checkFace(fid);
-            mesh.checkAllFaces();
+            std::cerr << "  + the face attributes were not imported, as the faces are not in the order of the file" << std::endl;
         }
     }
-
-    std::cerr << "  + " << mesh.getNumUnhandledTriangles() << " bad triangles" << std::endl;
-
-    mesh.manageUnhandledTriangles();
-    mesh.checkAllFaces();
     std::cerr << "Done!" << std::endl;
 }
 
@@ -0,0 +1,404 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TextScanner_h
+#define TextScanner_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <climits>
+#include <istream>
+#include <streambuf>
+
+#include "IntTypes.h"
+
+/**
+	Reads numbers and words from a range of characters in memory, without
+    copying them. Used by the importers to parse text files directly from the
+    bytes of a MappedFile (or from any other buffer).
+
+    The range doesn't need to end with a '\0', and there is no limit in the
+    size of a line. The methods that read a value return false (and don't
+    move) when the next characters are not a value of that type.
+
+        TextScanner scanner( text, text+size );
+        while( !scanner.atEnd() )
+        {
+            float x;
+            if( scanner.readFloat(x) ) ...
+            scanner.skipLine();
+        }
+*/
+class TextScanner
+{
+public:
+
+    /**
+    	Scans the characters in [begin, end). When the range is a part of a
+        bigger text, textBegin is its start, used to count the lines.
+    */
+    TextScanner(const char* begin, const char* end, const char* textBegin = NULL):
+        textBegin(textBegin!=NULL? textBegin : begin),
+        current(begin),
+        end(end)
+    {
+    };
+
+    inline bool atEnd() const
+    {
+        return this->current==this->end;
+    };
+
+    /**
+    	Returns the next character, or '\0' at the end of the range.
+    */
+    inline char peek() const
+    {
+        return this->current!=this->end? *this->current : '\0';
+    };
+
+    /**
+    	Consumes the next character if it is equals to c.
+    */
+    inline bool skip(char c)
+    {
+        if( this->current!=this->end && *this->current==c )
+        {
+            ++this->current;
+            return true;
+        }
+        return false;
+    };
+
+    /**
+    	Skips spaces, tabs and '\r', stopping at the end of the line.
+    */
+    inline void skipSpaces()
+    {
+        while( this->current!=this->end && (*this->current==' ' || *this->current=='\t' || *this->current=='\r') )
+        {
+            ++this->current;
+        }
+    };
+
+    /**
+    	Skips spaces, tabs and line breaks.
+    */
+    inline void skipWhitespace()
+    {
+        while( this->current!=this->end && isSpace(*this->current) )
+        {
+            ++this->current;
+        }
+    };
+
+    /**
+    	Moves to the first character of the next line.
+    */
+    inline void skipLine()
+    {
+        while( this->current!=this->end && *this->current!='\n' )
+        {
+            ++this->current;
+        }
+        if( this->current!=this->end )
+        {
+            ++this->current;
+        }
+    };
+
+    /**
+    	Returns true if the next character ends the current line (or the
+        range). Spaces before it must be skipped first.
+    */
+    inline bool atEndOfLine() const
+    {
+        return this->current==this->end || *this->current=='\n';
+    };
+
+    /**
+    	Reads a decimal number like "-12", "0.5", ".5", "1e-3" or "3.4E+38".
+    */
+    bool readFloat(float& value)
+    {
+        double result;
+        if( !this->readDouble(result) )
+        {
+            return false;
+        }
+        value = (float)result;
+        return true;
+    };
+
+    bool readDouble(double& value);
+
+    /**
+    	Reads an integer with an optional sign. Returns false if it doesn't
+        fit in an int.
+    */
+    bool readInt(int& value)
+    {
+        const char* start = this->current;
+        bool negative = false;
+        if( this->current!=this->end && (*this->current=='-' || *this->current=='+') )
+        {
+            negative = *this->current=='-';
+            ++this->current;
+        }
+        unsigned int magnitude;
+        if( !this->readUnsigned(magnitude) || magnitude>(unsigned int)INT_MAX+(negative? 1 : 0) )
+        {
+            this->current = start;
+            return false;
+        }
+        value = negative? -(int)(magnitude-1)-1 : (int)magnitude;
+        return true;
+    };
+
+    /**
+    	Reads the digits of an unsigned integer. Each character is tested
+        with a single comparison, as the IDs are most of the text of the
+        files. Returns false (without moving) if the number is larger than
+        UINT_MAX, so a corrupt ID is not read as another one.
+    */
+    bool readUnsigned(unsigned int& value)
+    {
+        const char* position = this->current;
+        unsigned int result = 0;
+        while( position!=this->end )
+        {
+            const unsigned int digit = (unsigned int)(unsigned char)*position - '0';
+            if( digit>9 )
+            {
+                break;
+            }
+            if( result>=UINT_MAX/10 && (result>UINT_MAX/10 || digit>UINT_MAX%10) )
+            {
+                return false;
+            }
+            result = result*10 + digit;
+            ++position;
+        }
+        if( position==this->current )
+        {
+            return false;
+        }
+        this->current = position;
+        value = result;
+        return true;
+    };
+
+    /**
+    	Returns the characters until the next space or end of line. The word
+        is not copied, and is not terminated by a '\0'.
+    */
+    inline const char* readWord(size_t& length)
+    {
+        const char* word = this->current;
+        while( this->current!=this->end && !isSpace(*this->current) )
+        {
+            ++this->current;
+        }
+        length = this->current - word;
+        return word;
+    };
+
+    inline const char* getPosition() const
+    {
+        return this->current;
+    };
+
+    /**
+    	Moves to a position inside the range, like one returned by
+        getPosition() or by a TextScannerStream.
+    */
+    inline void setPosition(const char* position)
+    {
+        this->current = position;
+    };
+
+    inline const char* getEnd() const
+    {
+        return this->end;
+    };
+
+    /**
+    	Counts the lines from the start of the text until the current
+        position. It is slow, and should be used only to report errors.
+    */
+    unsigned int getLineNumber() const
+    {
+        unsigned int line = 1;
+        for( const char* c=this->textBegin; c!=this->current; ++c )
+        {
+            if( *c=='\n' )
+            {
+                ++line;
+            }
+        }
+        return line;
+    };
+
+    static inline bool isDigit(char c)
+    {
+        return c>='0' && c<='9';
+    };
+
+    static inline bool isSpace(char c)
+    {
+        return c==' ' || c=='\t' || c=='\r' || c=='\n';
+    };
+
+protected:
+private:
+    const char* textBegin;
+    const char* current;
+    const char* end;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                            IMPLEMENTATION                            //
+//////////////////////////////////////////////////////////////////////////
+
+
+inline bool TextScanner::readDouble(double& value)
+{
+    // the powers of 10 that are exact in a double
+    static const double powersOf10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    // more digits than this don't fit in the mantissa, and are dropped
+    const uint64_t maxMantissa = 100000000000000000ULL;
+
+    const char* start = this->current;
+    bool negative = false;
+    if( this->current!=this->end && (*this->current=='-' || *this->current=='+') )
+    {
+        negative = *this->current=='-';
+        ++this->current;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    while( this->current!=this->end && isDigit(*this->current) )
+    {
+        if( mantissa<maxMantissa )
+        {
+            mantissa = mantissa*10 + (*this->current-'0');
+        }
+        else
+        {
+            ++exponent;
+        }
+        hasDigits = true;
+        ++this->current;
+    }
+    if( this->current!=this->end && *this->current=='.' )
+    {
+        ++this->current;
+        while( this->current!=this->end && isDigit(*this->current) )
+        {
+            if( mantissa<maxMantissa )
+            {
+                mantissa = mantissa*10 + (*this->current-'0');
+                --exponent;
+            }
+            hasDigits = true;
+            ++this->current;
+        }
+    }
+    if( !hasDigits )
+    {
+        this->current = start;
+        return false;
+    }
+
+    if( this->current!=this->end && (*this->current=='e' || *this->current=='E') )
+    {
+        const char* exponentStart = this->current;
+        ++this->current;
+        int writtenExponent;
+        if( this->readInt(writtenExponent) )
+        {
+            // anything past this is already 0 or infinity, and the sum
+            // must not overflow
+            exponent += std::max( -100000, std::min( writtenExponent, 100000 ) );
+        }
+        else // not an exponent, the number ends before the 'e'
+        {
+            this->current = exponentStart;
+        }
+    }
+
+    double result = (double)mantissa;
+    if( mantissa!=0 )
+    {
+        if( exponent<0 && exponent>=-22 )
+        {
+            result /= powersOf10[-exponent];
+        }
+        else if( exponent>0 && exponent<=22 )
+        {
+            result *= powersOf10[exponent];
+        }
+        else if( exponent!=0 )
+        {
+            result *= std::pow( 10.0, exponent );
+        }
+    }
+    value = negative? -result : result;
+    return true;
+}
+
+/**
+	A std::istream over the same characters of a TextScanner, for the values
+    that have only an operator>>. The stream starts where the scanner is, and
+    the scanner continues where the stream stopped:
+
+        TextScannerStream stream( scanner );
+        stream >> userData;
+        scanner.setPosition( stream.getPosition() );
+*/
+class TextScannerStream: private std::streambuf, public std::istream
+{
+public:
+
+    explicit TextScannerStream(const TextScanner& scanner):
+        std::istream( NULL )
+    {
+        char* position = const_cast<char*>( scanner.getPosition() );
+        this->setg( position, position, const_cast<char*>( scanner.getEnd() ) );
+        this->rdbuf( this );
+    };
+
+    inline const char* getPosition() const
+    {
+        return this->gptr();
+    };
+
+    /**
+    	Moves the stream to the position of the scanner.
+    */
+    inline void setPosition(const TextScanner& scanner)
+    {
+        this->setg( this->eback(), const_cast<char*>( scanner.getPosition() ), this->egptr() );
+        this->clear();
+    };
+
+private:
+
+    TextScannerStream(const TextScannerStream&);
+    TextScannerStream& operator=(const TextScannerStream&);
+};
+
+#endif//TextScanner_h
@@ -0,0 +1,290 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TextWriter_h
+#define TextWriter_h
+
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+/**
+	Writes text to a std::ostream through a large buffer, that is only sent
+    to the stream when it is full (or by flush()). The integers and floats
+    are formatted directly into the buffer, and any other value can be
+    written with its
+    operator<< into getStream(), which uses the same buffer and the same
+    format flags as the target stream:
+
+        TextWriter writer( stream );
+        writer.write( "v " );
+        writer.getStream() << vertexData;
+        writer.writeUnsigned( 10 );
+        writer.newLine();
+        writer.flush();
+
+    The text is the same as written by the operator<< of the target stream,
+    but the stream is not flushed at each line. Call flush() at the end: the
+    destructor doesn't send the text that is still in the buffer.
+*/
+class TextWriter: private std::streambuf
+{
+public:
+
+    explicit TextWriter(std::ostream& target, size_t bufferSize = 1<<20):
+        target(target),
+        buffer(bufferSize<16? 16 : bufferSize),
+        dataStream(this)
+    {
+        this->setp( &this->buffer[0], &this->buffer[0]+this->buffer.size() );
+        this->dataStream.copyfmt( target );
+        this->dataStream.tie( NULL );
+    };
+
+    /**
+    	A stream that writes into the buffer, for the values that have only
+        an operator<<.
+    */
+    inline std::ostream& getStream()
+    {
+        return this->dataStream;
+    };
+
+    inline void write(char c)
+    {
+        if( this->pptr()==this->epptr() )
+        {
+            this->flushBuffer();
+        }
+        *this->pptr() = c;
+        this->pbump( 1 );
+    };
+
+    inline void write(const char* text)
+    {
+        this->write( text, std::strlen(text) );
+    };
+
+    void write(const char* text, size_t length)
+    {
+        if( (size_t)(this->epptr()-this->pptr())<length )
+        {
+            this->flushBuffer();
+            if( length>this->buffer.size() )
+            {
+                this->target.write( text, length );
+                return;
+            }
+        }
+        std::memcpy( this->pptr(), text, length );
+        this->pbump( (int)length );
+    };
+
+    inline void newLine()
+    {
+        this->write( '\n' );
+    };
+
+    /**
+    	Writes the decimal digits of the value, like operator<< does with the
+        default flags.
+    */
+    inline void writeUnsigned(unsigned long long value)
+    {
+        char digits[20];
+        char* end = digits+sizeof(digits);
+        char* first = end;
+        do
+        {
+            *--first = (char)('0' + value%10);
+            value /= 10;
+        }
+        while( value!=0 );
+        this->write( first, end-first );
+    };
+
+    /**
+    	Writes a float with up to the given number of significant digits, like
+        the "%g" format of printf, but without the trailing zeros: "-1.5",
+        "0.001", "1.25e+20". The default of 9 digits (the maximum) is enough
+        to read back the same float.
+    */
+    void writeFloat(float value, unsigned int significantDigits = 9)
+    {
+        double v = value;
+        if( v!=v )
+        {
+            this->write( "nan", 3 );
+            return;
+        }
+        if( v<0 )
+        {
+            this->write( '-' );
+            v = -v;
+        }
+        if( v==0 )
+        {
+            this->write( '0' );
+            return;
+        }
+        if( v>3.5e38 )
+        {
+            this->write( "inf", 3 );
+            return;
+        }
+        const int digitCount = significantDigits<1? 1 : significantDigits>9? 9 : (int)significantDigits;
+
+        // the decimal exponent, from the binary one, and the digits as an
+        // integer with digitCount digits
+        int binaryExponent;
+        std::frexp( v, &binaryExponent );
+        int exponent = (int)std::floor( (binaryExponent-1)*0.30102999566398120 );
+        if( scaleByPowerOfTen( v, -exponent-1 )>=1.0 )
+        {
+            ++exponent;
+        }
+        const unsigned int limit = (unsigned int)scaleByPowerOfTen( 1.0, digitCount );
+        unsigned int mantissa = (unsigned int)( scaleByPowerOfTen( v, digitCount-1-exponent ) + 0.5 );
+        if( mantissa>=limit )
+        {
+            mantissa /= 10;
+            ++exponent;
+        }
+
+        char digits[9];
+        for( int i=digitCount-1; i>=0; --i )
+        {
+            digits[i] = (char)('0' + mantissa%10);
+            mantissa /= 10;
+        }
+        int length = digitCount;
+        while( length>1 && digits[length-1]=='0' )
+        {
+            --length;
+        }
+
+        if( exponent<-4 || exponent>=digitCount )
+        {
+            this->write( digits[0] );
+            if( length>1 )
+            {
+                this->write( '.' );
+                this->write( digits+1, length-1 );
+            }
+            this->write( exponent<0? "e-" : "e+", 2 );
+            const int absExponent = exponent<0? -exponent : exponent;
+            if( absExponent<10 )
+            {
+                this->write( '0' );
+            }
+            this->writeUnsigned( absExponent );
+        }
+        else if( exponent<0 )
+        {
+            this->write( "0.", 2 );
+            for( int i=-1; i>exponent; --i )
+            {
+                this->write( '0' );
+            }
+            this->write( digits, length );
+        }
+        else
+        {
+            const int integerDigits = exponent+1;
+            this->write( digits, std::min( length, integerDigits ) );
+            for( int i=length; i<integerDigits; ++i )
+            {
+                this->write( '0' );
+            }
+            if( length>integerDigits )
+            {
+                this->write( '.' );
+                this->write( digits+integerDigits, length-integerDigits );
+            }
+        }
+    };
+
+    /**
+    	Sends the buffer to the target stream, and flushes it.
+    */
+    void flush()
+    {
+        this->flushBuffer();
+        this->target.flush();
+    };
+
+protected:
+
+    virtual int_type overflow(int_type c)
+    {
+        this->flushBuffer();
+        if( !traits_type::eq_int_type( c, traits_type::eof() ) )
+        {
+            this->write( traits_type::to_char_type(c) );
+        }
+        return traits_type::not_eof( c );
+    };
+
+    virtual std::streamsize xsputn(const char* text, std::streamsize length)
+    {
+        this->write( text, (size_t)length );
+        return length;
+    };
+
+private:
+
+    // the buffer can't be shared
+    TextWriter(const TextWriter&);
+    TextWriter& operator=(const TextWriter&);
+
+    /**
+    	Returns value*10^power, with a relative error of a few 1e-16 (the
+        powers up to 10^22 are exact doubles).
+    */
+    static inline double scaleByPowerOfTen(double value, int power)
+    {
+        static const double powers[23] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        while( power>22 )
+        {
+            value *= powers[22];
+            power -= 22;
+        }
+        while( power<-22 )
+        {
+            value /= powers[22];
+            power += 22;
+        }
+        return power>=0? value*powers[power] : value/powers[-power];
+    };
+
+    /**
+    	Sends the buffer to the target stream, without flushing it.
+    */
+    void flushBuffer()
+    {
+        if( this->pptr()!=this->pbase() )
+        {
+            this->target.write( this->pbase(), this->pptr()-this->pbase() );
+            this->setp( &this->buffer[0], &this->buffer[0]+this->buffer.size() );
+        }
+    };
+
+    std::ostream& target;
+    std::vector<char> buffer;
+    std::ostream dataStream;
+};
+
+#endif//TextWriter_h
@@ -11,6 +11,7 @@
 #define DCEL_Vertex_h
 
 //#include <cassert>
+#include "IntTypes.h"
 
 template<class VertexDataT, class HalfEdgeDataT, class FaceDataT>
 class HalfEdgeT;
@@ -57,4 +58,46 @@ private:
     VertexDataT data;
 };
 
+/**
+	A vertex of a Mesh that uses the IndexStorage. Instead of a pointer, it
+    stores the ID of its incident half-edge (MESH_NULL_ID if there is none),
+    so it can be moved around in memory.
+*/
+template<class VertexDataT>
+class IndexVertexT
+{
+public:
+
+    IndexVertexT():
+        incidentEdge(~0u),
+        data()
+    {
+    };
+
+    inline unsigned int getIncidentEdgeId() const
+    {
+        return this->incidentEdge;
+    };
+
+    inline void setIncidentEdgeId(unsigned int edgeId)
+    {
+        this->incidentEdge = edgeId;
+    };
+
+    inline VertexDataT& getData()
+    {
+        return data;
+    };
+
+    inline const VertexDataT& getData() const
+    {
+        return data;
+    };
+
+protected:
+private:
+    uint32_t incidentEdge;
+    VertexDataT data;
+};
+
 #endif//DCEL_Vertex_h
@@ -0,0 +1,201 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DCEL_VertexAdjacency_h
+#define DCEL_VertexAdjacency_h
+
+#include <vector>
+
+#include "MeshStorage.h"
+
+/**
+	A snapshot of the connections between the vertices of a mesh, stored in
+    three contiguous arrays (a compressed sparse row layout). For the vertex
+    v, the positions [offsets[v], offsets[v+1]) of the other two arrays have
+    the half-edges that leave v, and the vertices where they arrive:
+
+        const VertexAdjacency& adjacency = mesh.getAdjacency();
+        const unsigned int* n = adjacency.getNeighboursBegin( vertexId );
+        const unsigned int* end = adjacency.getNeighboursEnd( vertexId );
+        for( ; n!=end; ++n ) ...
+
+    The passes that only read the mesh can walk the neighbours of all the
+    vertices without following the twin and next pointers of each half-edge.
+
+    It is built in a linear pass over the half-edges, so the neighbours of a
+    vertex are ordered by the ID of their half-edges, not around the vertex.
+    Use the circulators (see Circulators.h) when the order matters. It is not
+    updated when the mesh changes: build it again, or use the one cached by
+    Mesh::getAdjacency().
+*/
+class VertexAdjacency
+{
+public:
+
+    VertexAdjacency()
+    {
+        this->offsets.assign( 1, 0 );
+    };
+
+    /**
+    	Fills the arrays with the connections of the mesh. Works with any
+        class that has the ID methods of the Mesh. The half-edges without an
+        origin are left out.
+    */
+    template<class MeshT>
+    void build(const MeshT& mesh);
+
+    /**
+    	Removes all the vertices.
+    */
+    void clear()
+    {
+        this->offsets.assign( 1, 0 );
+        this->neighbours.clear();
+        this->outgoingHalfEdges.clear();
+    };
+
+    inline unsigned int getNumVertices() const
+    {
+        return (unsigned int)this->offsets.size()-1;
+    };
+
+    /**
+    	The number of half-edges in all the lists, that is also the number of
+        half-edges of the mesh that have an origin.
+    */
+    inline unsigned int getNumHalfEdges() const
+    {
+        return this->offsets.back();
+    };
+
+    /**
+    	The number of half-edges that leave the vertex.
+    */
+    inline unsigned int getValence(unsigned int vertexId) const
+    {
+        return this->offsets[vertexId+1] - this->offsets[vertexId];
+    };
+
+    /**
+    	The vertices connected to the vertex, one for each half-edge that
+        leaves it.
+    */
+    inline const unsigned int* getNeighboursBegin(unsigned int vertexId) const
+    {
+        return this->getData( this->neighbours ) + this->offsets[vertexId];
+    };
+
+    inline const unsigned int* getNeighboursEnd(unsigned int vertexId) const
+    {
+        return this->getData( this->neighbours ) + this->offsets[vertexId+1];
+    };
+
+    /**
+    	The half-edges that leave the vertex, in the same order as the
+        neighbours.
+    */
+    inline const unsigned int* getOutgoingHalfEdgesBegin(unsigned int vertexId) const
+    {
+        return this->getData( this->outgoingHalfEdges ) + this->offsets[vertexId];
+    };
+
+    inline const unsigned int* getOutgoingHalfEdgesEnd(unsigned int vertexId) const
+    {
+        return this->getData( this->outgoingHalfEdges ) + this->offsets[vertexId+1];
+    };
+
+    /**
+    	The arrays themselves, for the passes that go over all the vertices.
+        getOffsets() has one value more than the number of vertices.
+    */
+    inline const std::vector<unsigned int>& getOffsets() const
+    {
+        return this->offsets;
+    };
+
+    inline const std::vector<unsigned int>& getNeighbours() const
+    {
+        return this->neighbours;
+    };
+
+    inline const std::vector<unsigned int>& getOutgoingHalfEdges() const
+    {
+        return this->outgoingHalfEdges;
+    };
+
+protected:
+private:
+
+    /**
+    	The first value of the array, that can't be taken with &array[0]
+        when it is empty.
+    */
+    static inline const unsigned int* getData(const std::vector<unsigned int>& values)
+    {
+        return values.empty()? NULL : &values[0];
+    };
+
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> neighbours;
+    std::vector<unsigned int> outgoingHalfEdges;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                            IMPLEMENTATION                            //
+//////////////////////////////////////////////////////////////////////////
+
+
+template<class MeshT>
+void VertexAdjacency::build(const MeshT& mesh)
+{
+    const unsigned int numVertices = mesh.getNumVertices();
+    const unsigned int numHalfEdges = mesh.getNumHalfEdges();
+
+    // counts the half-edges of each vertex at offsets[v+1]
+    this->offsets.assign( numVertices+1, 0 );
+    unsigned int numOutgoing = 0;
+    for( unsigned int halfEdgeId=0; halfEdgeId<numHalfEdges; ++halfEdgeId )
+    {
+        const unsigned int origin = mesh.getHalfEdgeOrigin( halfEdgeId );
+        if( origin!=MESH_NULL_ID )
+        {
+            this->offsets[origin+1]++;
+            numOutgoing++;
+        }
+    }
+    for( unsigned int v=0; v<numVertices; ++v )
+    {
+        this->offsets[v+1] += this->offsets[v];
+    }
+
+    // offsets[v] is used as the position of the next half-edge of v, and
+    // ends at the start of v+1. They are moved back to their place after.
+    this->neighbours.resize( numOutgoing );
+    this->outgoingHalfEdges.resize( numOutgoing );
+    for( unsigned int halfEdgeId=0; halfEdgeId<numHalfEdges; ++halfEdgeId )
+    {
+        const unsigned int origin = mesh.getHalfEdgeOrigin( halfEdgeId );
+        if( origin!=MESH_NULL_ID )
+        {
+            const unsigned int position = this->offsets[origin]++;
+            const unsigned int twin = mesh.getHalfEdgeTwin( halfEdgeId );
+            this->neighbours[position] = twin!=MESH_NULL_ID? mesh.getHalfEdgeOrigin(twin) : MESH_NULL_ID;
+            this->outgoingHalfEdges[position] = halfEdgeId;
+        }
+    }
+    for( unsigned int v=numVertices; v>0; --v )
+    {
+        this->offsets[v] = this->offsets[v-1];
+    }
+    this->offsets[0] = 0;
+}
+
+#endif//DCEL_VertexAdjacency_h
@@ -0,0 +1,317 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright Leonardo Fischer 2011 - http://coderender.blogspot.com
+//
+//  Distributed under the licence available in the accompanying file
+//  LICENCE.txt. Please read it before use this code.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef WavefrontObjExporter_h
+#define WavefrontObjExporter_h
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Mesh.h"
+#include "Circulators.h"
+#include "Parallel.h"
+#include "TextWriter.h"
+#include "Vector3.h"
+
+/**
+    Class that exports a DCEL mesh to a Wavefront OBJ file.
+
+    A "v" line is written for the position of each vertex (the position of
+    its VertexData, as the importers use), and a "f" line for each face, with
+    the IDs of its vertices (plus 1, as the OBJ files count from 1). With
+    setNormalsWritten(true), a "vn" line is also written for each vertex,
+    with the average of the normals of its faces weighted by their areas,
+    and the faces use the "v//vn" syntax.
+
+        WavefrontObjExporter<MyMesh> exporter;
+        exporter.setThreadCount( 0 );
+        exporter.writeFile( mesh, "mesh.obj" );
+
+    The text is formatted directly into large buffers (see TextWriter). With
+    more than one thread, the elements are split in ranges that are formatted
+    in parallel, each one into its own buffer, and the buffers are written in
+    order. So the file is the same for any number of threads.
+*/
+template <class MeshT>
+class WavefrontObjExporter
+{
+public:
+
+    WavefrontObjExporter():
+        threadCount(1),
+        normalsWritten(false)
+    {
+    };
+
+    /**
+    	The number of threads used to format the text, or 0 to use one thread
+        per core.
+    */
+    inline void setThreadCount(unsigned int threadCount)
+    {
+        this->threadCount = threadCount;
+    };
+
+    inline unsigned int getThreadCount() const
+    {
+        return this->threadCount;
+    };
+
+    inline void setNormalsWritten(bool normalsWritten)
+    {
+        this->normalsWritten = normalsWritten;
+    };
+
+    inline bool areNormalsWritten() const
+    {
+        return this->normalsWritten;
+    };
+
+    void write(const MeshT& mesh, std::ostream& stream) const;
+
+    /**
+    	Creates the file and writes the mesh to it.
+    */
+    void writeFile(const MeshT& mesh, const std::string& filename) const;
+
+private:
+
+    /**
+    	The number of elements in each range formatted by a thread.
+    */
+    enum { RANGE_SIZE = 1<<15 };
+
+    enum RecordType
+    {
+        VERTEX_RECORDS,
+        NORMAL_RECORDS,
+        FACE_RECORDS
+    };
+
+    /**
+    	Formats the ranges [first+i*RANGE_SIZE, first+(i+1)*RANGE_SIZE), each
+        one to its own string.
+    */
+    class FormatTask: public ParallelTask
+    {
+    public:
+        FormatTask(const MeshT& mesh, const std::vector<Vector3f>& normals, RecordType type, unsigned int first, unsigned int last, std::vector<std::string>& texts):
+            mesh(mesh),
+            normals(normals),
+            type(type),
+            first(first),
+            last(last),
+            texts(texts)
+        {
+        };
+
+        virtual void run(unsigned int index)
+        {
+            const unsigned int rangeFirst = this->first + index*RANGE_SIZE;
+            const unsigned int rangeLast = std::min<unsigned int>( this->last, rangeFirst+RANGE_SIZE );
+            std::ostringstream stream;
+            TextWriter writer( stream, 1<<16 );
+            formatRecords( this->mesh, this->normals, this->type, rangeFirst, rangeLast, writer );
+            writer.flush();
+            this->texts[index] = stream.str();
+        };
+
+    private:
+        const MeshT& mesh;
+        const std::vector<Vector3f>& normals;
+        RecordType type;
+        unsigned int first;
+        unsigned int last;
+        std::vector<std::string>& texts;
+    };
+
+    void writeRecords(const MeshT& mesh, const std::vector<Vector3f>& normals, RecordType type, unsigned int count, std::ostream& stream) const;
+
+    /**
+    	Writes the lines of the elements in [first, last).
+    */
+    static void formatRecords(const MeshT& mesh, const std::vector<Vector3f>& normals, RecordType type, unsigned int first, unsigned int last, TextWriter& writer);
+
+    static void computeNormals(const MeshT& mesh, std::vector<Vector3f>& normals);
+
+    static inline Vector3f getPosition(const MeshT& mesh, unsigned int vertexId);
+
+    unsigned int threadCount;
+    bool normalsWritten;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                            IMPLEMENTATION                            //
+//////////////////////////////////////////////////////////////////////////
+
+
+template <class MeshT>
+void WavefrontObjExporter<MeshT>::write(const MeshT& mesh, std::ostream& stream) const
+{
+    std::vector<Vector3f> normals;
+    if( this->normalsWritten )
+    {
+        computeNormals( mesh, normals );
+    }
+
+    {
+        TextWriter writer( stream, 1<<12 );
+        writer.write( "# " );
+        writer.writeUnsigned( mesh.getNumVertices() );
+        writer.write( " vertices, " );
+        writer.writeUnsigned( mesh.getNumFaces() );
+        writer.write( " faces\n" );
+        writer.flush();
+    }
+
+    this->writeRecords( mesh, normals, VERTEX_RECORDS, mesh.getNumVertices(), stream );
+    if( this->normalsWritten )
+    {
+        this->writeRecords( mesh, normals, NORMAL_RECORDS, mesh.getNumVertices(), stream );
+    }
+    this->writeRecords( mesh, normals, FACE_RECORDS, mesh.getNumFaces(), stream );
+    stream.flush();
+}
+
+template <class MeshT>
+void WavefrontObjExporter<MeshT>::writeFile(const MeshT& mesh, const std::string& filename) const
+{
+    std::ofstream stream( filename.c_str(), std::ios::out | std::ios::binary );
+    if( !stream )
+    {
+        throw cpp::Exception(std::string("Cannot create the file '")+filename+"'");
+    }
+    this->write( mesh, stream );
+    if( !stream )
+    {
+        throw cpp::Exception(std::string("Error writing the file '")+filename+"'");
+    }
+}
+
+template <class MeshT>
+void WavefrontObjExporter<MeshT>::writeRecords(const MeshT& mesh, const std::vector<Vector3f>& normals, RecordType type, unsigned int count, std::ostream& stream) const
+{
+    const unsigned int threads = this->threadCount==0? getNumCores() : this->threadCount;
+    if( threads==1 || count<=RANGE_SIZE )
+    {
+        TextWriter writer( stream );
+        formatRecords( mesh, normals, type, 0, count, writer );
+        writer.flush();
+        return;
+    }
+
+    // a few ranges per thread at a time, so only their text is in memory
+    const unsigned int rangesPerRound = threads*4;
+    std::vector<std::string> texts( rangesPerRound );
+    for( unsigned int first=0; first<count; )
+    {
+        const unsigned int last = (unsigned int)std::min<size_t>( count, first + (size_t)rangesPerRound*RANGE_SIZE );
+        const unsigned int rangeCount = (last-first+RANGE_SIZE-1)/RANGE_SIZE;
+        FormatTask task( mesh, normals, type, first, last, texts );
+        runParallel( task, rangeCount, threads );
+        for( unsigned int i=0; i<rangeCount; ++i )
+        {
+            stream.write( texts[i].data(), texts[i].size() );
+        }
+        first = last;
+    }
+}
+
+template <class MeshT>
+void WavefrontObjExporter<MeshT>::formatRecords(const MeshT& mesh, const std::vector<Vector3f>& normals, RecordType type, unsigned int first, unsigned int last, TextWriter& writer)
+{
+    if( type==VERTEX_RECORDS || type==NORMAL_RECORDS )
+    {
+        const char* prefix = type==VERTEX_RECORDS? "v " : "vn ";
+        for( unsigned int vertexId=first; vertexId<last; ++vertexId )
+        {
+            const Vector3f value = type==VERTEX_RECORDS? getPosition( mesh, vertexId ) : normals[vertexId];
+            writer.write( prefix );
+            writer.writeFloat( value.x );
+            writer.write( ' ' );
+            writer.writeFloat( value.y );
+            writer.write( ' ' );
+            writer.writeFloat( value.z );
+            writer.newLine();
+        }
+        return;
+    }
+
+    typedef CirculatorRange<MeshT, AroundFaceStep, OriginValue> FaceVertexRange;
+    const bool withNormals = !normals.empty();
+    for( unsigned int faceId=first; faceId<last; ++faceId )
+    {
+        writer.write( 'f' );
+        const FaceVertexRange vertices = faceVertices( mesh, faceId );
+        for( typename FaceVertexRange::iterator it=vertices.begin(); it!=vertices.end(); ++it )
+        {
+            writer.write( ' ' );
+            writer.writeUnsigned( *it+1 );
+            if( withNormals )
+            {
+                writer.write( "//", 2 );
+                writer.writeUnsigned( *it+1 );
+            }
+        }
+        writer.newLine();
+    }
+}
+
+template <class MeshT>
+void WavefrontObjExporter<MeshT>::computeNormals(const MeshT& mesh, std::vector<Vector3f>& normals)
+{
+    typedef CirculatorRange<MeshT, AroundFaceStep, OriginValue> FaceVertexRange;
+    const unsigned int numVertices = mesh.getNumVertices();
+    const unsigned int numFaces = mesh.getNumFaces();
+    normals.assign( numVertices, Vector3f(0,0,0) );
+
+    // the normal of a polygon by the Newell's method. Its length is twice
+    // the area of the polygon, so the larger faces weight more
+    std::vector<unsigned int> vertexIds;
+    for( unsigned int faceId=0; faceId<numFaces; ++faceId )
+    {
+        const FaceVertexRange vertices = faceVertices( mesh, faceId );
+        vertexIds.assign( vertices.begin(), vertices.end() );
+        Vector3f normal(0,0,0);
+        for( size_t i=0; i<vertexIds.size(); ++i )
+        {
+            const Vector3f a = getPosition( mesh, vertexIds[i] );
+            const Vector3f b = getPosition( mesh, vertexIds[(i+1)%vertexIds.size()] );
+            normal.x += (a.y-b.y)*(a.z+b.z);
+            normal.y += (a.z-b.z)*(a.x+b.x);
+            normal.z += (a.x-b.x)*(a.y+b.y);
+        }
+        for( size_t i=0; i<vertexIds.size(); ++i )
+        {
+            normals[ vertexIds[i] ] += normal;
+        }
+    }
+
+    for( unsigned int vertexId=0; vertexId<numVertices; ++vertexId )
+    {
+        if( normals[vertexId].length2()>0 )
+        {
+            normals[vertexId].normalize();
+        }
+    }
+}
+
+template <class MeshT>
+Vector3f WavefrontObjExporter<MeshT>::getPosition(const MeshT& mesh, unsigned int vertexId)
+{
+    return Vector3f( (float)mesh.getVertexData(vertexId).position.x,
+        (float)mesh.getVertexData(vertexId).position.y,
+        (float)mesh.getVertexData(vertexId).position.z );
+}
+
+#endif//WavefrontObjExporter_h
@@ -8,59 +8,480 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "WavefrontObjImporter.h"
-#include <fstream>
+#include "MappedFile.h"
+#include "TextScanner.h"
+#include "Parallel.h"
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 
-void WavefrontObjLoader::load( const std::string& objFile )
+namespace
+{
+    // the files smaller than two chunks are parsed by a single thread
+    const size_t minChunkSize = 1<<20;
+
+    void throwParseError(const std::string& message, const TextScanner& scanner)
+    {
+        std::stringstream str;
+        str << message << " (line " << scanner.getLineNumber() << ")";
+        throw cpp::Exception( str.str() );
+    }
+
+    /**
+    	A negative (relative) vertex reference of a face, read in a part of
+        the file whose first vertex ID is not known yet. The vertex is counted
+        from the first vertex of the part, and can be negative.
+    */
+    struct RelativeReference
+    {
+        size_t position;
+        long long vertex;
+    };
+
+    /**
+    	Reads the vertices and faces in [begin, end), appending them to the
+        given buffers. The negative face references are relative to the number
+        of vertices already in the buffer. If relativeReferences is not NULL,
+        they are stored there instead, and a 0 is put in the faces buffer.
+    */
+    void parseObjText( const char* begin, const char* end, const char* textBegin,
+        std::vector<Vector3f>& vertices, std::vector<unsigned int>& faces,
+        std::vector<RelativeReference>* relativeReferences )
+    {
+        TextScanner scanner( begin, end, textBegin );
+        while( !scanner.atEnd() )
+        {
+            scanner.skipSpaces();
+
+            // "v " is a vertex, but "vt", "vn" and "vp" are not used
+            if( scanner.skip('v') && (scanner.peek()==' ' || scanner.peek()=='\t') )
+            {
+                Vector3f position;
+                scanner.skipSpaces();
+                bool valid = scanner.readFloat(position.x);
+                scanner.skipSpaces();
+                valid = valid && scanner.readFloat(position.y);
+                scanner.skipSpaces();
+                valid = valid && scanner.readFloat(position.z);
+                if( !valid )
+                {
+                    throwParseError("Invalid vertex position", scanner);
+                }
+                vertices.push_back( position );
+            }
+            else if( scanner.skip('f') && (scanner.peek()==' ' || scanner.peek()=='\t') )
+            {
+                // each vertex is "v", "v/vt", "v//vn" or "v/vt/vn"
+                unsigned int faceVertices = 0;
+                scanner.skipSpaces();
+                while( !scanner.atEndOfLine() )
+                {
+                    int reference;
+                    if( !scanner.readInt(reference) || reference==0 )
+                    {
+                        throwParseError("Invalid vertex reference in a face", scanner);
+                    }
+                    int ignored;
+                    if( scanner.skip('/') )
+                    {
+                        scanner.readInt(ignored); // texture coordinate, may be empty
+                        if( scanner.skip('/') )
+                        {
+                            scanner.readInt(ignored); // normal
+                        }
+                    }
+
+                    if( reference>0 )
+                    {
+                        faces.push_back( reference-1 );
+                    }
+                    else
+                    {
+                        const long long vertex = (long long)vertices.size() + reference;
+                        if( relativeReferences!=NULL )
+                        {
+                            RelativeReference relative;
+                            relative.position = faces.size();
+                            relative.vertex = vertex;
+                            relativeReferences->push_back( relative );
+                            faces.push_back( 0 );
+                        }
+                        else if( vertex<0 )
+                        {
+                            throwParseError("A face references a vertex before the first one", scanner);
+                        }
+                        else
+                        {
+                            faces.push_back( (unsigned int)vertex );
+                        }
+                    }
+                    ++faceVertices;
+                    scanner.skipSpaces();
+                }
+                if( faceVertices!=3 ) //ensures only triangles are read
+                {
+                    throwParseError("This file contains other things than triangles", scanner);
+                }
+            }
+
+            // comments, groups, materials and the rest of the line are skipped
+            scanner.skipLine();
+        }
+    }
+
+    /**
+    	The vertices and faces of a part of the file, and where they go in
+        the buffers of the loader.
+    */
+    struct ObjChunk
+    {
+        const char* begin;
+        const char* end;
+        std::vector<Vector3f> vertices;
+        std::vector<unsigned int> faces;
+        std::vector<RelativeReference> relativeReferences;
+        size_t vertexOffset;
+        size_t faceOffset;
+    };
+
+    class ParseChunksTask: public ParallelTask
+    {
+    public:
+        ParseChunksTask(std::vector<ObjChunk>& chunks, const char* text):
+            chunks(chunks),
+            text(text)
+        {
+        };
+
+        virtual void run(unsigned int index)
+        {
+            ObjChunk& chunk = this->chunks[index];
+            parseObjText( chunk.begin, chunk.end, this->text, chunk.vertices, chunk.faces, &chunk.relativeReferences );
+        };
+
+    private:
+        std::vector<ObjChunk>& chunks;
+        const char* text;
+    };
+
+    class MergeChunksTask: public ParallelTask
+    {
+    public:
+        MergeChunksTask(std::vector<ObjChunk>& chunks, std::vector<Vector3f>& vertices, std::vector<unsigned int>& faces):
+            chunks(chunks),
+            vertices(vertices),
+            faces(faces)
+        {
+        };
+
+        virtual void run(unsigned int index)
+        {
+            const ObjChunk& chunk = this->chunks[index];
+            std::copy( chunk.vertices.begin(), chunk.vertices.end(), this->vertices.begin()+chunk.vertexOffset );
+            std::copy( chunk.faces.begin(), chunk.faces.end(), this->faces.begin()+chunk.faceOffset );
+
+            for( size_t i=0; i<chunk.relativeReferences.size(); ++i )
+            {
+                const RelativeReference& relative = chunk.relativeReferences[i];
+                const long long vertex = (long long)chunk.vertexOffset + relative.vertex;
+                if( vertex<0 )
+                {
+                    throw cpp::Exception("A face references a vertex before the first one");
+                }
+                this->faces[chunk.faceOffset+relative.position] = (unsigned int)vertex;
+            }
+        };
+
+    private:
+        std::vector<ObjChunk>& chunks;
+        std::vector<Vector3f>& vertices;
+        std::vector<unsigned int>& faces;
+    };
+
+    /**
+    	The end of the part of [begin, end) read at a time when streaming:
+        the end of the first line after minChunkSize characters.
+    */
+    const char* findBatchEnd( const char* begin, const char* end )
+    {
+        if( (size_t)(end-begin)<=minChunkSize )
+        {
+            return end;
+        }
+        const char* batchEnd = std::find( begin+minChunkSize, end, '\n' );
+        return batchEnd==end? end : batchEnd+1;
+    }
+
+    /**
+    	Adds to the counts the lines of [begin, end) that parseObjText reads
+        as a vertex or as a face, without parsing them.
+    */
+    void countObjElements( const char* begin, const char* end, size_t& vertexCount, size_t& faceCount )
+    {
+        const char* line = begin;
+        while( line!=end )
+        {
+            while( line!=end && (*line==' ' || *line=='\t' || *line=='\r') )
+            {
+                ++line;
+            }
+            if( end-line>=2 && (line[1]==' ' || line[1]=='\t') )
+            {
+                if( line[0]=='v' )
+                {
+                    ++vertexCount;
+                }
+                else if( line[0]=='f' )
+                {
+                    ++faceCount;
+                }
+            }
+            line = (const char*)std::memchr( line, '\n', end-line );
+            if( line==NULL )
+            {
+                break;
+            }
+            ++line;
+        }
+    }
+
+    /**
+    	The number of parts of the file that can be in memory at a time, when
+        streaming.
+    */
+    const unsigned int streamingSlots = 4;
+
+    /**
+    	The vertices and faces of a part of the file, when streaming.
+    */
+    struct ObjBatch
+    {
+        std::vector<Vector3f> vertices;
+        std::vector<unsigned int> faces;
+        std::vector<RelativeReference> relativeReferences;
+    };
+
+    /**
+    	Parses the file from the start to the end, one part at a time.
+    */
+    class ObjBatchParser: public BatchProducer
+    {
+    public:
+        ObjBatchParser(const char* begin, const char* end, MappedFile* file, std::vector<ObjBatch>& batches):
+            current(begin),
+            text(begin),
+            end(end),
+            file(file),
+            batches(batches),
+            vertexCount(0),
+            faceCount(0)
+        {
+        };
+
+        virtual bool produce(unsigned int slot)
+        {
+            if( this->current==this->end )
+            {
+                return false;
+            }
+
+            const char* batchEnd = findBatchEnd( this->current, this->end );
+            ObjBatch& batch = this->batches[slot];
+            batch.vertices.clear();
+            batch.faces.clear();
+            batch.relativeReferences.clear();
+            parseObjText( this->current, batchEnd, this->text, batch.vertices, batch.faces, &batch.relativeReferences );
+
+            // the negative references are resolved here, as the number of
+            // vertices of the previous parts is known
+            for( size_t i=0; i<batch.relativeReferences.size(); ++i )
+            {
+                const RelativeReference& relative = batch.relativeReferences[i];
+                const long long vertex = (long long)this->vertexCount + relative.vertex;
+                if( vertex<0 )
+                {
+                    throw cpp::Exception("A face references a vertex before the first one");
+                }
+                batch.faces[relative.position] = (unsigned int)vertex;
+            }
+
+            if( this->file!=NULL )
+            {
+                this->file->release( this->current-this->text, batchEnd-this->current );
+            }
+            this->vertexCount += batch.vertices.size();
+            this->faceCount += batch.faces.size()/3;
+            this->current = batchEnd;
+            return true;
+        };
+
+        inline size_t getVertexCount() const
+        {
+            return this->vertexCount;
+        };
+
+        inline size_t getFaceCount() const
+        {
+            return this->faceCount;
+        };
+
+    private:
+        const char* current;
+        const char* text;
+        const char* end;
+        MappedFile* file;
+        std::vector<ObjBatch>& batches;
+        size_t vertexCount;
+        size_t faceCount;
+    };
+
+    class ObjBatchForwarder: public BatchConsumer
+    {
+    public:
+        ObjBatchForwarder(std::vector<ObjBatch>& batches, ObjBatchReceiver& receiver):
+            batches(batches),
+            receiver(receiver)
+        {
+        };
+
+        virtual void consume(unsigned int slot)
+        {
+            this->receiver.receive( this->batches[slot].vertices, this->batches[slot].faces );
+        };
+
+    private:
+        std::vector<ObjBatch>& batches;
+        ObjBatchReceiver& receiver;
+    };
+}
+
+void WavefrontObjLoader::load( const std::string& objFile, unsigned int threadCount )
+{
+    try
+    {
+        MappedFile file;
+        file.open( objFile );
+        this->parse( file.getData(), file.getData()+file.getSize(), threadCount );
+    }
+    catch( const std::exception& e )
+    {
+        std::cerr << e.what();
+        throw;
+    }
+}
+
+void WavefrontObjLoader::parse( const char* begin, const char* end, unsigned int threadCount )
 {
     vertices.clear();
     verticeCount=0;
     faces.clear();
     faceCount=0;
 
-    std::ifstream stream;
-    try
+    if( threadCount==0 )
     {
-        stream.open( objFile.c_str(), std::ios::in );
-        if( stream )
+        threadCount = getNumCores();
+    }
+    // more chunks than threads, so a thread that ends early takes another one
+    const size_t chunkCount = std::min( (size_t)threadCount*4, (size_t)(end-begin)/minChunkSize );
+
+    if( threadCount==1 || chunkCount<=1 )
+    {
+        parseObjText( begin, end, begin, vertices, faces, NULL );
+    }
+    else
+    {
+        // each chunk starts at the beginning of a line
+        std::vector<ObjChunk> chunks( chunkCount );
+        const char* chunkBegin = begin;
+        for( size_t i=0; i<chunkCount; ++i )
         {
-            // load the obj
-            while( stream.good() )
+            const char* chunkEnd = end;
+            if( i+1<chunkCount )
             {
-                char buffer[512];
-                stream.getline(buffer, sizeof(buffer));
-                std::stringstream str(buffer);
-                std::string name;
-                str >> name;
-                if( name=="v" )
-                {
-                    Vector3f position;
-                    str >> position.x >> position.y >> position.z;
-                    vertices.push_back( position );
-                    verticeCount++;
-                }
-                else if( name=="f" )
+                chunkEnd = std::max( chunkBegin, begin + (end-begin)/chunkCount*(i+1) );
+                chunkEnd = std::find( chunkEnd, end, '\n' );
+                if( chunkEnd!=end )
                 {
-                    unsigned int a, b, c;
-                    str >> a >> b >> c;
-                    faces.push_back(a-1);
-                    faces.push_back(b-1);
-                    faces.push_back(c-1);
-                    faceCount++;
+                    ++chunkEnd;
                 }
             }
-            stream.close();
+            chunks[i].begin = chunkBegin;
+            chunks[i].end = chunkEnd;
+            chunkBegin = chunkEnd;
         }
-        else
+
+        ParseChunksTask parseTask( chunks, begin );
+        runParallel( parseTask, (unsigned int)chunkCount, threadCount );
+
+        // the place of each chunk is the sum of the sizes of the previous ones
+        size_t vertexOffset = 0;
+        size_t faceOffset = 0;
+        for( size_t i=0; i<chunkCount; ++i )
         {
-            throw cpp::Exception("Can't open the file '"+objFile+"'");
+            chunks[i].vertexOffset = vertexOffset;
+            chunks[i].faceOffset = faceOffset;
+            vertexOffset += chunks[i].vertices.size();
+            faceOffset += chunks[i].faces.size();
         }
+        vertices.resize( vertexOffset );
+        faces.resize( faceOffset );
+
+        MergeChunksTask mergeTask( chunks, vertices, faces );
+        runParallel( mergeTask, (unsigned int)chunkCount, threadCount );
+    }
+
+    verticeCount = (unsigned int)vertices.size();
+    faceCount = (unsigned int)faces.size()/3;
+}
+
+void WavefrontObjLoader::loadStreaming( const std::string& objFile, ObjBatchReceiver& receiver, bool inParallel )
+{
+    try
+    {
+        MappedFile file;
+        file.open( objFile );
+        this->stream( file.getData(), file.getData()+file.getSize(), &file, receiver, inParallel );
     }
     catch( const std::exception& e )
     {
-        if( stream.is_open() )
-            stream.close();
         std::cerr << e.what();
         throw;
     }
 }
+
+void WavefrontObjLoader::parseStreaming( const char* begin, const char* end, ObjBatchReceiver& receiver, bool inParallel )
+{
+    this->stream( begin, end, NULL, receiver, inParallel );
+}
+
+void WavefrontObjLoader::stream( const char* begin, const char* end, MappedFile* file, ObjBatchReceiver& receiver, bool inParallel )
+{
+    vertices.clear();
+    verticeCount=0;
+    faces.clear();
+    faceCount=0;
+
+    // counted in the same parts as they are parsed, so the pages of the
+    // file can be released while they are counted
+    size_t vertexLines = 0;
+    size_t faceLines = 0;
+    for( const char* part=begin; part!=end; )
+    {
+        const char* partEnd = findBatchEnd( part, end );
+        countObjElements( part, partEnd, vertexLines, faceLines );
+        if( file!=NULL )
+        {
+            file->release( part-begin, partEnd-part );
+        }
+        part = partEnd;
+    }
+    receiver.begin( (unsigned int)vertexLines, (unsigned int)faceLines );
+
+    std::vector<ObjBatch> batches( streamingSlots );
+    ObjBatchParser parser( begin, end, file, batches );
+    ObjBatchForwarder forwarder( batches, receiver );
+    runPipeline( parser, forwarder, streamingSlots, inParallel );
+
+    verticeCount = (unsigned int)parser.getVertexCount();
+    faceCount = (unsigned int)parser.getFaceCount();
+}
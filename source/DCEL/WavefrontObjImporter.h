@@ -11,20 +11,238 @@
 #define WavefrontObjImporter_h
 
 #include "DCELStream.h"
+#include "ImportOptions.h"
 #include "Vector3.h"
 
+class MappedFile;
+
+/**
+	Receives the vertices and faces read by WavefrontObjLoader::loadStreaming,
+    in batches that follow the order of the file. The vertex IDs of the faces
+    count from the first vertex of the file, not of the batch.
+*/
+class ObjBatchReceiver
+{
+public:
+
+    virtual ~ObjBatchReceiver()
+    {
+    };
+
+    /**
+    	Called before the first batch, with the number of vertices and faces
+        of the whole file (from a quick count of its lines).
+    */
+    virtual void begin( unsigned int vertexCount, unsigned int faceCount ) = 0;
+
+    virtual void receive( const std::vector<Vector3f>& vertices, const std::vector<unsigned int>& faces ) = 0;
+};
+
+/**
+	This class is used internally by the WavefrontObjImporter.
+
+    It loads the vertex positions into the "vertices" buffer and the faces into
+    the "faces" buffer, three vertex IDs for each triangle. The buffers are only
+    cleared (not released) at each load, so a loader that is reused for several
+    files doesn't allocate them again.
+
+    The file is mapped in memory and parsed in place, so there is no limit in
+    the size of its lines. Faces can use the "v", "v/vt", "v//vn" and "v/vt/vn"
+    syntax (only the vertex is used), and must be triangles. A cpp::Exception
+    with the line number is thrown for an invalid file.
+
+    With more than one thread, the file is split at line boundaries in chunks
+    that are parsed in parallel, and then copied in order to the buffers. The
+    result is the same for any number of threads.
+*/
 class WavefrontObjLoader
 {
 public:
 
-    void load( const std::string& objFile );
+    /**
+    	Loads the file using up to threadCount threads (0 uses one per core).
+    */
+    void load( const std::string& objFile, unsigned int threadCount = 1 );
 
-    std::list<Vector3f> vertices;
+    /**
+    	Loads the OBJ text in [begin, end), that doesn't need to end with a '\0'.
+    */
+    void parse( const char* begin, const char* end, unsigned int threadCount = 1 );
+
+    /**
+    	Reads the file in parts of about 1MB, and gives the vertices and faces
+        of each part to the receiver instead of keeping them in the buffers,
+        which are left empty. Only a few parts are in memory at a time, and
+        the pages of the file are released after they are read. The lines
+        are counted before, for ObjBatchReceiver::begin.
+
+        With inParallel, the receiver runs in another thread, while the next
+        parts are read. The counts are set to the totals of the file.
+    */
+    void loadStreaming( const std::string& objFile, ObjBatchReceiver& receiver, bool inParallel = true );
+
+    void parseStreaming( const char* begin, const char* end, ObjBatchReceiver& receiver, bool inParallel = true );
+
+    std::vector<Vector3f> vertices;
     unsigned int verticeCount;
-    std::list<unsigned int> faces;
+    std::vector<unsigned int> faces;
     unsigned int faceCount;
 protected:
 private:
+
+    /**
+    	Used by loadStreaming and parseStreaming. If file is not NULL, the
+        text is its data, and its pages are released as they are read.
+    */
+    void stream( const char* begin, const char* end, MappedFile* file, ObjBatchReceiver& receiver, bool inParallel );
+};
+
+/**
+	Used internally by the WavefrontObjImporter, when streaming: creates the
+    vertices and the faces of the mesh as the batches arrive, with
+    Mesh::addTriangles, and links the borders in finish().
+
+    With VALIDATION_PER_FACE, the faces are inserted with
+    createTriangularFace instead, that delays the ones that are ambiguous
+    until manageUnhandledTriangles. In both cases, a face that uses a vertex
+    from a later batch is kept until finish().
+*/
+template <class MeshT>
+class ObjMeshBuilder: public ObjBatchReceiver
+{
+public:
+    ObjMeshBuilder( MeshT& mesh, const ImportOptions& options ):
+        mesh(mesh),
+        options(options),
+        dirtyTrackingEnabled(mesh.isDirtyTrackingEnabled())
+    {
+        if( options.validation==VALIDATION_PER_FACE )
+        {
+            this->mesh.setDirtyTrackingEnabled( true );
+        }
+    };
+
+    /**
+    	Restores the dirty tracking of the mesh, also when the import fails.
+    */
+    ~ObjMeshBuilder()
+    {
+        this->mesh.setDirtyTrackingEnabled( this->dirtyTrackingEnabled );
+    };
+
+    virtual void begin( unsigned int vertexCount, unsigned int faceCount )
+    {
+        // with the PointerStorage, no reallocation can happen after the
+        // first face. Each triangle adds at most 3 edges
+        this->mesh.reserve( vertexCount, 6*faceCount, faceCount );
+        if( this->options.validation!=VALIDATION_PER_FACE )
+        {
+            this->mesh.beginTriangles( faceCount );
+        }
+    };
+
+    virtual void receive( const std::vector<Vector3f>& vertices, const std::vector<unsigned int>& faces )
+    {
+        for( size_t i=0; i<vertices.size(); ++i )
+        {
+            unsigned int id = this->mesh.createVertex();
+            this->mesh.getVertexData(id).position = vertices[i];
+        }
+
+        // the triangles are inserted in runs, between the ones that are kept
+        const unsigned int numVertices = this->mesh.getNumVertices();
+        size_t first = 0;
+        for( size_t t=0; t+2<faces.size(); t+=3 )
+        {
+            if( faces[t]>=numVertices || faces[t+1]>=numVertices || faces[t+2]>=numVertices )
+            {
+                this->insertTriangles( faces, first, t );
+                this->laterFaces.insert( this->laterFaces.end(), &faces[t], &faces[t]+3 );
+                first = t+3;
+            }
+        }
+        this->insertTriangles( faces, first, faces.size()-faces.size()%3 );
+    };
+
+    /**
+    	Inserts the faces that were kept, and checks the mesh as asked by the
+        options.
+    */
+    void finish()
+    {
+        if( this->options.validation!=VALIDATION_PER_FACE )
+        {
+            if( !this->laterFaces.empty() )
+            {
+                this->mesh.addTriangles( &this->laterFaces[0], this->laterFaces.size()/3 );
+            }
+            std::vector<unsigned int>().swap( this->laterFaces );
+            this->mesh.endTriangles();
+            checkImportedMesh( this->mesh, this->options );
+            return;
+        }
+
+        const unsigned int numVertices = this->mesh.getNumVertices();
+        for( size_t t=0; t+2<this->laterFaces.size(); t+=3 )
+        {
+            const unsigned int* triangle = &this->laterFaces[t];
+            if( triangle[0]>=numVertices || triangle[1]>=numVertices || triangle[2]>=numVertices )
+            {
+                throw cpp::Exception("A triangle references a vertex that does not exist");
+            }
+            this->insertTriangle( triangle );
+        }
+        std::vector<unsigned int>().swap( this->laterFaces );
+
+        std::cerr << "  + " << this->mesh.getNumUnhandledTriangles() << " delayed triangles" << std::endl;
+        this->mesh.manageUnhandledTriangles();
+        this->mesh.setDirtyTrackingEnabled( this->dirtyTrackingEnabled );
+        checkImportedMesh( this->mesh, this->options );
+    };
+
+private:
+
+    /**
+    	Inserts the triangles from faces[first] to faces[last] (not included).
+    */
+    void insertTriangles( const std::vector<unsigned int>& faces, size_t first, size_t last )
+    {
+        if( first==last )
+        {
+            return;
+        }
+        if( this->options.validation!=VALIDATION_PER_FACE )
+        {
+            this->mesh.addTriangles( &faces[first], (last-first)/3 );
+            return;
+        }
+        for( size_t t=first; t<last; t+=3 )
+        {
+            this->insertTriangle( &faces[t] );
+        }
+    };
+
+    void insertTriangle( const unsigned int* triangle )
+    {
+        if( triangle[0]==triangle[1] || triangle[1]==triangle[2] || triangle[2]==triangle[0] )
+        {
+            throw cpp::Exception("A triangle cannot use the same vertex twice");
+        }
+        const unsigned int faceId = this->mesh.createTriangularFace( triangle[0], triangle[1], triangle[2] );
+        if( faceId!=MESH_NULL_ID )
+        {
+            ValidationReport report;
+            this->mesh.validateDirty( report );
+            report.throwIfInvalid();
+        }
+    };
+
+    MeshT& mesh;
+    const ImportOptions& options;
+    bool dirtyTrackingEnabled;
+
+    // the triangles that were not inserted yet
+    std::vector<unsigned int> laterFaces;
 };
 
 /**
@@ -41,65 +259,62 @@ public:
         Loads from the given filename.
 
         It just calls the 'import' method with the opened stream.
+
+        The options define how the mesh is checked after (or while) it is built.
+        With options.streaming, the vertices and faces are created while the
+        file is read (see ImportOptions::streaming).
     */
-    void import( const std::string& objFile, MeshT& mesh);
+    void import( const std::string& objFile, MeshT& mesh, const ImportOptions& options = ImportOptions() );
+
+    void import( const std::vector<Vector3f>& vertices, unsigned int verticeCount, const std::vector<unsigned int>& faces, unsigned int faceCount, MeshT& mesh, const ImportOptions& options = ImportOptions() );
 
-    void import( std::list<Vector3f>& vertices, unsigned int verticeCount, std::list<unsigned int>& faces, unsigned int faceCount, MeshT& mesh);
+private:
+
+    // kept between imports, to reuse its buffers
+    WavefrontObjLoader loader;
 };
 
 template <class MeshT>
-void WavefrontObjImporter<MeshT>::import( const std::string& objFilename, MeshT& mesh )
+void WavefrontObjImporter<MeshT>::import( const std::string& objFilename, MeshT& mesh, const ImportOptions& options )
 {
     std::cerr << "Starting importing the file '" << objFilename << "'" << std::endl;
 
+    if( options.streaming )
+    {
+        std::cerr << "- streaming the OBJ file into the DCEL mesh" << std::endl;
+        mesh.clear();
+        ObjMeshBuilder<MeshT> builder( mesh, options );
+        loader.loadStreaming( objFilename, builder, options.threadCount!=1 );
+        std::cerr << "  + " << loader.verticeCount << " vertices" << std::endl;
+        std::cerr << "  + " << loader.faceCount << " faces" << std::endl;
+        builder.finish();
+        std::cerr << "Done!" << std::endl;
+        return;
+    }
+
     std::cerr << "- loading the OBJ file" << std::endl;
-    WavefrontObjLoader loader;
-    loader.load(objFilename);
+    loader.load(objFilename, options.threadCount);
 
-    import(loader.vertices, loader.verticeCount, loader.faces, loader.faceCount, mesh);
+    import(loader.vertices, loader.verticeCount, loader.faces, loader.faceCount, mesh, options);
 
 }
 
 template <class MeshT>
-void WavefrontObjImporter<MeshT>::import( std::list<Vector3f>& vertices, unsigned int verticeCount, std::list<unsigned int>& faces, unsigned int faceCount, MeshT& mesh)
+void WavefrontObjImporter<MeshT>::import( const std::vector<Vector3f>& vertices, unsigned int verticeCount, const std::vector<unsigned int>& faces, unsigned int faceCount, MeshT& mesh, const ImportOptions& options )
 {
     // put it into the mesh
     std::cerr << "- loading the DCEL mesh: " << std::endl;
     std::cerr << "  + " << verticeCount << " vertices" << std::endl;
     mesh.clear();
-    mesh.getVertices().reserve(verticeCount);
-    mesh.getFaces().reserve(faceCount);
-    //mesh.getEdges().reserve( 2*(verticeCount+faceCount) ); // Euler: V  A + F = 2 --> A = V + F - 2
-    mesh.getHalfEdges().reserve( 2*(3*faceCount) ); // just a good expensive number of edges =)
-    std::list<Vector3f>::iterator vit = vertices.begin();
-    while( vit!=vertices.end() )
+    mesh.reserve(verticeCount, 0, 0);
+    for( size_t i=0; i<vertices.size(); ++i )
     {
         unsigned int id = mesh.createVertex();
-        mesh.getVertex(id)->getData().position = *vit;
-        vit++;
+        mesh.getVertexData(id).position = vertices[i];
     }
 
     std::cerr << "  + " << faceCount << " faces" << std::endl; 
-    std::list<unsigned int>::iterator fit = faces.begin();
-    unsigned int count=0;
-    while( fit!=faces.end() )
-    {
-        count++;
-        unsigned int a = *fit; ++fit;
-        unsigned int b = *fit; ++fit;
-        unsigned int c = *fit; ++fit;
-        unsigned int fid = mesh.createTriangularFace( a, b, c );
-        if (fid!=-1)
-        {
-            //std::cout << a << ' ' << b << ' ' << c << std::endl;
-            mesh.checkFace(fid);
-            mesh.checkAllFaces();
-        }
-    }
-
-    std::cerr << "  + " << mesh.getNumUnhandledTriangles() << " bad triangles" << std::endl;
-    mesh.manageUnhandledTriangles();
-    mesh.checkAllFaces();
+    buildImportedMesh( mesh, faces.empty()? NULL : &faces[0], faceCount, options );
 
     std::cerr << "Done!" << std::endl;
 }
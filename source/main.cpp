@@ -142,8 +142,12 @@ typedef Mesh<VertexData, HalfEdgeData, FaceData> MyMesh;
 	Although MyMesh and MyMeshUsingVector have the same structure, they are not
 	interchangeable. They are different objects! But you can use 
 	the DCELStream::copyDcelData() method to convert between different mesh types.
+
+	This one also uses the IndexStorage: its vertices, half-edges and faces store 
+	the IDs of each other, instead of pointers. The methods that work with IDs and
+	the getData() of each element are the same, but there is no EdgeIterator.
 */
-typedef Mesh<VertexDataWithPosition, HalfEdgeData, FaceData> MyMeshUsingVector;
+typedef Mesh<VertexDataWithPosition, HalfEdgeData, FaceData, IndexStorage> MyMeshUsingVector;
 
 
 /**
@@ -295,6 +299,19 @@ void doSomeStuffWithMesh(MyMesh* mesh)
 	}
 	std::cout << std::endl << std::endl;
 
+	/**
+	    Data that is needed only by some parts of the program can be kept in an 
+		attribute of the mesh, instead of the VertexData. An attribute is an array
+		with one value per vertex (or half-edge, or face), identified by a name.
+		Here I'll count the half-edges that start at each vertex.
+	*/
+	AttributeChannel<unsigned int>& valence = mesh->getVertexAttributes().add<unsigned int>( "valence", 0 );
+	for (unsigned int i=0; i<mesh->getNumHalfEdges(); ++i)
+	{
+		valence[ mesh->getHalfEdgeOrigin(i) ]++;
+	}
+	std::cout << "The vertex 0 has " << valence[0] << " neighbors." << std::endl << std::endl;
+
 	/**
 	    Iterate over the edges that composes the face 1 (the one composed by
 		the vertices 0, 2, 3). For each edge, will show its start vertex ID,